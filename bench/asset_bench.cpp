@@ -0,0 +1,142 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "engine/loader.h"
+#include "engine/shader.h"
+#include "tiny_gltf.h"
+
+using meddl::loader::ModelLoadFlags;
+
+namespace {
+//! Flat grid of quads with positions, normals, uvs and 32 bit indices, written as .gltf + .bin
+//! Generated so the benchmark needs no assets and always loads the same bytes
+std::filesystem::path write_grid_gltf(const std::filesystem::path& dir, uint32_t quads)
+{
+   const uint32_t side = quads + 1;
+   std::vector<float> positions;
+   std::vector<float> normals;
+   std::vector<float> uvs;
+   std::vector<uint32_t> indices;
+   for (uint32_t y = 0; y < side; y++) {
+      for (uint32_t x = 0; x < side; x++) {
+         const float u = static_cast<float>(x) / static_cast<float>(quads);
+         const float v = static_cast<float>(y) / static_cast<float>(quads);
+         positions.insert(positions.end(), {u - 0.5f, 0.0f, v - 0.5f});
+         normals.insert(normals.end(), {0.0f, 1.0f, 0.0f});
+         uvs.insert(uvs.end(), {u, v});
+      }
+   }
+   for (uint32_t y = 0; y < quads; y++) {
+      for (uint32_t x = 0; x < quads; x++) {
+         const uint32_t i = y * side + x;
+         indices.insert(indices.end(), {i, i + side, i + 1, i + 1, i + side, i + side + 1});
+      }
+   }
+
+   std::ofstream bin(dir / "grid.bin", std::ios::binary);
+   std::string views;
+   std::string accessors;
+   size_t offset = 0;
+   uint32_t view = 0;
+   const auto add = [&](const auto& data, uint32_t component, size_t count, const char* type) {
+      const size_t bytes = data.size() * sizeof(data[0]);
+      bin.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(bytes));
+      views += std::format(R"({}{{"buffer":0,"byteOffset":{},"byteLength":{}}})",
+                           views.empty() ? "" : ",",
+                           offset,
+                           bytes);
+      accessors += std::format(R"({}{{"bufferView":{},"componentType":{},"count":{},"type":"{}"}})",
+                               accessors.empty() ? "" : ",",
+                               view,
+                               component,
+                               count,
+                               type);
+      offset += bytes;
+      view++;
+   };
+   constexpr uint32_t FLOAT = 5126;
+   constexpr uint32_t UNSIGNED_INT = 5125;
+   const size_t vertex_count = static_cast<size_t>(side) * side;
+   add(positions, FLOAT, vertex_count, "VEC3");
+   add(normals, FLOAT, vertex_count, "VEC3");
+   add(uvs, FLOAT, vertex_count, "VEC2");
+   add(indices, UNSIGNED_INT, indices.size(), "SCALAR");
+
+   const auto path = dir / "grid.gltf";
+   std::ofstream(path) << std::format(
+       R"({{"asset":{{"version":"2.0"}},"scene":0,"scenes":[{{"nodes":[0]}}],)"
+       R"("nodes":[{{"mesh":0}}],"meshes":[{{"name":"grid","primitives":[{{)"
+       R"("attributes":{{"POSITION":0,"NORMAL":1,"TEXCOORD_0":2}},"indices":3}}]}}],)"
+       R"("buffers":[{{"uri":"grid.bin","byteLength":{}}}],)"
+       R"("bufferViews":[{}],"accessors":[{}]}})",
+       offset,
+       views,
+       accessors);
+   return path;
+}
+}  // namespace
+
+// because of catch2
+// NOLINTBEGIN (cppcoreguidelines-avoid-do-while)
+TEST_CASE("glTF load", "[bench][loader]")
+{
+   const auto dir = std::filesystem::temp_directory_path() / "meddl_bench";
+   std::filesystem::create_directories(dir);
+   // 65k vertices, 131k triangles
+   const auto path = write_grid_gltf(dir, 255);
+
+   // The difference between parse and load is the conversion to meddl::Vertex
+   BENCHMARK("parse only")
+   {
+      tinygltf::TinyGLTF loader;
+      tinygltf::Model model;
+      std::string err;
+      std::string warn;
+      return loader.LoadASCIIFromFile(&model, &err, &warn, path.string());
+   };
+
+   BENCHMARK("load meshes")
+   {
+      return meddl::loader::load_model(path, ModelLoadFlags::Meshes);
+   };
+
+   BENCHMARK("load full")
+   {
+      return meddl::loader::load_model(path, ModelLoadFlags::Full);
+   };
+
+   auto model = meddl::loader::load_model(path, ModelLoadFlags::Meshes);
+   REQUIRE(model);
+   REQUIRE(model->meshes.at(0).vertices.size() == 256 * 256);
+   BENCHMARK("flatten meshes into one vertex and index stream")
+   {
+      std::vector<meddl::Vertex> vertices;
+      std::vector<uint32_t> indices;
+      for (const auto& mesh : model->meshes) {
+         const auto vertex_offset = static_cast<uint32_t>(vertices.size());
+         vertices.insert(vertices.end(), mesh.vertices.begin(), mesh.vertices.end());
+         for (uint32_t index : mesh.indices) {
+            indices.push_back(vertex_offset + index);
+         }
+      }
+      return vertices.size() + indices.size();
+   };
+}
+
+TEST_CASE("Shader compile", "[bench][shader]")
+{
+   // Cold, GLSL to SPIR-V every time. Creating a module from cached SPIR-V is in render_bench
+   const auto path = std::filesystem::current_path() / "shader.vert";
+   REQUIRE(meddl::engine::loader::compile_shader_file(path));
+   BENCHMARK("compile shader.vert")
+   {
+      return meddl::engine::loader::compile_shader_file(path);
+   };
+}
+// NOLINTEND
@@ -0,0 +1,120 @@
+#include <atomic>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <latch>
+
+#include "core/async.h"
+#include "engine/events/dispatcher.h"
+#include "engine/events/event.h"
+#include "engine/events/event_queue.h"
+
+using meddl::async::PoolType;
+using meddl::async::ThreadPoolManager;
+using namespace meddl::events;
+
+// because of catch2
+// NOLINTBEGIN (cppcoreguidelines-avoid-do-while)
+TEST_CASE("Event dispatch", "[bench][events]")
+{
+   EventHandler handler;
+   uint64_t handled = 0;
+   const auto count = [&handled](const Event&) {
+      handled++;
+      return true;
+   };
+   // A specific key and its wildcard, next to subscribers of other types like a game would have
+   handler.subscribe(KeyPressed{.keycode = Key::W}, count);
+   handler.subscribe(EventType::KeyPressed, count);
+   handler.subscribe(EventType::MouseMoved, count);
+   for (auto type : {EventType::KeyReleased,
+                     EventType::MouseButtonPressed,
+                     EventType::MouseScrolled,
+                     EventType::WindowResize,
+                     EventType::WindowClose}) {
+      handler.subscribe(type, count);
+   }
+
+   Event key = Event(KeyPressed{.keycode = Key::W});
+   BENCHMARK("EventHandler: dispatch key with wildcard")
+   {
+      handler.dispatch(key);
+      return handled;
+   };
+
+   BENCHMARK("EventHandler: create and dispatch 1000 mouse moves")
+   {
+      for (int i = 0; i < 1000; i++) {
+         auto moved = Event(MouseMoved{.x = static_cast<float>(i), .y = 1.0f});
+         handler.dispatch(moved);
+      }
+      return handled;
+   };
+
+   // Same subscribers on the typed dispatcher
+   EventDispatcher dispatcher;
+   const auto count_typed = [&handled](const auto&) {
+      handled++;
+      return true;
+   };
+   dispatcher.subscribe(KeyPressed{.keycode = Key::W}, count_typed);
+   dispatcher.subscribe<KeyPressed>(count_typed);
+   dispatcher.subscribe<MouseMoved>(count_typed);
+   dispatcher.subscribe<KeyReleased>(count_typed);
+   dispatcher.subscribe<MouseButtonPressed>(count_typed);
+   dispatcher.subscribe<MouseScrolled>(count_typed);
+   dispatcher.subscribe<WindowResize>(count_typed);
+   dispatcher.subscribe<WindowClose>(count_typed);
+
+   const KeyPressed typed_key{.keycode = Key::W};
+   BENCHMARK("EventDispatcher: dispatch key with wildcard")
+   {
+      dispatcher.dispatch(typed_key);
+      return handled;
+   };
+
+   BENCHMARK("EventDispatcher: dispatch 1000 mouse moves")
+   {
+      for (int i = 0; i < 1000; i++) {
+         dispatcher.dispatch(MouseMoved{.x = static_cast<float>(i), .y = 1.0f});
+      }
+      return handled;
+   };
+
+   EventQueue queue(1024);
+   BENCHMARK("EventQueue: queue 1000 mouse moves, drain into dispatcher")
+   {
+      for (int i = 0; i < 1000; i++) {
+         queue.push(MouseMoved{.x = static_cast<float>(i), .y = 1.0f});
+      }
+      queue.drain(dispatcher);
+      return handled;
+   };
+}
+
+TEST_CASE("Thread pool throughput", "[bench][async]")
+{
+   constexpr int TASKS = 1000;
+   auto& manager = ThreadPoolManager::instance();
+   manager.reset();
+
+   std::atomic<uint64_t> sum{0};
+   BENCHMARK("1000 tasks on the general pool")
+   {
+      std::latch done(TASKS);
+      for (int i = 0; i < TASKS; i++) {
+         stdexec::start_detached(manager.task(PoolType::General, "bench", [&sum, &done, i] {
+            sum.fetch_add(i, std::memory_order_relaxed);
+            done.count_down();
+         }));
+      }
+      done.wait();
+      return sum.load();
+   };
+
+   BENCHMARK("task round trip")
+   {
+      return stdexec::sync_wait(manager.task(PoolType::General, "bench", [] { return 1; }));
+   };
+}
+// NOLINTEND
@@ -0,0 +1,252 @@
+#include <vulkan/vulkan_core.h>
+
+#include <array>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "engine/gpu_types.h"
+#include "engine/renderer.h"
+#include "engine/shader.h"
+#include "glm/gtc/matrix_transform.hpp"
+
+using meddl::render::Renderer;
+namespace vk = meddl::render::vk;
+
+namespace {
+constexpr uint32_t WIDTH = 256;
+constexpr uint32_t HEIGHT = 256;
+
+std::vector<meddl::Vertex> make_vertices(size_t count)
+{
+   std::vector<meddl::Vertex> vertices(count);
+   for (size_t i = 0; i < count; i++) {
+      const auto f = static_cast<float>(i % 3);
+      vertices[i] = {.position = {f * 0.1f - 0.1f, f * 0.1f, 0.0f},
+                     .color = {1.0f, 1.0f, 1.0f, 1.0f},
+                     .normal = {0.0f, 0.0f, 1.0f},
+                     .uv = {f * 0.5f, 0.0f},
+                     .tangent = {1.0f, 0.0f, 0.0f, 1.0f}};
+   }
+   return vertices;
+}
+
+meddl::ImageData make_image(uint32_t size, bool mipmaps)
+{
+   meddl::ImageData image;
+   image.width = size;
+   image.height = size;
+   image.channels = 4;
+   image.generate_mipmaps = mipmaps;
+   image.pixels.resize(static_cast<size_t>(size) * size * 4);
+   for (size_t i = 0; i < image.pixels.size(); i++) {
+      image.pixels[i] = static_cast<uint8_t>(i * 31);
+   }
+   return image;
+}
+
+std::vector<glm::mat4> make_transforms(size_t count)
+{
+   std::vector<glm::mat4> transforms(count);
+   for (size_t i = 0; i < count; i++) {
+      const auto x = static_cast<float>(i % 32) / 16.0f - 1.0f;
+      const auto y = static_cast<float>(i / 32) / 16.0f - 1.0f;
+      transforms[i] = glm::translate(glm::mat4(1.0f), glm::vec3(x, y, 0.0f));
+   }
+   return transforms;
+}
+}  // namespace
+
+// because of catch2
+// NOLINTBEGIN (cppcoreguidelines-avoid-do-while)
+TEST_CASE("Uploads", "[bench][gpu][upload]")
+{
+   auto renderer = Renderer::headless(WIDTH, HEIGHT);
+   auto* device = renderer.device();
+
+   // Staging buffer, device local buffer and a blocking Buffer::copy_from
+   const auto vertices = make_vertices(65536);
+   BENCHMARK("set_vertices 64k vertices")
+   {
+      renderer.set_vertices(vertices);
+   };
+
+   const auto image = make_image(512, false);
+   BENCHMARK("texture 512x512 RGBA8")
+   {
+      return vk::Texture::create(device, image);
+   };
+
+   const auto mipmapped = make_image(512, true);
+   BENCHMARK("texture 512x512 RGBA8 with mipmaps")
+   {
+      return vk::Texture::create(device, mipmapped);
+   };
+
+   // What a SPIR-V cache hit costs, against compiling from GLSL in asset_bench
+   const auto spirv = meddl::engine::loader::compile_shader_file(
+       std::filesystem::current_path() / "shader.vert");
+   REQUIRE(spirv);
+   BENCHMARK("shader module from cached SPIR-V")
+   {
+      return std::make_unique<vk::ShaderModule>(device, spirv->spirv_code);
+   };
+}
+
+// Recording cost on the CPU of three ways to hand per draw data to shaders, see
+// DrawPushConstants. Nothing is drawn, so no pipeline or render pass is needed
+TEST_CASE("Per draw data", "[bench][gpu][per_draw]")
+{
+   constexpr uint32_t DRAWS = 1000;
+   auto renderer = Renderer::headless(WIDTH, HEIGHT);
+   auto* device = renderer.device();
+
+   auto pool = vk::CommandPool::create(device,
+                                       device->queue(vk::QueueFamilyType::Graphics).family_index(),
+                                       VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
+   REQUIRE(pool);
+   auto cmd = vk::CommandBuffer::create(device, &pool.value());
+   REQUIRE(cmd);
+
+   vk::GraphicsConfiguration::DescriptorSetLayoutConfiguration ubo_config = {
+       .bindings = {{.binding = 0,
+                     .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                     .descriptorCount = 1,
+                     .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+                     .pImmutableSamplers = nullptr}}};
+   auto dynamic_config = ubo_config;
+   dynamic_config.bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+   vk::DescriptorSetLayout ubo_layout(device, ubo_config);
+   vk::DescriptorSetLayout dynamic_layout(device, dynamic_config);
+
+   const auto range =
+       vk::push_constant_range<meddl::DrawPushConstants>(VK_SHADER_STAGE_VERTEX_BIT);
+   auto push_layout = vk::PipelineLayout::create(device, &dynamic_layout, std::span(&range, 1));
+   auto ubo_pipeline_layout = vk::PipelineLayout::create(device, &ubo_layout);
+   REQUIRE(push_layout);
+   REQUIRE(ubo_pipeline_layout);
+
+   auto frames = vk::FrameAllocator::create(device, 1024 * 1024, 1);
+   auto static_descriptors = vk::DescriptorAllocator::create(device);
+   auto per_draw_descriptors = vk::DescriptorAllocator::create(device);
+   REQUIRE(frames);
+   REQUIRE(static_descriptors);
+   REQUIRE(per_draw_descriptors);
+
+   const std::array<vk::DescriptorBinding, 1> dynamic_binding = {
+       vk::DescriptorBinding{.binding = 0,
+                             .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+                             .buffer = frames->buffer(),
+                             .offset = 0,
+                             .range = sizeof(meddl::DrawPushConstants)}};
+   auto dynamic_set = static_descriptors->get(&dynamic_layout, dynamic_binding);
+   REQUIRE(dynamic_set);
+
+   std::vector<meddl::DrawPushConstants> draws(DRAWS);
+   const auto transforms = make_transforms(DRAWS);
+   for (uint32_t i = 0; i < DRAWS; i++) {
+      draws[i].model = transforms[i];
+      draws[i].material_id = i % 16;
+   }
+
+   const auto record = [&](auto&& per_draw) {
+      cmd->reset();
+      cmd->begin();
+      for (uint32_t i = 0; i < DRAWS; i++) {
+         per_draw(i);
+      }
+      cmd->end();
+   };
+
+   BENCHMARK("1000 draws, push constants")
+   {
+      record([&](uint32_t i) {
+         cmd->push_constants(push_layout.value(), VK_SHADER_STAGE_VERTEX_BIT, draws[i]);
+      });
+   };
+
+   BENCHMARK("1000 draws, dynamic UBO offsets")
+   {
+      frames->begin_frame(0);
+      record([&](uint32_t i) {
+         const auto offset = frames->push(draws[i]);
+         vkCmdBindDescriptorSets(cmd->vk(),
+                                 VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                 push_layout->vk(),
+                                 0,
+                                 1,
+                                 &dynamic_set.value(),
+                                 1,
+                                 &offset.value());
+      });
+   };
+
+   BENCHMARK("1000 draws, descriptor set per draw")
+   {
+      frames->begin_frame(0);
+      per_draw_descriptors->reset();
+      record([&](uint32_t i) {
+         auto allocation = frames->allocate(sizeof(meddl::DrawPushConstants));
+         std::memcpy(allocation->data, &draws[i], sizeof(meddl::DrawPushConstants));
+         const std::array<vk::DescriptorBinding, 1> binding = {
+             vk::DescriptorBinding{.binding = 0,
+                                   .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                                   .buffer = frames->buffer(),
+                                   .offset = allocation->offset,
+                                   .range = sizeof(meddl::DrawPushConstants)}};
+         auto set = per_draw_descriptors->get(&ubo_layout, binding);
+         vkCmdBindDescriptorSets(cmd->vk(),
+                                 VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                 ubo_pipeline_layout->vk(),
+                                 0,
+                                 1,
+                                 &set.value(),
+                                 0,
+                                 nullptr);
+      });
+   };
+}
+
+TEST_CASE("Headless frames", "[bench][gpu][frame]")
+{
+   constexpr int FRAMES = 60;
+
+   SECTION("Test triangle")
+   {
+      auto renderer = Renderer::headless(WIDTH, HEIGHT);
+      BENCHMARK("60 frames")
+      {
+         for (int i = 0; i < FRAMES; i++) {
+            renderer.draw();
+         }
+         return renderer.read_frame().pixels.size();
+      };
+   }
+
+   SECTION("Instanced")
+   {
+      const auto vertices = make_vertices(3);
+      const auto transforms = make_transforms(1024);
+      for (bool render_thread : {false, true}) {
+         meddl::render::render_config config;
+         config.render_thread = render_thread;
+         auto renderer = Renderer::headless(WIDTH, HEIGHT, config);
+         renderer.set_vertices(vertices);
+         BENCHMARK(render_thread ? "60 frames, 1024 instances, render thread"
+                                 : "60 frames, 1024 instances")
+         {
+            for (int i = 0; i < FRAMES; i++) {
+               renderer.draw_instanced(transforms);
+               renderer.draw();
+            }
+            return renderer.read_frame().pixels.size();
+         };
+      }
+   }
+}
+// NOLINTEND
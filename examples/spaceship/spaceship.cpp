@@ -1,7 +1,4 @@
 
-#include <chrono>
-#include <thread>
-
 #include "GLFW/glfw3.h"
 #include "engine/events/event.h"
 #include "engine/loader.h"
@@ -51,15 +48,16 @@ int main()
                                 glm::vec3(0.0f, 1.0f, 0.0f)   // Up vector
    );
    renderer.set_view_matrix(view);
-   constexpr auto framerate = 16;
    uint64_t counter{0};
    renderer.set_textures(*model);
+   renderer.set_materials(*model);
    while (true) {
+      // Paced by the swapchain, input is sampled once the next frame can start
+      renderer.wait_for_frame();
       renderer.window()->poll_events();
       renderer.set_vertices(all_vertices);
       renderer.set_indices(all_indices);
       renderer.draw();
-      std::this_thread::sleep_for(std::chrono::milliseconds(framerate));
       counter++;
    }
    return 0;
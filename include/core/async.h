@@ -1,14 +1,124 @@
 #pragma once
 
+#include <exception>
 #include <exec/static_thread_pool.hpp>
 #include <memory>
 #include <stdexec/execution.hpp>
 #include <string>
 #include <unordered_map>
+#include <utility>
+
+#include "core/metrics.h"
+#include "core/trace.h"
 
 namespace meddl::async {
 
 enum class PoolType { Rendering, Compute, IO, General };
+
+//! Scheduler of a pool that counts its work in the pool's "pool.<type>.queued" gauge, from the
+//! start of a schedule() sender until a thread of the pool picks it up
+class CountedScheduler {
+  public:
+   using Inner = decltype(std::declval<exec::static_thread_pool>().get_scheduler());
+
+   template <typename Receiver>
+   class Operation {
+     public:
+      using operation_state_concept = stdexec::operation_state_t;
+
+      Operation(Inner inner, metrics::Gauge* queued, Receiver receiver)
+          : _queued(queued),
+            _receiver(std::move(receiver)),
+            _operation(stdexec::connect(stdexec::schedule(inner), Forward{this}))
+      {
+      }
+      Operation(const Operation&) = delete;
+      Operation& operator=(const Operation&) = delete;
+
+      void start() & noexcept
+      {
+         _queued->add(1.0);
+         stdexec::start(_operation);
+      }
+
+     private:
+      //! Leaves the queue, then completes the outer receiver
+      struct Forward {
+         using receiver_concept = stdexec::receiver_t;
+         Operation* op;
+
+         void set_value() && noexcept
+         {
+            op->_queued->add(-1.0);
+            stdexec::set_value(std::move(op->_receiver));
+         }
+         template <typename Error>
+         void set_error(Error&& error) && noexcept
+         {
+            op->_queued->add(-1.0);
+            stdexec::set_error(std::move(op->_receiver), std::forward<Error>(error));
+         }
+         void set_stopped() && noexcept
+         {
+            op->_queued->add(-1.0);
+            stdexec::set_stopped(std::move(op->_receiver));
+         }
+         [[nodiscard]] stdexec::env_of_t<Receiver> get_env() const noexcept
+         {
+            return stdexec::get_env(op->_receiver);
+         }
+      };
+
+      metrics::Gauge* _queued;
+      Receiver _receiver;
+      stdexec::connect_result_t<stdexec::schedule_result_t<Inner>, Forward> _operation;
+   };
+
+   class Sender {
+     public:
+      using sender_concept = stdexec::sender_t;
+      using completion_signatures =
+          stdexec::completion_signatures<stdexec::set_value_t(),
+                                         stdexec::set_error_t(std::exception_ptr),
+                                         stdexec::set_stopped_t()>;
+
+      struct Env {
+         Inner inner;
+         metrics::Gauge* queued;
+         [[nodiscard]] CountedScheduler query(
+             stdexec::get_completion_scheduler_t<stdexec::set_value_t>) const noexcept;
+      };
+
+      Sender(Inner inner, metrics::Gauge* queued) : _inner(inner), _queued(queued) {}
+
+      template <stdexec::receiver Receiver>
+      Operation<Receiver> connect(Receiver receiver) const
+      {
+         return {_inner, _queued, std::move(receiver)};
+      }
+      [[nodiscard]] Env get_env() const noexcept { return {_inner, _queued}; }
+
+     private:
+      Inner _inner;
+      metrics::Gauge* _queued;
+   };
+
+   CountedScheduler(Inner inner, metrics::Gauge* queued) : _inner(inner), _queued(queued) {}
+
+   [[nodiscard]] Sender schedule() const noexcept { return {_inner, _queued}; }
+   bool operator==(const CountedScheduler&) const = default;
+
+  private:
+   Inner _inner;
+   metrics::Gauge* _queued;
+};
+
+inline CountedScheduler CountedScheduler::Sender::Env::query(
+    stdexec::get_completion_scheduler_t<stdexec::set_value_t>) const noexcept
+{
+   return {inner, queued};
+}
+
 //! @brief Manages thread pools for different workload categories in the engine
 class ThreadPoolManager {
   public:
@@ -18,15 +128,29 @@ class ThreadPoolManager {
 
    static ThreadPoolManager& instance();
    void reset(std::optional<uint32_t> max_threads = std::nullopt);
-   auto scheduler(PoolType type)
-       -> decltype(std::declval<exec::static_thread_pool>().get_scheduler());
+   //! Work scheduled on it is counted in the pool's "pool.<type>.queued" gauge until it runs
+   CountedScheduler scheduler(PoolType type);
    std::shared_ptr<exec::static_thread_pool> create_temporary_pool(const std::string& name,
                                                                    size_t thread_count);
 
+   //! Sender running fn on the pool, its execution traced as name in the "task" category
+   //! @note name is not copied, use a string literal
+   template <typename Fn>
+   auto task(PoolType type, const char* name, Fn&& fn)
+   {
+      return stdexec::then(stdexec::schedule(scheduler(type)),
+                           [name, fn = std::forward<Fn>(fn)]() mutable {
+                              MEDDL_TRACE_SCOPE("task", name);
+                              return fn();
+                           });
+   }
+
   private:
    ThreadPoolManager() = default;
    ~ThreadPoolManager();
 
+   static metrics::Gauge& queued_gauge(PoolType type);
+
    std::unordered_map<PoolType, std::unique_ptr<exec::static_thread_pool>> _pools;
    std::unordered_map<std::string, std::shared_ptr<exec::static_thread_pool>> _temp_pools;
 };
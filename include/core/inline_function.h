@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace meddl {
+
+template <typename Signature, size_t Capacity = 48>
+class InlineFunction;
+
+//! Move only std::function that never allocates, the callable lives in Capacity inline bytes
+//! Callables that don't fit fail to compile, capture by reference or pointer instead
+template <typename R, typename... Args, size_t Capacity>
+class InlineFunction<R(Args...), Capacity> {
+  public:
+   InlineFunction() = default;
+
+   template <typename F>
+      requires(!std::is_same_v<std::remove_cvref_t<F>, InlineFunction> &&
+               std::is_invocable_r_v<R, std::remove_cvref_t<F>&, Args...>)
+   InlineFunction(F&& f)  // NOLINT(google-explicit-constructor), like std::function
+   {
+      using Fn = std::remove_cvref_t<F>;
+      static_assert(sizeof(Fn) <= Capacity, "callable does not fit, capture less or by reference");
+      static_assert(alignof(Fn) <= alignof(std::max_align_t), "callable is over aligned");
+      static_assert(std::is_nothrow_move_constructible_v<Fn>, "callable must be nothrow movable");
+      ::new (static_cast<void*>(_storage)) Fn(std::forward<F>(f));
+      _invoke = [](void* storage, Args... args) -> R {
+         return std::invoke(*static_cast<Fn*>(storage), std::forward<Args>(args)...);
+      };
+      _relocate = [](void* from, void* to) noexcept {
+         auto* fn = static_cast<Fn*>(from);
+         if (to) {
+            ::new (to) Fn(std::move(*fn));
+         }
+         fn->~Fn();
+      };
+   }
+
+   ~InlineFunction() { reset(); }
+
+   InlineFunction(const InlineFunction&) = delete;
+   InlineFunction& operator=(const InlineFunction&) = delete;
+
+   InlineFunction(InlineFunction&& other) noexcept { take(other); }
+   InlineFunction& operator=(InlineFunction&& other) noexcept
+   {
+      if (this != &other) {
+         reset();
+         take(other);
+      }
+      return *this;
+   }
+
+   R operator()(Args... args) const { return _invoke(_storage, std::forward<Args>(args)...); }
+   explicit operator bool() const { return _invoke != nullptr; }
+
+   void reset()
+   {
+      if (_relocate) {
+         _relocate(_storage, nullptr);
+      }
+      _invoke = nullptr;
+      _relocate = nullptr;
+   }
+
+  private:
+   void take(InlineFunction& other) noexcept
+   {
+      if (other._relocate) {
+         other._relocate(other._storage, _storage);
+      }
+      _invoke = std::exchange(other._invoke, nullptr);
+      _relocate = std::exchange(other._relocate, nullptr);
+   }
+
+   alignas(std::max_align_t) mutable std::byte _storage[Capacity]{};
+   R (*_invoke)(void*, Args...){nullptr};
+   //! Moves the callable to to and destroys it at from, only destroys when to is nullptr
+   void (*_relocate)(void* from, void* to) noexcept {nullptr};
+};
+
+}  // namespace meddl
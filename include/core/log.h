@@ -1,11 +1,61 @@
 #pragma once
 #include <spdlog/spdlog.h>
 
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <format>
+#include <iterator>
 #include <memory>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+//! Calls below this spdlog level compile to nothing, debug and trace are gone in release (NDEBUG)
+#ifndef MEDDL_LOG_ACTIVE_LEVEL
+#ifdef NDEBUG
+#define MEDDL_LOG_ACTIVE_LEVEL SPDLOG_LEVEL_INFO
+#else
+#define MEDDL_LOG_ACTIVE_LEVEL SPDLOG_LEVEL_TRACE
+#endif
+#endif
+
+//! A LogSite private to the call site, arguments go to its constructor: MEDDL_LOG_SITE(0.5, 2)
+//! Registered with the backend, which reports its pending repeats once the messages stop
+#define MEDDL_LOG_SITE(...)                                                     \
+   ([]() -> meddl::log::LogSite& {                                              \
+      static meddl::log::LogSite meddl_log_site{__VA_ARGS__};                   \
+      static const meddl::log::detail::SiteRegistration meddl_log_registration{ \
+          &meddl_log_site};                                                     \
+      return meddl_log_site;                                                    \
+   }())
+
+//! Front-ends for trace and debug that remove the whole call, arguments and MEDDL_LOG_SITE()
+//! included, below MEDDL_LOG_ACTIVE_LEVEL. The functions only skip the write:
+//!   MEDDL_LOG_DEBUG(MEDDL_LOG_SITE(), "Culled {} of {}", expensive_count(), total);
+#if MEDDL_LOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_TRACE
+#define MEDDL_LOG_TRACE(...) meddl::log::trace(__VA_ARGS__)
+#else
+#define MEDDL_LOG_TRACE(...) static_cast<void>(0)
+#endif
+#if MEDDL_LOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_DEBUG
+#define MEDDL_LOG_DEBUG(...) meddl::log::debug(__VA_ARGS__)
+#else
+#define MEDDL_LOG_DEBUG(...) static_cast<void>(0)
+#endif
 
 namespace meddl::log {
 
+using Level = spdlog::level::level_enum;
+constexpr auto ACTIVE_LEVEL = static_cast<Level>(MEDDL_LOG_ACTIVE_LEVEL);
+
+//! The logger the backend thread writes through, only its sinks and level are used
 std::shared_ptr<spdlog::logger>& get_logger();
 
 void init(spdlog::level::level_enum level = spdlog::level::info);
@@ -15,40 +65,449 @@ void set_logger(std::shared_ptr<spdlog::logger> logger);
 
 void disable();
 
+//! Blocks until everything logged so far has reached the sinks
+void flush();
+
+//! Messages lost to full thread buffers since start
+[[nodiscard]] uint64_t dropped();
+
+//! Rate limit and deduplication state of one call site, see MEDDL_LOG_SITE
+//! A token bucket lets burst messages through at once and per_second on average after that.
+//! Repeats of the last message that got through are held back and summarized as "Last message
+//! repeated N times", at the latest after repeat_interval. Thread safe and lock free
+class LogSite {
+  public:
+   explicit LogSite(double per_second = 1.0,
+                    uint32_t burst = 5,
+                    std::chrono::milliseconds repeat_interval = std::chrono::seconds(10));
+   LogSite(const LogSite&) = delete;
+   LogSite& operator=(const LogSite&) = delete;
+
+   struct Decision {
+      bool message{false};       // Let the message itself through
+      uint32_t repeated{0};      // Summarize this many repeats of the last message first
+      uint32_t suppressed{0};    // And this many messages the rate limit held back
+      Level level{Level::info};  // Of the last message that got through, set by expire()
+   };
+   //! hash identifies the message, e.g. its format string and arguments
+   Decision admit(uint64_t hash, int64_t now_ns, Level level = Level::info);
+   //! The pending summaries once repeat_interval passed without admit() reporting them, e.g.
+   //! after the repeats stopped. Never lets a message through
+   Decision expire(int64_t now_ns);
+
+  private:
+   bool take_token(int64_t now_ns);
+
+   int64_t _interval_ns;
+   int64_t _tolerance_ns;
+   int64_t _repeat_interval_ns;
+   std::atomic<int64_t> _next_ns{0};  // Token bucket as a theoretical arrival time
+   std::atomic<uint64_t> _last_hash{0};
+   std::atomic<int64_t> _last_emit_ns{0};
+   std::atomic<uint32_t> _repeated{0};
+   std::atomic<uint32_t> _suppressed{0};
+   std::atomic<Level> _level{Level::info};
+};
+
+namespace detail {
+
+//! Lets the backend drain report the site's expired summaries, for the registration's lifetime
+class SiteRegistration {
+  public:
+   explicit SiteRegistration(LogSite* site);
+   ~SiteRegistration();
+   SiteRegistration(const SiteRegistration&) = delete;
+   SiteRegistration& operator=(const SiteRegistration&) = delete;
+
+  private:
+   LogSite* _site;
+};
+
+//! Formats the raw arguments after a record header into out
+using FormatFn = void (*)(std::string_view fmt, const std::byte* args, std::string& out);
+
+struct RecordHeader {
+   uint32_t size{0};  // Whole record, header included. 0 marks a jump back to the buffer start
+   Level level{Level::info};
+   uint32_t fmt_size{0};
+   const char* fmt{nullptr};  // Points at the format string literal
+   FormatFn format{nullptr};
+   int64_t time_ns{0};  // system_clock
+};
+
+//! Single producer, single consumer byte ring holding variable sized records
+//! A record that does not fit before the end starts over at the front, full means dropped
+class ThreadBuffer {
+  public:
+   static constexpr size_t ALIGNMENT = alignof(RecordHeader);
+
+   //! Rounded up to a power of two
+   explicit ThreadBuffer(size_t capacity, size_t thread_id = 0)
+       : _capacity(std::bit_ceil(std::max<size_t>(capacity, 2 * sizeof(RecordHeader)))),
+         _mask(_capacity - 1),
+         _data(std::make_unique<Storage[]>(_capacity / sizeof(Storage))),
+         _thread_id(thread_id)
+   {
+   }
+
+   //! Producer side, contiguous space for size bytes or nullptr when full
+   std::byte* reserve(size_t size)
+   {
+      size = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+      auto head = _head.load(std::memory_order_relaxed);
+      const auto tail = _tail.load(std::memory_order_acquire);
+      const auto offset = head & _mask;
+      const auto contiguous = _capacity - offset;
+      const auto needed = size <= contiguous ? size : contiguous + size;
+      if (size > _capacity || _capacity - (head - tail) < needed) {
+         _dropped.fetch_add(1, std::memory_order_relaxed);
+         return nullptr;
+      }
+      if (size > contiguous) {
+         const uint32_t wrap = 0;
+         std::memcpy(bytes() + offset, &wrap, sizeof(wrap));
+         head += contiguous;
+      }
+      _reserved_end = head + size;
+      return bytes() + (head & _mask);
+   }
+
+   //! Producer side, publishes what reserve() handed out
+   void commit() { _head.store(_reserved_end, std::memory_order_release); }
+
+   //! Consumer side, the oldest record or nullptr
+   const RecordHeader* peek()
+   {
+      const auto head = _head.load(std::memory_order_acquire);
+      while (_read != head) {
+         const auto offset = _read & _mask;
+         const auto* header = reinterpret_cast<const RecordHeader*>(bytes() + offset);
+         if (header->size != 0) {
+            return header;
+         }
+         _read += _capacity - offset;
+      }
+      return nullptr;
+   }
+
+   //! Consumer side, frees the record peek() returned
+   void pop()
+   {
+      _read += reinterpret_cast<const RecordHeader*>(bytes() + (_read & _mask))->size;
+      _tail.store(_read, std::memory_order_release);
+   }
+
+   [[nodiscard]] uint64_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+   [[nodiscard]] size_t capacity() const { return _capacity; }
+   [[nodiscard]] size_t thread_id() const { return _thread_id; }
+
+   //! Set when the owning thread exits, the backend forgets the buffer once it is empty
+   std::atomic<bool> retired{false};
+
+  private:
+   struct alignas(ALIGNMENT) Storage {
+      std::byte bytes[ALIGNMENT];
+   };
+
+   std::byte* bytes() { return reinterpret_cast<std::byte*>(_data.get()); }
+
+   size_t _capacity;
+   size_t _mask;
+   std::unique_ptr<Storage[]> _data;
+   size_t _thread_id;
+   size_t _reserved_end{0};                   // Producer only
+   size_t _read{0};                           // Consumer only
+   alignas(64) std::atomic<size_t> _head{0};  // End of the published records
+   alignas(64) std::atomic<size_t> _tail{0};  // Start of the unread records
+   std::atomic<uint64_t> _dropped{0};
+};
+
+//! The calling thread's buffer, registered with the backend on first use
+ThreadBuffer* thread_buffer();
+
+inline std::atomic<Level> runtime_level{Level::info};
+//! Set once the backend thread stopped at exit, every write then drains on its own thread
+inline std::atomic<bool> synchronous{false};
+
+//! Arguments copied as bytes, everything else is formatted on the calling thread
+template <typename T>
+concept StringArgument = std::is_convertible_v<const T&, std::string_view>;
+template <typename T>
+concept RawArgument =
+    !StringArgument<T> && std::is_trivially_copyable_v<T> && !std::is_array_v<T>;
+
+template <typename T>
+using Stored = std::conditional_t<StringArgument<T>, std::string_view, T>;
+
+template <typename T>
+size_t encoded_size(const T& value)
+{
+   if constexpr (StringArgument<T>) {
+      return sizeof(uint32_t) + std::string_view(value).size();
+   }
+   else {
+      return sizeof(T);
+   }
+}
+
+template <typename T>
+void encode(std::byte*& cursor, const T& value)
+{
+   if constexpr (StringArgument<T>) {
+      const std::string_view text(value);
+      const auto size = static_cast<uint32_t>(text.size());
+      std::memcpy(cursor, &size, sizeof(size));
+      std::memcpy(cursor + sizeof(size), text.data(), size);
+      cursor += sizeof(size) + size;
+   }
+   else {
+      std::memcpy(cursor, &value, sizeof(T));
+      cursor += sizeof(T);
+   }
+}
+
+template <typename T>
+T decode(const std::byte*& cursor)
+{
+   if constexpr (std::is_same_v<T, std::string_view>) {
+      uint32_t size = 0;
+      std::memcpy(&size, cursor, sizeof(size));
+      const std::string_view text(reinterpret_cast<const char*>(cursor + sizeof(size)), size);
+      cursor += sizeof(size) + size;
+      return text;
+   }
+   else {
+      std::array<std::byte, sizeof(T)> raw;
+      std::memcpy(raw.data(), cursor, sizeof(T));
+      cursor += sizeof(T);
+      return std::bit_cast<T>(raw);
+   }
+}
+
+template <typename... Ts>
+void format_record(std::string_view fmt, [[maybe_unused]] const std::byte* args, std::string& out)
+{
+   // Braced initialization decodes left to right
+   std::tuple<Ts...> values{decode<Ts>(args)...};
+   std::apply(
+       [&](auto&... value) {
+          std::vformat_to(std::back_inserter(out), fmt, std::make_format_args(value...));
+       },
+       values);
+}
+
+template <typename... Ts>
+void write_record(Level level, std::string_view fmt, const Ts&... args)
+{
+   auto* buffer = thread_buffer();
+   if (!buffer) {
+      return;
+   }
+   const size_t size = sizeof(RecordHeader) + (encoded_size(args) + ... + size_t{0});
+   auto* out = buffer->reserve(size);
+   if (!out) {
+      return;
+   }
+   const RecordHeader header{
+       .size = static_cast<uint32_t>((size + ThreadBuffer::ALIGNMENT - 1) &
+                                     ~(ThreadBuffer::ALIGNMENT - 1)),
+       .level = level,
+       .fmt_size = static_cast<uint32_t>(fmt.size()),
+       .fmt = fmt.data(),
+       .format = &format_record<Stored<Ts>...>,
+       .time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      std::chrono::system_clock::now().time_since_epoch())
+                      .count()};
+   std::memcpy(out, &header, sizeof(header));
+   [[maybe_unused]] auto* cursor = out + sizeof(header);
+   (encode(cursor, args), ...);
+   buffer->commit();
+   if (synchronous.load(std::memory_order_acquire)) {
+      flush();
+   }
+}
+
+//! FNV-1a over the format string address and the encoded arguments
+template <typename... Ts>
+uint64_t hash_record(std::string_view fmt, const Ts&... args)
+{
+   uint64_t hash = 14695981039346656037ULL;
+   const auto mix = [&hash](const void* data, size_t size) {
+      for (size_t i = 0; i < size; i++) {
+         hash = (hash ^ static_cast<const unsigned char*>(data)[i]) * 1099511628211ULL;
+      }
+   };
+   const auto* address = fmt.data();
+   mix(static_cast<const void*>(&address), sizeof(address));
+   [[maybe_unused]] const auto mix_argument = [&mix]<typename T>(const T& value) {
+      if constexpr (StringArgument<T>) {
+         const std::string_view text(value);
+         mix(text.data(), text.size());
+      }
+      else {
+         mix(&value, sizeof(T));
+      }
+   };
+   (mix_argument(args), ...);
+   return hash;
+}
+
+template <typename... Ts>
+void write_limited(LogSite* site, Level level, std::string_view fmt, const Ts&... args)
+{
+   if (!site) {
+      write_record(level, fmt, args...);
+      return;
+   }
+   const auto decision =
+       site->admit(hash_record(fmt, args...),
+                   std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                       .count(),
+                   level);
+   if (decision.repeated > 0) {
+      write_record(level, "Last message repeated {} times", decision.repeated);
+   }
+   if (decision.suppressed > 0) {
+      write_record(level, "{} messages held back by the rate limit", decision.suppressed);
+   }
+   if (decision.message) {
+      write_record(level, fmt, args...);
+   }
+}
+
+//! Never blocks, a full buffer drops the message
+template <typename... Args>
+void write(LogSite* site, Level level, const spdlog::format_string_t<Args...>& fmt, Args&&... args)
+{
+   if (level < runtime_level.load(std::memory_order_relaxed)) {
+      return;
+   }
+   if constexpr (((RawArgument<std::remove_cvref_t<Args>> ||
+                   StringArgument<std::remove_cvref_t<Args>>) &&
+                  ...)) {
+      write_limited(site, level, fmt.get(), args...);
+   }
+   else {
+      write_limited(site, level, "{}", std::format(fmt, std::forward<Args>(args)...));
+   }
+}
+}  // namespace detail
+
+//! Arguments are copied, not formatted, on the calling thread. The backend thread formats them
+//! The LogSite overloads rate limit and deduplicate, e.g. for code running every frame:
+//!   meddl::log::info(MEDDL_LOG_SITE(), "Swapchain recreated {}x{}", width, height);
+//! Types that are neither strings nor trivially copyable are formatted here instead
+//! Below ACTIVE_LEVEL nothing is written, but the arguments are still evaluated, prefer
+//! MEDDL_LOG_TRACE/MEDDL_LOG_DEBUG where they are not free
+//! @note A trivially copyable type pointing at memory it doesn't own, e.g. a span, is formatted
+//! late. Format such arguments yourself
+template <typename... Args>
+void trace(const spdlog::format_string_t<Args...> fmt, [[maybe_unused]] Args&&... args)
+{
+   if constexpr (ACTIVE_LEVEL <= Level::trace) {
+      detail::write(nullptr, Level::trace, fmt, std::forward<Args>(args)...);
+   }
+}
+
+template <typename... Args>
+void trace([[maybe_unused]] LogSite& site,
+          const spdlog::format_string_t<Args...> fmt,
+          [[maybe_unused]] Args&&... args)
+{
+   if constexpr (ACTIVE_LEVEL <= Level::trace) {
+      detail::write(&site, Level::trace, fmt, std::forward<Args>(args)...);
+   }
+}
+
+template <typename... Args>
+void debug(const spdlog::format_string_t<Args...> fmt, [[maybe_unused]] Args&&... args)
+{
+   if constexpr (ACTIVE_LEVEL <= Level::debug) {
+      detail::write(nullptr, Level::debug, fmt, std::forward<Args>(args)...);
+   }
+}
+
+template <typename... Args>
+void debug([[maybe_unused]] LogSite& site,
+          const spdlog::format_string_t<Args...> fmt,
+          [[maybe_unused]] Args&&... args)
+{
+   if constexpr (ACTIVE_LEVEL <= Level::debug) {
+      detail::write(&site, Level::debug, fmt, std::forward<Args>(args)...);
+   }
+}
+
+template <typename... Args>
+void info(const spdlog::format_string_t<Args...> fmt, [[maybe_unused]] Args&&... args)
+{
+   if constexpr (ACTIVE_LEVEL <= Level::info) {
+      detail::write(nullptr, Level::info, fmt, std::forward<Args>(args)...);
+   }
+}
+
+template <typename... Args>
+void info([[maybe_unused]] LogSite& site,
+         const spdlog::format_string_t<Args...> fmt,
+         [[maybe_unused]] Args&&... args)
+{
+   if constexpr (ACTIVE_LEVEL <= Level::info) {
+      detail::write(&site, Level::info, fmt, std::forward<Args>(args)...);
+   }
+}
+
 template <typename... Args>
-void trace(const spdlog::format_string_t<Args...> fmt, Args&&... args)
+void warn(const spdlog::format_string_t<Args...> fmt, [[maybe_unused]] Args&&... args)
 {
-   get_logger()->trace(fmt, std::forward<Args>(args)...);
+   if constexpr (ACTIVE_LEVEL <= Level::warn) {
+      detail::write(nullptr, Level::warn, fmt, std::forward<Args>(args)...);
+   }
 }
 
 template <typename... Args>
-void debug(const spdlog::format_string_t<Args...> fmt, Args&&... args)
+void warn([[maybe_unused]] LogSite& site,
+         const spdlog::format_string_t<Args...> fmt,
+         [[maybe_unused]] Args&&... args)
 {
-   get_logger()->debug(fmt, std::forward<Args>(args)...);
+   if constexpr (ACTIVE_LEVEL <= Level::warn) {
+      detail::write(&site, Level::warn, fmt, std::forward<Args>(args)...);
+   }
 }
 
 template <typename... Args>
-void info(const spdlog::format_string_t<Args...> fmt, Args&&... args)
+void error(const spdlog::format_string_t<Args...> fmt, [[maybe_unused]] Args&&... args)
 {
-   get_logger()->info(fmt, std::forward<Args>(args)...);
+   if constexpr (ACTIVE_LEVEL <= Level::err) {
+      detail::write(nullptr, Level::err, fmt, std::forward<Args>(args)...);
+   }
 }
 
 template <typename... Args>
-void warn(const spdlog::format_string_t<Args...> fmt, Args&&... args)
+void error([[maybe_unused]] LogSite& site,
+          const spdlog::format_string_t<Args...> fmt,
+          [[maybe_unused]] Args&&... args)
 {
-   get_logger()->warn(fmt, std::forward<Args>(args)...);
+   if constexpr (ACTIVE_LEVEL <= Level::err) {
+      detail::write(&site, Level::err, fmt, std::forward<Args>(args)...);
+   }
 }
 
 template <typename... Args>
-void error(const spdlog::format_string_t<Args...> fmt, Args&&... args)
+void critical(const spdlog::format_string_t<Args...> fmt, [[maybe_unused]] Args&&... args)
 {
-   get_logger()->error(fmt, std::forward<Args>(args)...);
+   if constexpr (ACTIVE_LEVEL <= Level::critical) {
+      detail::write(nullptr, Level::critical, fmt, std::forward<Args>(args)...);
+   }
 }
 
 template <typename... Args>
-void critical(const spdlog::format_string_t<Args...> fmt, Args&&... args)
+void critical([[maybe_unused]] LogSite& site,
+             const spdlog::format_string_t<Args...> fmt,
+             [[maybe_unused]] Args&&... args)
 {
-   get_logger()->critical(fmt, std::forward<Args>(args)...);
+   if constexpr (ACTIVE_LEVEL <= Level::critical) {
+      detail::write(&site, Level::critical, fmt, std::forward<Args>(args)...);
+   }
 }
 
 }  // namespace meddl::log
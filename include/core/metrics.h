@@ -0,0 +1,161 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace meddl::metrics {
+
+//! Writers are spread over this many cache lines per metric, see Counter
+constexpr uint32_t SHARDS = 16;
+
+namespace detail {
+//! Round robin per thread, so concurrent writers rarely touch the same shard
+uint32_t shard_index();
+}  // namespace detail
+
+//! Monotonic count, e.g. frames, draw calls or uploaded bytes
+//! Every thread adds to its own shard without contention, value() sums them
+class Counter {
+  public:
+   void add(uint64_t value = 1)
+   {
+      _shards[detail::shard_index()].value.fetch_add(value, std::memory_order_relaxed);
+   }
+   [[nodiscard]] uint64_t value() const;
+
+  private:
+   struct alignas(64) Shard {
+      std::atomic<uint64_t> value{0};
+   };
+   std::array<Shard, SHARDS> _shards{};
+};
+
+//! Current level, e.g. a queue depth. Last set() wins, add() accumulates
+class Gauge {
+  public:
+   void set(double value) { _value.store(value, std::memory_order_relaxed); }
+   void add(double delta) { _value.fetch_add(delta, std::memory_order_relaxed); }
+   [[nodiscard]] double value() const { return _value.load(std::memory_order_relaxed); }
+
+  private:
+   std::atomic<double> _value{0.0};
+};
+
+//! Distribution over fixed buckets, sharded like Counter
+class Histogram {
+  public:
+   //! Upper bounds in milliseconds, 60 and 30 fps frame times fall right below a bound
+   static std::vector<double> default_ms_bounds();
+
+   //! bounds are ascending upper bucket bounds, larger values land in an overflow bucket
+   explicit Histogram(std::vector<double> bounds);
+
+   void record(double value);
+
+   struct Data {
+      uint64_t count{0};
+      double sum{0.0};
+      std::vector<uint64_t> buckets{};  // bounds().size() + 1, the last is the overflow
+   };
+   [[nodiscard]] Data data() const;
+   [[nodiscard]] const std::vector<double>& bounds() const { return _bounds; }
+
+  private:
+   struct alignas(64) Shard {
+      std::unique_ptr<std::atomic<uint64_t>[]> buckets;
+      std::atomic<uint64_t> count{0};
+      std::atomic<double> sum{0.0};
+   };
+   std::vector<double> _bounds;
+   std::array<Shard, SHARDS> _shards{};
+};
+
+struct CounterValue {
+   std::string name;
+   uint64_t value{0};
+};
+
+struct GaugeValue {
+   std::string name;
+   double value{0.0};
+};
+
+struct HistogramValue {
+   std::string name;
+   std::vector<double> bounds{};
+   Histogram::Data data{};
+
+   [[nodiscard]] double mean() const;
+   //! Upper bound of the bucket holding the percentile, the last bound for the overflow
+   [[nodiscard]] double percentile(double p) const;
+};
+
+struct Snapshot {
+   std::chrono::steady_clock::time_point time{};
+   std::vector<CounterValue> counters{};  // Sorted by name, as are the others
+   std::vector<GaugeValue> gauges{};
+   std::vector<HistogramValue> histograms{};
+
+   //! Counters and histograms as the change since earlier, gauges as they are now
+   [[nodiscard]] Snapshot since(const Snapshot& earlier) const;
+   //! One line, skips counters and histograms without activity
+   [[nodiscard]] std::string to_string() const;
+};
+
+//! Named metrics, created on first use and never destroyed, so references can be cached:
+//!   static auto& uploads = metrics::counter("upload.buffer_bytes");
+class Registry {
+  public:
+   Registry(const Registry&) = delete;
+   Registry& operator=(const Registry&) = delete;
+
+   static Registry& instance();
+
+   Counter& counter(const std::string& name);
+   Gauge& gauge(const std::string& name);
+   //! bounds are only used when the histogram is created
+   Histogram& histogram(const std::string& name,
+                        std::vector<double> bounds = Histogram::default_ms_bounds());
+
+   [[nodiscard]] Snapshot snapshot() const;
+
+   //! Logs the change since the previous line every interval, on its own thread
+   void start_log_sink(std::chrono::milliseconds interval);
+   void stop_log_sink();
+
+  private:
+   Registry() = default;
+   ~Registry();
+
+   mutable std::mutex _mutex;
+   std::map<std::string, std::unique_ptr<Counter>> _counters;
+   std::map<std::string, std::unique_ptr<Gauge>> _gauges;
+   std::map<std::string, std::unique_ptr<Histogram>> _histograms;
+   std::jthread _log_sink;
+};
+
+inline Counter& counter(const std::string& name)
+{
+   return Registry::instance().counter(name);
+}
+
+inline Gauge& gauge(const std::string& name)
+{
+   return Registry::instance().gauge(name);
+}
+
+inline Histogram& histogram(const std::string& name,
+                            std::vector<double> bounds = Histogram::default_ms_bounds())
+{
+   return Registry::instance().histogram(name, std::move(bounds));
+}
+
+}  // namespace meddl::metrics
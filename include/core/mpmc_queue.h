@@ -0,0 +1,106 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <utility>
+
+namespace meddl::async {
+
+//! Bounded multi producer, multi consumer queue, lock free and allocation free after creation
+//! Every slot carries a sequence number telling whether it is ready for the next push or pop, so
+//! threads only contend on the head or tail counter they advance and never wait on each other
+//! for longer than a slot copy.
+//! @note T must be default constructible, popped slots are reset to T{}
+template <typename T>
+class MpmcQueue {
+  public:
+   //! Rounded up to a power of two
+   explicit MpmcQueue(size_t capacity)
+       : _capacity(std::bit_ceil(std::max<size_t>(capacity, 2))),
+         _mask(_capacity - 1),
+         _slots(std::make_unique<Slot[]>(_capacity))
+   {
+      for (size_t i = 0; i < _capacity; i++) {
+         _slots[i].sequence.store(i, std::memory_order_relaxed);
+      }
+   }
+
+   MpmcQueue(const MpmcQueue&) = delete;
+   MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+   //! False when full, value is left untouched then
+   template <typename U>
+   bool try_push(U&& value)
+   {
+      auto pos = _head.load(std::memory_order_relaxed);
+      for (;;) {
+         auto& slot = _slots[pos & _mask];
+         const auto sequence = slot.sequence.load(std::memory_order_acquire);
+         const auto diff = static_cast<std::ptrdiff_t>(sequence - pos);
+         if (diff == 0) {
+            if (_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+               slot.value = std::forward<U>(value);
+               slot.sequence.store(pos + 1, std::memory_order_release);
+               return true;
+            }
+         }
+         else if (diff < 0) {
+            return false;
+         }
+         else {
+            pos = _head.load(std::memory_order_relaxed);
+         }
+      }
+   }
+
+   //! std::nullopt when empty
+   std::optional<T> try_pop()
+   {
+      auto pos = _tail.load(std::memory_order_relaxed);
+      for (;;) {
+         auto& slot = _slots[pos & _mask];
+         const auto sequence = slot.sequence.load(std::memory_order_acquire);
+         const auto diff = static_cast<std::ptrdiff_t>(sequence - (pos + 1));
+         if (diff == 0) {
+            if (_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+               std::optional<T> value{std::exchange(slot.value, T{})};
+               slot.sequence.store(pos + _capacity, std::memory_order_release);
+               return value;
+            }
+         }
+         else if (diff < 0) {
+            return std::nullopt;
+         }
+         else {
+            pos = _tail.load(std::memory_order_relaxed);
+         }
+      }
+   }
+
+   //! Only a hint while other threads push or pop
+   [[nodiscard]] size_t size_approx() const
+   {
+      const auto head = _head.load(std::memory_order_relaxed);
+      const auto tail = _tail.load(std::memory_order_relaxed);
+      return head > tail ? head - tail : 0;
+   }
+   [[nodiscard]] size_t capacity() const { return _capacity; }
+
+  private:
+   struct Slot {
+      std::atomic<size_t> sequence{0};
+      T value{};
+   };
+
+   size_t _capacity;
+   size_t _mask;
+   std::unique_ptr<Slot[]> _slots;
+   alignas(64) std::atomic<size_t> _head{0};  // Next push
+   alignas(64) std::atomic<size_t> _tail{0};  // Next pop
+};
+
+}  // namespace meddl::async
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//! 0 compiles every MEDDL_TRACE_* macro out, off by default in release (NDEBUG) builds
+#ifndef MEDDL_TRACING
+#ifdef NDEBUG
+#define MEDDL_TRACING 0
+#else
+#define MEDDL_TRACING 1
+#endif
+#endif
+
+namespace meddl::trace {
+
+//! Completed events kept per thread, older ones are overwritten
+constexpr uint32_t RING_CAPACITY = 1 << 14;
+
+//! A timed scope on a track, a thread or e.g. a GPU nesting level
+struct Event {
+   std::string_view name;
+   std::string_view category;
+   uint64_t start_ns{0};  // now_ns() clock
+   uint64_t end_ns{0};
+   uint32_t track{0};
+};
+
+struct Track {
+   uint32_t id{0};
+   std::string name;
+};
+
+struct Snapshot {
+   std::vector<Event> events{};
+   std::vector<Track> tracks{};
+};
+
+[[nodiscard]] inline uint64_t now_ns()
+{
+   return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                    std::chrono::steady_clock::now().time_since_epoch())
+                                    .count());
+}
+
+//! Appends to the calling thread's ring, lock free after the first call on a thread
+//! @note name and category are not copied, use string literals
+void record(const char* name, const char* category, uint64_t start_ns, uint64_t end_ns);
+//! Names the calling thread's track in exports, e.g. "Render"
+void set_thread_name(std::string name);
+
+//! Events of every thread that has traced, threads that exited included
+[[nodiscard]] Snapshot snapshot();
+//! Drops all recorded events, the rings stay registered
+void clear();
+//! Chrome trace event JSON, loads in chrome://tracing and Perfetto
+[[nodiscard]] std::string to_chrome_json(const Snapshot& snapshot);
+
+class Scope {
+  public:
+   Scope(const char* category, const char* name)
+       : _name(name), _category(category), _start(now_ns())
+   {
+   }
+   ~Scope() { record(_name, _category, _start, now_ns()); }
+
+   Scope(const Scope&) = delete;
+   Scope& operator=(const Scope&) = delete;
+   Scope(Scope&&) = delete;
+   Scope& operator=(Scope&&) = delete;
+
+  private:
+   const char* _name;
+   const char* _category;
+   uint64_t _start;
+};
+
+}  // namespace meddl::trace
+
+#define MEDDL_TRACE_CONCAT_IMPL(a, b) a##b
+#define MEDDL_TRACE_CONCAT(a, b) MEDDL_TRACE_CONCAT_IMPL(a, b)
+
+#if MEDDL_TRACING
+//! Times the rest of the enclosing scope, e.g. MEDDL_TRACE_SCOPE("render", "record")
+#define MEDDL_TRACE_SCOPE(category, name) \
+   const meddl::trace::Scope MEDDL_TRACE_CONCAT(meddl_trace_scope_, __LINE__)(category, name)
+#define MEDDL_TRACE_THREAD_NAME(name) meddl::trace::set_thread_name(name)
+#else
+// Still evaluated, so variables passed in don't become unused
+#define MEDDL_TRACE_SCOPE(category, name) (static_cast<void>(category), static_cast<void>(name))
+#define MEDDL_TRACE_THREAD_NAME(name) static_cast<void>(0)
+#endif
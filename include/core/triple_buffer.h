@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace meddl::async {
+
+//! Single producer, single consumer mailbox that always hands the newest value to the reader
+//! Three slots: the writer fills one, the reader holds one, the third sits in between. publish()
+//! and update() swap a slot with the middle one in a single atomic exchange, so neither side ever
+//! blocks the other and unread values are overwritten instead of queued.
+//! @note Slots are reused, so a writer that overwrites containers keeps their capacity
+template <typename T>
+class TripleBuffer {
+  public:
+   TripleBuffer() = default;
+   TripleBuffer(const TripleBuffer&) = delete;
+   TripleBuffer& operator=(const TripleBuffer&) = delete;
+   TripleBuffer(TripleBuffer&&) = delete;
+   TripleBuffer& operator=(TripleBuffer&&) = delete;
+
+   //! Writer side, owned by the writer until publish()
+   [[nodiscard]] T& write_buffer() { return _slots[_write]; }
+
+   //! Writer side, hands write_buffer() to the reader and wakes a waiting reader
+   void publish()
+   {
+      const auto previous = _middle.exchange(_write | FRESH, std::memory_order_acq_rel);
+      _write = previous & INDEX_MASK;
+      _middle.notify_one();
+   }
+
+   //! Reader side, swaps in the newest published value, false if nothing new was published
+   bool update()
+   {
+      if ((_middle.load(std::memory_order_relaxed) & FRESH) == 0) {
+         return false;
+      }
+      const auto previous = _middle.exchange(_read, std::memory_order_acq_rel);
+      _read = previous & INDEX_MASK;
+      return true;
+   }
+
+   //! Reader side, blocks until update() has something new
+   void wait() const
+   {
+      auto middle = _middle.load(std::memory_order_acquire);
+      while ((middle & FRESH) == 0) {
+         _middle.wait(middle, std::memory_order_acquire);
+         middle = _middle.load(std::memory_order_acquire);
+      }
+   }
+
+   //! Reader side, the value from the last successful update()
+   [[nodiscard]] T& read_buffer() { return _slots[_read]; }
+   [[nodiscard]] const T& read_buffer() const { return _slots[_read]; }
+
+  private:
+   static constexpr uint8_t INDEX_MASK = 0b011;
+   static constexpr uint8_t FRESH = 0b100;
+
+   std::array<T, 3> _slots{};
+   uint8_t _write{0};  // Writer only
+   uint8_t _read{1};   // Reader only
+   std::atomic<uint8_t> _middle{2};
+};
+
+}  // namespace meddl::async
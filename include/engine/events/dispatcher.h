@@ -0,0 +1,157 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "core/inline_function.h"
+#include "engine/events/event.h"
+
+namespace meddl::events {
+
+//! Event structs EventDispatcher routes, the position in the list is the event id
+using DispatchedEvents = std::tuple<WindowClose,
+                                    WindowResize,
+                                    KeyPressed,
+                                    KeyReleased,
+                                    KeyTyped,
+                                    MouseMoved,
+                                    MouseScrolled,
+                                    MouseButtonPressed,
+                                    MouseButtonReleased>;
+
+namespace detail {
+template <typename T, typename List>
+struct EventId;
+
+template <typename T, typename... Ts>
+struct EventId<T, std::tuple<Ts...>> {
+   static constexpr size_t value = [] {
+      constexpr std::array<bool, sizeof...(Ts)> same = {std::is_same_v<T, Ts>...};
+      for (size_t i = 0; i < same.size(); i++) {
+         if (same[i]) {
+            return i;
+         }
+      }
+      return same.size();
+   }();
+};
+}  // namespace detail
+
+template <typename T>
+constexpr size_t event_id = detail::EventId<T, DispatchedEvents>::value;
+
+template <typename T>
+concept DispatchedEvent = event_id<T> < std::tuple_size_v<DispatchedEvents>;
+
+//! Events whose EventTraits key tells instances apart, e.g. by key code or mouse button
+template <typename T>
+concept KeyedEvent = requires(const T& event) { event.keycode; } ||
+                     requires(const T& event) { event.button; };
+
+//! Inline bytes per handler, enough for a few captured pointers
+constexpr size_t EVENT_HANDLER_CAPACITY = 48;
+
+template <typename T>
+using EventHandlerFn = InlineFunction<bool(const T&), EVENT_HANDLER_CAPACITY>;
+
+//! Statically typed counterpart of EventHandler, dispatch() neither allocates nor type erases
+//! Every event type owns a dense handler array picked at compile time, handlers are called
+//! with the event struct itself:
+//!   dispatcher.subscribe<MouseMoved>([&](const MouseMoved& e) { ...; return true; });
+//!   dispatcher.dispatch(MouseMoved{.x = x, .y = y});
+//! @note Subscribing allocates, don't subscribe from inside a handler
+class EventDispatcher {
+  public:
+   //! Every event of type T
+   template <DispatchedEvent T, typename F>
+      requires EventTypeCallback<F, T>
+   void subscribe(F&& callback)
+   {
+      handlers<T>().slots.push_back(
+          {.specific = WILDCARD_HASH, .fn = EventHandlerFn<T>(std::forward<F>(callback))});
+   }
+
+   //! Only events with the same key as filter, e.g. KeyPressed{.keycode = Key::Q}
+   template <typename T, typename F>
+      requires DispatchedEvent<T> && KeyedEvent<T> && EventTypeCallback<F, T>
+   void subscribe(const T& filter, F&& callback)
+   {
+      auto& list = handlers<T>();
+      list.slots.push_back({.specific = EventTraits<T>::make_key(filter).specific,
+                            .fn = EventHandlerFn<T>(std::forward<F>(callback))});
+      list.any_specific = true;
+   }
+
+   //! True when any handler returned true
+   template <DispatchedEvent T>
+   bool dispatch(const T& event) const
+   {
+      const auto& list = handlers<T>();
+      size_t specific = WILDCARD_HASH;
+      if constexpr (KeyedEvent<T>) {
+         if (list.any_specific) {
+            specific = EventTraits<T>::make_key(event).specific;
+         }
+      }
+      bool handled = false;
+      for (const auto& slot : list.slots) {
+         if (slot.specific == WILDCARD_HASH || slot.specific == specific) {
+            handled |= slot.fn(event);
+         }
+      }
+      return handled;
+   }
+
+   template <DispatchedEvent T>
+   [[nodiscard]] size_t handler_count() const
+   {
+      return handlers<T>().slots.size();
+   }
+
+   template <DispatchedEvent T>
+   void clear()
+   {
+      handlers<T>() = {};
+   }
+
+   void clear()
+   {
+      std::apply([](auto&... lists) { ((lists = {}), ...); }, _handlers);
+   }
+
+  private:
+   template <typename T>
+   struct Handlers {
+      struct Slot {
+         size_t specific;  // WILDCARD_HASH or an EventTraits key
+         EventHandlerFn<T> fn;
+      };
+      std::vector<Slot> slots{};
+      bool any_specific{false};
+   };
+
+   template <typename List>
+   struct Table;
+   template <typename... Ts>
+   struct Table<std::tuple<Ts...>> {
+      using type = std::tuple<Handlers<Ts>...>;
+   };
+
+   template <typename T>
+   Handlers<T>& handlers()
+   {
+      return std::get<event_id<T>>(_handlers);
+   }
+   template <typename T>
+   const Handlers<T>& handlers() const
+   {
+      return std::get<event_id<T>>(_handlers);
+   }
+
+   Table<DispatchedEvents>::type _handlers{};
+};
+
+}  // namespace meddl::events
@@ -0,0 +1,219 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+#include "core/async.h"
+#include "core/inline_function.h"
+#include "core/mpmc_queue.h"
+
+namespace meddl {
+struct ModelData;
+}  // namespace meddl
+
+namespace meddl::events {
+
+//! A background model load finished, error is empty on success
+struct AssetLoaded {
+   std::filesystem::path path{};
+   std::shared_ptr<const ModelData> model{};
+   std::string error{};
+};
+
+//! A background shader compile finished, error is empty on success
+struct ShaderCompiled {
+   std::filesystem::path path{};
+   std::vector<uint32_t> spirv{};
+   std::string error{};
+};
+
+//! Inline bytes per handler, enough for a few captured pointers
+constexpr size_t BUS_HANDLER_CAPACITY = 48;
+
+template <typename T>
+using BusHandlerFn = InlineFunction<void(const T&), BUS_HANDLER_CAPACITY>;
+
+//! Thread safe counterpart of EventDispatcher for work finishing on the thread pools
+//! Any thread may post(), events travel through bounded lock free MPMC queues and reach each
+//! handler where it subscribed: on the main thread in pump(), once per frame, or on a pool:
+//!   bus.subscribe<AssetLoaded>([&](const AssetLoaded& e) { scene.add(e.model); });
+//!   bus.subscribe<ShaderCompiled>(PoolType::Compute, [&](const ShaderCompiled& e) { ... });
+//!   // on an IO thread
+//!   bus.post(AssetLoaded{.path = path, .model = std::move(model)});
+//! @note Subscribe before anything posts, subscribing is not thread safe. Pool handlers may run
+//! concurrently with each other and must not throw
+template <typename... Events>
+class BasicEventBus {
+  public:
+   using Event = std::variant<Events...>;
+   static constexpr size_t DEFAULT_CAPACITY = 1024;
+
+   //! Capacity per queue, rounded up to a power of two
+   explicit BasicEventBus(size_t capacity = DEFAULT_CAPACITY) : _capacity(capacity), _main(capacity)
+   {
+   }
+
+   BasicEventBus(const BasicEventBus&) = delete;
+   BasicEventBus& operator=(const BasicEventBus&) = delete;
+
+   //! Waits for pool deliveries still running
+   ~BasicEventBus() { wait_idle(); }
+
+   //! Delivered on the thread calling pump()
+   template <typename T, typename F>
+      requires(std::is_same_v<T, Events> || ...)
+   void subscribe(F&& callback)
+   {
+      handlers<T>().main.emplace_back(std::forward<F>(callback));
+   }
+
+   //! Delivered on a thread of pool
+   template <typename T, typename F>
+      requires(std::is_same_v<T, Events> || ...)
+   void subscribe(async::PoolType pool, F&& callback)
+   {
+      const auto index = static_cast<size_t>(pool);
+      if (!_pools[index]) {
+         _pools[index] = std::make_unique<async::MpmcQueue<Event>>(_capacity);
+      }
+      handlers<T>().pooled[index].emplace_back(std::forward<F>(callback));
+   }
+
+   //! Any thread, never blocks. Events nobody subscribed to are ignored
+   //! False when a queue was full, the event is then dropped for that queue and counted
+   template <typename E>
+      requires(std::is_same_v<std::remove_cvref_t<E>, Events> || ...)
+   bool post(E&& event)
+   {
+      using T = std::remove_cvref_t<E>;
+      const auto& list = handlers<T>();
+      bool queued = true;
+      for (size_t pool = 0; pool < POOL_COUNT; pool++) {
+         if (list.pooled[pool].empty()) {
+            continue;
+         }
+         if (_pools[pool]->try_push(Event{std::in_place_type<T>, event})) {
+            schedule(static_cast<async::PoolType>(pool));
+         }
+         else {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            queued = false;
+         }
+      }
+      if (!list.main.empty() &&
+          !_main.try_push(Event{std::in_place_type<T>, std::forward<E>(event)})) {
+         _dropped.fetch_add(1, std::memory_order_relaxed);
+         queued = false;
+      }
+      return queued;
+   }
+
+   //! Main thread, delivers what was posted so far. Events posted meanwhile wait for the next call
+   //! Returns the number of events delivered
+   size_t pump()
+   {
+      size_t delivered = 0;
+      for (auto pending = _main.size_approx(); pending > 0; pending--) {
+         auto event = _main.try_pop();
+         if (!event) {
+            break;
+         }
+         std::visit(
+             [this](const auto& e) {
+                for (const auto& fn : handlers<std::decay_t<decltype(e)>>().main) {
+                   fn(e);
+                }
+             },
+             *event);
+         delivered++;
+      }
+      return delivered;
+   }
+
+   //! Blocks until every event queued for a pool has been delivered
+   void wait_idle() const
+   {
+      while (_in_flight.load(std::memory_order_acquire) != 0) {
+         std::this_thread::yield();
+      }
+   }
+
+   //! Events lost to full queues since creation
+   [[nodiscard]] uint64_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+  private:
+   static constexpr size_t POOL_COUNT = 4;
+   static_assert(static_cast<size_t>(async::PoolType::General) + 1 == POOL_COUNT);
+
+   template <typename T>
+   struct Handlers {
+      std::vector<BusHandlerFn<T>> main{};
+      std::array<std::vector<BusHandlerFn<T>>, POOL_COUNT> pooled{};
+   };
+
+   //! One task per queued event, whichever task runs first takes whichever event is next
+   //! Every task matches a successful push, so there is always an event for it. The queue only
+   //! looks empty while an earlier producer has claimed a slot but not filled it yet
+   void schedule(async::PoolType pool)
+   {
+      _in_flight.fetch_add(1, std::memory_order_relaxed);
+      dispatch(pool);
+   }
+
+   //! Instead of spinning on the pool thread until that producer resumes, the task hands its
+   //! turn, and its in flight count, to a new task at the back of the pool's queue
+   void dispatch(async::PoolType pool)
+   {
+      stdexec::start_detached(
+          async::ThreadPoolManager::instance().task(pool, "event_bus", [this, pool] {
+             const auto index = static_cast<size_t>(pool);
+             auto event = _pools[index]->try_pop();
+             if (!event) {
+                dispatch(pool);
+                return;
+             }
+             std::visit(
+                 [this, index](const auto& e) {
+                    for (const auto& fn : handlers<std::decay_t<decltype(e)>>().pooled[index]) {
+                       fn(e);
+                    }
+                 },
+                 *event);
+             // Last touch of this, wait_idle() may return right after
+             _in_flight.fetch_sub(1, std::memory_order_release);
+          }));
+   }
+
+   template <typename T>
+   Handlers<T>& handlers()
+   {
+      return std::get<Handlers<T>>(_handlers);
+   }
+   template <typename T>
+   const Handlers<T>& handlers() const
+   {
+      return std::get<Handlers<T>>(_handlers);
+   }
+
+   size_t _capacity;
+   std::tuple<Handlers<Events>...> _handlers{};
+   async::MpmcQueue<Event> _main;
+   std::array<std::unique_ptr<async::MpmcQueue<Event>>, POOL_COUNT> _pools{};  // On subscribe
+   std::atomic<size_t> _in_flight{0};
+   std::atomic<uint64_t> _dropped{0};
+};
+
+//! The engine's own background completions
+using EventBus = BasicEventBus<AssetLoaded, ShaderCompiled>;
+
+}  // namespace meddl::events
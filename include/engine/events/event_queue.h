@@ -0,0 +1,135 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+#include "engine/events/dispatcher.h"
+
+namespace meddl::events {
+
+namespace detail {
+template <typename List>
+struct VariantOf;
+
+template <typename... Ts>
+struct VariantOf<std::tuple<Ts...>> {
+   using type = std::variant<Ts...>;
+};
+}  // namespace detail
+
+//! Any of DispatchedEvents by value
+using QueuedEvent = detail::VariantOf<DispatchedEvents>::type;
+static_assert(std::is_trivially_copyable_v<QueuedEvent>, "queued events must be plain data");
+
+//! Preallocated single producer, single consumer ring of events, filled by e.g. the GLFW
+//! callbacks and drained once per frame. push() never allocates or blocks, when the ring is full
+//! the event is dropped and counted
+//! drain() coalesces runs of the same event: the last MouseMoved and WindowResize win and
+//! MouseScrolled offsets add up. Runs only, so order relative to clicks and keys is kept.
+class EventQueue {
+  public:
+   static constexpr size_t DEFAULT_CAPACITY = 1024;
+
+   //! Rounded up to a power of two
+   explicit EventQueue(size_t capacity = DEFAULT_CAPACITY)
+       : _slots(std::bit_ceil(std::max<size_t>(capacity, 2))), _mask(_slots.size() - 1)
+   {
+   }
+
+   EventQueue(const EventQueue&) = delete;
+   EventQueue& operator=(const EventQueue&) = delete;
+
+   //! Producer side, false when full
+   template <DispatchedEvent T>
+   bool push(const T& event)
+   {
+      const auto head = _head.load(std::memory_order_relaxed);
+      if (head - _tail.load(std::memory_order_acquire) == _slots.size()) {
+         _dropped.fetch_add(1, std::memory_order_relaxed);
+         return false;
+      }
+      _slots[head & _mask] = event;
+      _head.store(head + 1, std::memory_order_release);
+      return true;
+   }
+
+   //! Consumer side, calls fn with every event struct queued so far, after coalescing
+   //! Events pushed by fn itself wait for the next drain. Returns the number of calls
+   template <typename Fn>
+      requires(!std::is_same_v<std::remove_cvref_t<Fn>, EventDispatcher>)
+   size_t drain(Fn&& fn)
+   {
+      const auto head = _head.load(std::memory_order_acquire);
+      auto tail = _tail.load(std::memory_order_relaxed);
+      if (tail == head) {
+         return 0;
+      }
+
+      size_t calls = 0;
+      QueuedEvent pending = _slots[tail & _mask];
+      for (tail++; tail != head; tail++) {
+         const auto& next = _slots[tail & _mask];
+         if (coalesce(pending, next)) {
+            continue;
+         }
+         std::visit(fn, pending);
+         calls++;
+         pending = next;
+      }
+      // pending is a copy, so the slots can go back to the producer before the last call
+      _tail.store(tail, std::memory_order_release);
+      std::visit(fn, pending);
+      return calls + 1;
+   }
+
+   //! Drains into dispatcher
+   size_t drain(const EventDispatcher& dispatcher)
+   {
+      return drain([&dispatcher](const auto& event) { dispatcher.dispatch(event); });
+   }
+
+   [[nodiscard]] size_t size() const
+   {
+      return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+   }
+   [[nodiscard]] size_t capacity() const { return _slots.size(); }
+   //! Events lost to a full ring since creation
+   [[nodiscard]] uint64_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+  private:
+   static bool coalesce(QueuedEvent& into, const QueuedEvent& next)
+   {
+      if (into.index() != next.index()) {
+         return false;
+      }
+      if (auto* moved = std::get_if<MouseMoved>(&into)) {
+         *moved = std::get<MouseMoved>(next);
+         return true;
+      }
+      if (auto* scrolled = std::get_if<MouseScrolled>(&into)) {
+         scrolled->x_offset += std::get<MouseScrolled>(next).x_offset;
+         scrolled->y_offset += std::get<MouseScrolled>(next).y_offset;
+         return true;
+      }
+      if (auto* resized = std::get_if<WindowResize>(&into)) {
+         *resized = std::get<WindowResize>(next);
+         return true;
+      }
+      return false;
+   }
+
+   std::vector<QueuedEvent> _slots;
+   size_t _mask;
+   alignas(64) std::atomic<size_t> _head{0};  // Next slot to write, producer owned
+   alignas(64) std::atomic<size_t> _tail{0};  // Next slot to read, consumer owned
+   std::atomic<uint64_t> _dropped{0};
+};
+
+}  // namespace meddl::events
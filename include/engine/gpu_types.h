@@ -1,4 +1,7 @@
 #pragma once
+#include <array>
+#include <cstdint>
+
 #include "glm/glm.hpp"
 namespace meddl {
 
@@ -42,6 +45,37 @@ constexpr size_t stride = sizeof(TransformUBO);
 static_assert(stride == sizeof(float) * 4 * 4 * 3);  // mat4 * 3
 }  // namespace transform_layout
 
+//! Per instance vertex stream (VK_VERTEX_INPUT_RATE_INSTANCE)
+struct InstanceData {
+   glm::mat4 model;
+   uint32_t material_id;
+   uint32_t padding[3];
+};
+
+namespace instance_layout {
+constexpr size_t model_offset = offsetof(InstanceData, model);
+static_assert(model_offset == 0, "bad model offset");
+constexpr size_t material_id_offset = offsetof(InstanceData, material_id);
+static_assert(material_id_offset == sizeof(float) * 4 * 4, "bad material_id offset");
+constexpr size_t stride = sizeof(InstanceData);
+static_assert(stride == sizeof(float) * 4 * 5, "bad instance stride");
+}  // namespace instance_layout
+
+//! Per draw push constants, fits in the guaranteed 128 bytes of push constant space
+struct DrawPushConstants {
+   glm::mat4 model;
+   uint32_t material_id;
+   uint32_t padding[3];
+};
+
+namespace draw_push_constants_layout {
+constexpr size_t model_offset = offsetof(DrawPushConstants, model);
+constexpr size_t material_id_offset = offsetof(DrawPushConstants, material_id);
+static_assert(material_id_offset == sizeof(float) * 4 * 4, "bad material_id offset");
+constexpr size_t stride = sizeof(DrawPushConstants);
+static_assert(stride <= 128, "DrawPushConstants exceeds the guaranteed maxPushConstantsSize");
+}  // namespace draw_push_constants_layout
+
 struct MaterialUBO {
    glm::vec4 diffuse_color;
    float shininess;
@@ -58,6 +92,33 @@ constexpr size_t roughness_offset = offsetof(MaterialUBO, roughness);
 constexpr size_t ao_offset = offsetof(MaterialUBO, ao);
 }  // namespace material_layout
 
+//! Material as seen by bindless shaders (std430), indexed by material id
+//! Texture indices point into BindlessTable's image array, invalid_index when unset
+struct BindlessMaterial {
+   glm::vec4 diffuse_color;
+   float shininess;
+   float metallic;
+   float roughness;
+   float ao;
+   uint32_t albedo_texture;
+   uint32_t normal_texture;
+   uint32_t metallic_roughness_texture;
+   uint32_t sampler_index;
+};
+
+namespace bindless_material_layout {
+constexpr uint32_t invalid_index = ~0u;
+
+constexpr size_t diffuse_offset = offsetof(BindlessMaterial, diffuse_color);
+constexpr size_t shininess_offset = offsetof(BindlessMaterial, shininess);
+static_assert(shininess_offset == sizeof(float) * 4, "bad shininess offset");
+constexpr size_t albedo_texture_offset = offsetof(BindlessMaterial, albedo_texture);
+static_assert(albedo_texture_offset == sizeof(float) * 8, "bad albedo_texture offset");
+constexpr size_t sampler_index_offset = offsetof(BindlessMaterial, sampler_index);
+constexpr size_t stride = sizeof(BindlessMaterial);
+static_assert(stride == 48, "BindlessMaterial must match the std430 layout in bindless shaders");
+}  // namespace bindless_material_layout
+
 struct Mesh {
    uint32_t index_count;
    uint32_t index_offset;
@@ -75,4 +136,48 @@ constexpr size_t material_index_offset = offsetof(Mesh, material_index);
 constexpr size_t stride = sizeof(Mesh);
 }  // namespace mesh_layout
 
+//! Per object input to the GPU culling pass (std430)
+struct DrawObject {
+   glm::vec4 bounding_sphere;  // xyz center (world space), w radius
+   uint32_t index_count;
+   uint32_t first_index;
+   int32_t vertex_offset;
+   uint32_t instance_index;
+};
+
+namespace draw_object_layout {
+constexpr size_t bounding_sphere_offset = offsetof(DrawObject, bounding_sphere);
+constexpr size_t index_count_offset = offsetof(DrawObject, index_count);
+static_assert(index_count_offset == sizeof(float) * 4, "bad index_count offset");
+constexpr size_t first_index_offset = offsetof(DrawObject, first_index);
+constexpr size_t vertex_offset_offset = offsetof(DrawObject, vertex_offset);
+constexpr size_t instance_index_offset = offsetof(DrawObject, instance_index);
+constexpr size_t stride = sizeof(DrawObject);
+static_assert(stride == 32, "DrawObject must match the std430 layout in the culling shader");
+}  // namespace draw_object_layout
+
+//! Culling pass parameters (std140)
+struct CullingUBO {
+   std::array<glm::vec4, 6> frustum_planes;  // xyz normal, w distance, pointing inwards
+   glm::mat4 view_projection;                // the view the depth pyramid was rendered from
+   glm::vec2 pyramid_size;
+   uint32_t object_count;
+   uint32_t flags;
+};
+
+namespace culling_layout {
+constexpr uint32_t occlusion_flag = 1u << 0;
+constexpr uint32_t late_phase_flag = 1u << 1;
+
+constexpr size_t frustum_planes_offset = offsetof(CullingUBO, frustum_planes);
+constexpr size_t view_projection_offset = offsetof(CullingUBO, view_projection);
+static_assert(view_projection_offset == sizeof(float) * 4 * 6, "bad view_projection offset");
+constexpr size_t pyramid_size_offset = offsetof(CullingUBO, pyramid_size);
+static_assert(pyramid_size_offset == sizeof(float) * 4 * 10, "bad pyramid_size offset");
+constexpr size_t object_count_offset = offsetof(CullingUBO, object_count);
+constexpr size_t flags_offset = offsetof(CullingUBO, flags);
+static_assert(flags_offset == sizeof(float) * 4 * 10 + 12, "bad flags offset");
+constexpr size_t stride = sizeof(CullingUBO);
+}  // namespace culling_layout
+
 }  // namespace meddl
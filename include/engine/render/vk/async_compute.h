@@ -0,0 +1,80 @@
+#pragma once
+
+#include <vulkan/vulkan_core.h>
+
+#include <expected>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "core/error.h"
+#include "engine/render/vk/async.h"
+#include "engine/render/vk/command.h"
+#include "engine/render/vk/device.h"
+
+namespace meddl::render::vk {
+
+//! Buffer range written by compute and read by graphics in the same frame
+struct BufferHandoff {
+   VkBuffer buffer{VK_NULL_HANDLE};
+   VkDeviceSize offset{0};
+   VkDeviceSize size{VK_WHOLE_SIZE};
+   //! Where graphics first reads it, e.g. DRAW_INDIRECT + INDIRECT_COMMAND_READ for culling
+   VkPipelineStageFlags dst_stage{VK_PIPELINE_STAGE_VERTEX_INPUT_BIT};
+   VkAccessFlags dst_access{VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT};
+};
+
+//! Compute work (culling, skinning, post processing) on the compute queue, overlapping the
+//! graphics queue. Each frame in flight has a command buffer, a fence and a semaphore that the
+//! graphics submit of that frame waits on.
+//! When compute is a different queue family, submit() releases the handoffs and acquire()
+//! takes them on the graphics side (queue family ownership transfer). Compute is expected to
+//! overwrite them every frame, so they are never transferred back.
+//! A frame looks like:
+//!   auto cmd = compute.begin(frame); record dispatches; compute.submit(handoffs);
+//!   compute.acquire(graphics_cmd, handoffs); record draws;
+//!   graphics submit waiting on compute.semaphore(frame) at compute.wait_stage(handoffs)
+class AsyncCompute {
+  public:
+   AsyncCompute() = default;
+   static std::expected<AsyncCompute, error::Error> create(Device* device,
+                                                           uint32_t frames_in_flight);
+
+   AsyncCompute(const AsyncCompute&) = delete;
+   AsyncCompute& operator=(const AsyncCompute&) = delete;
+   AsyncCompute(AsyncCompute&&) noexcept = default;
+   AsyncCompute& operator=(AsyncCompute&&) noexcept = default;
+   ~AsyncCompute() = default;
+
+   //! False when compute runs on the graphics queue, the work then serializes with it
+   [[nodiscard]] bool is_async() const;
+   [[nodiscard]] bool transfers_ownership() const { return _queue_family != _graphics_family; }
+   [[nodiscard]] uint32_t queue_family() const { return _queue_family; }
+
+   //! Waits for the frame's previous submission, then resets and begins its command buffer
+   std::expected<CommandBuffer*, error::Error> begin(uint32_t frame);
+   //! Releases the handoffs, ends and submits, signals semaphore(frame)
+   //! @note Every submit must be waited on by exactly one graphics submit
+   std::expected<void, error::Error> submit(std::span<const BufferHandoff> handoffs = {});
+   //! Acquire side of the ownership transfer, record before the first read of the handoffs
+   std::expected<void, error::Error> acquire(CommandBuffer* graphics,
+                                             std::span<const BufferHandoff> handoffs) const;
+
+   [[nodiscard]] VkSemaphore semaphore(uint32_t frame) const { return _semaphores.at(frame).vk(); }
+   //! Stages the graphics submit waits on semaphore() at
+   [[nodiscard]] static VkPipelineStageFlags wait_stage(std::span<const BufferHandoff> handoffs);
+
+  private:
+   Device* _device{nullptr};
+   const Queue* _queue{nullptr};
+   uint32_t _queue_family{0};
+   uint32_t _graphics_family{0};
+   uint32_t _frame{0};  // Of the last begin()
+   // Command buffers keep a pointer to the pool, so it must not move with this
+   std::unique_ptr<CommandPool> _pool{};
+   std::vector<CommandBuffer> _command_buffers{};
+   std::vector<Fence> _fences{};
+   std::vector<Semaphore> _semaphores{};
+};
+
+}  // namespace meddl::render::vk
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vulkan/vulkan_core.h>
+
+#include <expected>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "core/error.h"
+#include "engine/render/vk/device.h"
+#include "engine/render/vk/image.h"
+#include "engine/render/vk/shared.h"
+
+namespace meddl::render::vk {
+
+//! Images for the attachments of a render pass that are not backed by the swapchain
+//! Transient attachments get lazily allocated memory when the device has it (tile memory on
+//! mobile/tiled GPUs, nothing is committed). Everything else is packed into shared allocations,
+//! attachments whose [first_pass, last_pass] ranges don't overlap alias the same memory. Render
+//! passes flag those with VK_ATTACHMENT_DESCRIPTION_MAY_ALIAS_BIT, see Shared::may_alias.
+class AttachmentSet {
+  public:
+   struct Stats {
+      VkDeviceSize requested_bytes{0};  // Sum of all attachment sizes
+      VkDeviceSize allocated_bytes{0};  // Committed memory after aliasing, lazy excluded
+      uint32_t lazy_attachments{0};
+      uint32_t allocations{0};
+   };
+
+   AttachmentSet() = default;
+   //! Skips swapchain attachments, image() returns nullptr for those
+   static std::expected<AttachmentSet, error::Error> create(
+       Device* device,
+       std::span<const GraphicsConfiguration::AttachmentConfig> attachments,
+       uint32_t width,
+       uint32_t height);
+   ~AttachmentSet();
+
+   AttachmentSet(const AttachmentSet&) = delete;
+   AttachmentSet& operator=(const AttachmentSet&) = delete;
+   AttachmentSet(AttachmentSet&&) noexcept;
+   AttachmentSet& operator=(AttachmentSet&&) noexcept;
+
+   //! By attachment index in the configuration
+   [[nodiscard]] const Image* image(size_t attachment) const
+   {
+      return attachment < _images.size() && _images[attachment].has_value()
+                 ? &_images[attachment].value()
+                 : nullptr;
+   }
+   [[nodiscard]] size_t size() const { return _images.size(); }
+   [[nodiscard]] const Stats& stats() const { return _stats; }
+
+  private:
+   void destroy();
+
+   Device* _device{nullptr};
+   std::vector<std::optional<Image>> _images{};
+   std::vector<VkDeviceMemory> _memory{};
+   Stats _stats{};
+};
+
+}  // namespace meddl::render::vk
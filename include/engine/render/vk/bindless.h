@@ -0,0 +1,112 @@
+#pragma once
+
+#include <vulkan/vulkan_core.h>
+
+#include <expected>
+#include <memory>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "core/error.h"
+#include "engine/gpu_types.h"
+#include "engine/render/vk/buffer.h"
+#include "engine/render/vk/command.h"
+#include "engine/render/vk/descriptor.h"
+#include "engine/render/vk/device.h"
+#include "engine/render/vk/frame_allocator.h"
+#include "engine/render/vk/texture.h"
+
+namespace meddl::render::vk {
+
+struct BindlessConfig {
+   uint32_t max_images{4096};
+   uint32_t max_samplers{64};
+   uint32_t max_materials{4096};
+};
+
+//! Slots of a texture registered in a BindlessTable
+struct BindlessTexture {
+   uint32_t image{0};
+   uint32_t sampler{0};
+};
+
+//! Bindless resource table (descriptor indexing, Vulkan 1.2)
+//! One descriptor set, bound once per frame, holding:
+//!   binding 0: texture2D images[max_images]     (update after bind, partially bound)
+//!   binding 1: sampler samplers[max_samplers]   (update after bind, partially bound)
+//!   binding 2: BindlessMaterial materials[]     (storage buffer, indexed by material id)
+//! Shaders combine them as sampler2D(images[nonuniformEXT(i)], samplers[s]).
+//! Images and samplers are only ever appended, so slots handed out stay valid while the set is
+//! in use by pending command buffers. Their descriptor writes are batched until flush() or the
+//! next bind(). Materials live in device memory and are copied in by upload() each frame they
+//! change, so updating them never waits for the frames in flight.
+class BindlessTable {
+  public:
+   static constexpr uint32_t images_binding = 0;
+   static constexpr uint32_t samplers_binding = 1;
+   static constexpr uint32_t materials_binding = 2;
+
+   BindlessTable() = default;
+   static std::expected<BindlessTable, error::Error> create(Device* device,
+                                                            const BindlessConfig& config = {});
+   //! True if the device was created with the features a BindlessTable needs
+   static bool supported(const Device* device);
+
+   BindlessTable(const BindlessTable&) = delete;
+   BindlessTable& operator=(const BindlessTable&) = delete;
+   BindlessTable(BindlessTable&&) noexcept = default;
+   BindlessTable& operator=(BindlessTable&&) noexcept = default;
+   ~BindlessTable() = default;
+
+   //! Returns the slot in the image array
+   std::expected<uint32_t, error::Error> add_image(
+       VkImageView view, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+   //! Returns the slot in the sampler array, the same VkSampler always maps to the same slot
+   std::expected<uint32_t, error::Error> add_sampler(VkSampler sampler);
+   //! Registers both the texture's image and sampler
+   std::expected<BindlessTexture, error::Error> add_texture(const Texture& texture);
+
+   //! Overwrite the material table, material ids index into it. Takes effect at the next upload()
+   //! Ids past the table read a white untextured material
+   std::expected<void, error::Error> set_materials(std::span<const BindlessMaterial> materials);
+
+   //! Record the copy of changed materials, outside of any render pass and before the draws
+   //! Staged in the current frame of staging, which needs VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+   std::expected<void, error::Error> upload(CommandBuffer* cmd, FrameAllocator* staging);
+
+   //! Submit the pending image/sampler writes in one call
+   void flush();
+
+   std::expected<void, error::Error> bind(
+       CommandBuffer* cmd,
+       VkPipelineLayout layout,
+       uint32_t set_index,
+       VkPipelineBindPoint bind_point = VK_PIPELINE_BIND_POINT_GRAPHICS);
+
+   [[nodiscard]] const DescriptorSetLayout* layout() const { return _set_layout.get(); }
+   [[nodiscard]] VkDescriptorSet set() const { return _set->vk(); }
+   [[nodiscard]] uint32_t image_count() const { return _image_count; }
+   [[nodiscard]] uint32_t sampler_count() const
+   {
+      return static_cast<uint32_t>(_samplers.size());
+   }
+   [[nodiscard]] uint32_t material_count() const { return _material_count; }
+
+  private:
+   Device* _device{nullptr};
+   BindlessConfig _config{};
+   uint32_t _image_count{0};
+   uint32_t _material_count{0};
+   std::vector<BindlessMaterial> _staged_materials{};  // Mirror of the whole table
+   uint32_t _dirty_materials{0};                       // Leading entries upload() still copies
+   std::unordered_map<VkSampler, uint32_t> _samplers{};
+   DescriptorWriter _writer{};
+
+   std::unique_ptr<DescriptorSetLayout> _set_layout;
+   std::unique_ptr<DescriptorPool> _descriptor_pool;
+   std::unique_ptr<DescriptorSet> _set;
+   std::unique_ptr<Buffer> _materials;
+};
+
+}  // namespace meddl::render::vk
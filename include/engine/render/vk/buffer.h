@@ -17,6 +17,13 @@ const std::array<VkVertexInputAttributeDescription, 4> create_vertex_attribute_d
     size_t texcoord_offset,
     uint32_t binding = 0);
 
+//! mat4 model (4 x vec4 columns) followed by a uint material id, see InstanceData
+const std::array<VkVertexInputAttributeDescription, 5> create_instance_attribute_descriptions(
+    size_t model_offset,
+    size_t material_id_offset,
+    uint32_t binding = 1,
+    uint32_t first_location = 4);
+
 class Device;
 class Buffer {
   public:
@@ -50,7 +57,5 @@ class Buffer {
    VkDeviceMemory _memory = VK_NULL_HANDLE;
    VkDeviceSize _size = 0;
    void* _mapped_data = nullptr;
-
-   uint32_t find_memory_type(uint32_t typeFilter, VkMemoryPropertyFlags properties);
 };
 }  // namespace meddl::render::vk
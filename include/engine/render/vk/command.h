@@ -1,5 +1,7 @@
 #pragma once
 #include <expected>
+#include <span>
+#include <type_traits>
 
 #include "core/error.h"
 #include "engine/render/vk/device.h"
@@ -27,10 +29,12 @@ class CommandPool {
    CommandPool& operator=(CommandPool&& other) noexcept;
 
    [[nodiscard]] VkCommandPool vk() const { return _command_pool; }
+   [[nodiscard]] uint32_t queue_family_index() const { return _queue_family_index; }
 
   private:
    VkCommandPool _command_pool{VK_NULL_HANDLE};
    Device* _device{nullptr};
+   uint32_t _queue_family_index{0};
 };
 
 struct CommandBufferOptions {
@@ -38,6 +42,12 @@ struct CommandBufferOptions {
    uint32_t buffer_count{1};
 };
 
+//! Load/store ops and clear value from the attachment configuration
+VkRenderingAttachmentInfo rendering_attachment(
+    VkImageView view,
+    VkImageLayout layout,
+    const GraphicsConfiguration::AttachmentConfig& config);
+
 //! CommandBuffer
 class CommandBuffer {
   public:
@@ -78,6 +88,49 @@ class CommandBuffer {
    std::expected<void, error::Error> draw();
    std::expected<void, error::Error> end_renderpass();
 
+   //! Dynamic rendering (Vulkan 1.3), no render pass or framebuffer objects
+   //! @note Attachments must already be in the layouts given, e.g. transitioned by a RenderGraph
+   //! Depth stencil formats need the same view as both depth and stencil attachment, pipelines
+   //! built with rendering_formats() expect a stencil format for them
+   std::expected<void, error::Error> begin_rendering(
+       const VkRect2D& area,
+       std::span<const VkRenderingAttachmentInfo> color_attachments,
+       const VkRenderingAttachmentInfo* depth_attachment = nullptr,
+       const VkRenderingAttachmentInfo* stencil_attachment = nullptr);
+   std::expected<void, error::Error> end_rendering();
+
+   //! Push constants, each of stages needs a range in layout covering the bytes and stages must
+   //! include every stage of every range overlapping them
+   std::expected<void, error::Error> push_constants(const PipelineLayout& layout,
+                                                    VkShaderStageFlags stages,
+                                                    uint32_t offset,
+                                                    uint32_t size,
+                                                    const void* data);
+   template <typename T>
+      requires std::is_trivially_copyable_v<T>
+   std::expected<void, error::Error> push_constants(const PipelineLayout& layout,
+                                                    VkShaderStageFlags stages,
+                                                    const T& value,
+                                                    uint32_t offset = 0)
+   {
+      static_assert(sizeof(T) % 4 == 0, "push constant size must be a multiple of 4");
+      return push_constants(layout, stages, offset, static_cast<uint32_t>(sizeof(T)), &value);
+   }
+
+   //! Compute
+   std::expected<void, error::Error> bind_pipeline(const ComputePipeline* pipeline);
+   std::expected<void, error::Error> dispatch(uint32_t group_count_x,
+                                              uint32_t group_count_y = 1,
+                                              uint32_t group_count_z = 1);
+
+   //! Indirect drawing, requires drawIndirectCount (Vulkan 1.2)
+   std::expected<void, error::Error> draw_indexed_indirect_count(VkBuffer buffer,
+                                                                 VkDeviceSize offset,
+                                                                 VkBuffer count_buffer,
+                                                                 VkDeviceSize count_offset,
+                                                                 uint32_t max_draw_count,
+                                                                 uint32_t stride);
+
    //! One time submits
    //! @note end_and_submit must be called on the return CommandBuffer
    static std::expected<CommandBuffer, error::Error> begin_one_time_submit(Device* device,
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <vulkan/vulkan_core.h>
+
+#include <array>
+#include <expected>
+#include <memory>
+#include <optional>
+#include <span>
+
+#include "core/error.h"
+#include "engine/gpu_types.h"
+#include "engine/render/vk/buffer.h"
+#include "engine/render/vk/command.h"
+#include "engine/render/vk/depth_pyramid.h"
+#include "engine/render/vk/descriptor.h"
+#include "engine/render/vk/device.h"
+#include "engine/render/vk/pipeline.h"
+#include "engine/render/vk/shader.h"
+#include "glm/glm.hpp"
+
+namespace meddl::render::vk {
+
+//! Extract the six frustum planes (pointing inwards, normalized) from a view projection matrix
+std::array<glm::vec4, 6> extract_frustum_planes(const glm::mat4& view_projection);
+
+//! Early: frustum + occlusion against last frame's depth pyramid, draws the survivors
+//! Late: re-tests the objects the early phase occluded against this frame's pyramid, so
+//! disoccluded objects show up without a frame of delay
+enum class CullingPhase : uint8_t { Early, Late };
+
+//! GPU driven culling
+//! Tests DrawObjects in a compute pass and compacts the survivors into
+//! VkDrawIndexedIndirectCommands, drawn with a single vkCmdDrawIndexedIndirectCount.
+//! With a DepthPyramid, a frame looks like:
+//!   record(Early) -> renderpass: draw(Early) -> pyramid.build -> record(Late) ->
+//!   renderpass (loading color/depth): draw(Late)
+//! Without one only frustum culling is done and the late phase draws nothing.
+//! Needs the drawIndirectCount and drawIndirectFirstInstance features.
+//! @note Buffers are host written, use one instance per frame in flight
+class GpuCulling {
+  public:
+   static constexpr uint32_t workgroup_size = 64;
+
+   GpuCulling() = default;
+   static std::expected<GpuCulling, error::Error> create(Device* device,
+                                                         uint32_t max_objects,
+                                                         const DepthPyramid* pyramid = nullptr);
+
+   GpuCulling(const GpuCulling&) = delete;
+   GpuCulling& operator=(const GpuCulling&) = delete;
+   GpuCulling(GpuCulling&&) noexcept = default;
+   GpuCulling& operator=(GpuCulling&&) noexcept = default;
+   ~GpuCulling() = default;
+
+   //! Upload the objects to cull, truncated to max_objects
+   void set_objects(std::span<const DrawObject> objects);
+   //! pyramid_view_projection is the view the current pyramid contents were rendered from,
+   //! usually last frame's. Without it the early phase skips the occlusion test
+   void update_frustum(const glm::mat4& view_projection,
+                       std::optional<glm::mat4> pyramid_view_projection = std::nullopt);
+   //! Rebind after the pyramid was recreated, e.g. on swapchain resize
+   std::expected<void, error::Error> set_depth_pyramid(const DepthPyramid* pyramid);
+
+   //! Record the culling dispatch, must be called outside of a renderpass
+   std::expected<void, error::Error> record(CommandBuffer* cmd,
+                                            CullingPhase phase = CullingPhase::Early);
+   //! Draw the surviving objects, vertex/index buffers and the graphics pipeline must be bound
+   std::expected<void, error::Error> draw(CommandBuffer* cmd,
+                                          CullingPhase phase = CullingPhase::Early);
+
+   [[nodiscard]] uint32_t object_count() const { return _object_count; }
+   [[nodiscard]] uint32_t max_objects() const { return _max_objects; }
+   [[nodiscard]] bool occlusion_enabled() const { return _pyramid != nullptr; }
+   //! Also usable as transfer sources, e.g. to read the results back
+   [[nodiscard]] VkBuffer draw_commands(CullingPhase phase = CullingPhase::Early) const
+   {
+      return _phases[static_cast<size_t>(phase)].draw_commands->vk();
+   }
+   [[nodiscard]] VkBuffer draw_count(CullingPhase phase = CullingPhase::Early) const
+   {
+      return _phases[static_cast<size_t>(phase)].draw_count->vk();
+   }
+
+  private:
+   struct PhaseResources {
+      CullingUBO params{};
+      std::unique_ptr<Buffer> params_buffer;
+      std::unique_ptr<Buffer> draw_commands;
+      std::unique_ptr<Buffer> draw_count;
+      std::unique_ptr<DescriptorSet> descriptor_set;
+   };
+
+   void upload_params();
+
+   Device* _device{nullptr};
+   uint32_t _max_objects{0};
+   uint32_t _object_count{0};
+   const DepthPyramid* _pyramid{nullptr};
+
+   std::unique_ptr<ShaderModule> _shader;
+   std::unique_ptr<DescriptorSetLayout> _set_layout;
+   std::unique_ptr<PipelineLayout> _pipeline_layout;
+   std::unique_ptr<ComputePipeline> _pipeline;
+   std::unique_ptr<DescriptorPool> _descriptor_pool;
+
+   std::unique_ptr<Buffer> _objects;
+   std::unique_ptr<Buffer> _visibility;
+   std::array<PhaseResources, 2> _phases{};
+};
+
+}  // namespace meddl::render::vk
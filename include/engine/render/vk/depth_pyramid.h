@@ -0,0 +1,76 @@
+#pragma once
+
+#include <vulkan/vulkan_core.h>
+
+#include <expected>
+#include <memory>
+#include <vector>
+
+#include "core/error.h"
+#include "engine/render/vk/command.h"
+#include "engine/render/vk/descriptor.h"
+#include "engine/render/vk/device.h"
+#include "engine/render/vk/image.h"
+#include "engine/render/vk/pipeline.h"
+#include "engine/render/vk/sampler.h"
+#include "engine/render/vk/shader.h"
+
+namespace meddl::render::vk {
+
+//! Hierarchical depth (Hi-Z) built from a depth attachment with a compute reduction
+//! Each texel holds the farthest depth of the texels it covers. The engine uses a regular depth
+//! range (VK_COMPARE_OP_LESS, cleared to 1.0), so the conservative reduction is a max
+//! @note The depth attachment needs SAMPLED usage and a stored result, see
+//! presets::enable_depth_pyramid. Only its depth aspect is read, combined formats work too
+class DepthPyramid {
+  public:
+   static constexpr uint32_t workgroup_size = 8;
+   static constexpr VkFormat format = VK_FORMAT_R32_SFLOAT;
+
+   DepthPyramid() = default;
+   static std::expected<DepthPyramid, error::Error> create(Device* device,
+                                                           VkExtent2D depth_extent);
+   ~DepthPyramid();
+
+   DepthPyramid(const DepthPyramid&) = delete;
+   DepthPyramid& operator=(const DepthPyramid&) = delete;
+   DepthPyramid(DepthPyramid&&) noexcept;
+   DepthPyramid& operator=(DepthPyramid&&) noexcept;
+
+   //! Reduce the depth image into the pyramid, must be called outside of a renderpass
+   //! The depth image is expected in, and returned to, depth_layout
+   std::expected<void, error::Error> build(
+       CommandBuffer* cmd,
+       const Image& depth,
+       VkImageLayout depth_layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+
+   //! Full mip chain, in VK_IMAGE_LAYOUT_GENERAL
+   [[nodiscard]] VkImageView view() const { return _image.view(); }
+   //! Also a transfer source, e.g. to read levels back
+   [[nodiscard]] VkImage image() const { return _image.vk(); }
+   [[nodiscard]] VkSampler sampler() const { return _sampler.vk(); }
+   [[nodiscard]] VkExtent2D extent() const { return _extent; }
+   [[nodiscard]] uint32_t levels() const { return _levels; }
+
+  private:
+   void destroy_views();
+
+   Device* _device{nullptr};
+   VkExtent2D _extent{};
+   uint32_t _levels{0};
+   VkImage _bound_source{VK_NULL_HANDLE};
+   VkImageView _source_view{VK_NULL_HANDLE};  // Depth aspect of _bound_source, owned
+
+   Image _image;
+   std::vector<VkImageView> _mip_views{};
+   Sampler _sampler;
+
+   std::unique_ptr<ShaderModule> _shader;
+   std::unique_ptr<DescriptorSetLayout> _set_layout;
+   std::unique_ptr<PipelineLayout> _pipeline_layout;
+   std::unique_ptr<ComputePipeline> _pipeline;
+   std::unique_ptr<DescriptorPool> _descriptor_pool;
+   std::vector<DescriptorSet> _descriptor_sets{};
+};
+
+}  // namespace meddl::render::vk
@@ -2,8 +2,14 @@
 
 #include <vulkan/vulkan.h>
 
+#include <deque>
+#include <expected>
+#include <span>
+#include <type_traits>
 #include <vector>
 
+#include "core/error.h"
+
 #include "engine/render/vk/device.h"
 #include "engine/render/vk/shared.h"
 
@@ -56,8 +62,17 @@ class DescriptorSet {
   public:
    DescriptorSet(Device* device, DescriptorPool* pool, DescriptorSetLayout* layout);
 
-   void update(uint32_t binding, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range);
-   void update_image(uint32_t binding, VkImageView view, VkSampler sampler, VkImageLayout layout);
+   void update(uint32_t binding,
+               VkBuffer buffer,
+               VkDeviceSize offset,
+               VkDeviceSize range,
+               VkDescriptorType type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+   void update_image(uint32_t binding,
+                     VkImageView view,
+                     VkSampler sampler,
+                     VkImageLayout layout,
+                     VkDescriptorType type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                     uint32_t array_element = 0);
 
    [[nodiscard]] VkDescriptorSet vk() const { return _set; }
    [[nodiscard]] const VkDescriptorSet* vk_ptr() const { return &_set; }
@@ -66,4 +81,86 @@ class DescriptorSet {
    Device* _device;
    VkDescriptorSet _set = VK_NULL_HANDLE;
 };
+
+//! Accumulates descriptor writes to any number of sets and submits them with one
+//! vkUpdateDescriptorSets call
+class DescriptorWriter {
+  public:
+   DescriptorWriter& write_buffer(VkDescriptorSet set,
+                                  uint32_t binding,
+                                  VkBuffer buffer,
+                                  VkDeviceSize offset,
+                                  VkDeviceSize range,
+                                  VkDescriptorType type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                                  uint32_t array_element = 0);
+   DescriptorWriter& write_image(VkDescriptorSet set,
+                                 uint32_t binding,
+                                 VkImageView view,
+                                 VkSampler sampler,
+                                 VkImageLayout layout,
+                                 VkDescriptorType type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                                 uint32_t array_element = 0);
+
+   //! Submit and clear the pending writes
+   void flush(const Device* device);
+   void clear();
+
+   [[nodiscard]] size_t size() const { return _writes.size(); }
+   [[nodiscard]] bool empty() const { return _writes.empty(); }
+
+  private:
+   // Deques keep the info addresses stable while writes point into them
+   std::deque<VkDescriptorBufferInfo> _buffer_infos{};
+   std::deque<VkDescriptorImageInfo> _image_infos{};
+   std::vector<VkWriteDescriptorSet> _writes{};
+};
+
+//! vkDescriptorUpdateTemplate for a set layout, writes a whole set from one host struct
+//! Entries describe where each binding's VkDescriptorBufferInfo/VkDescriptorImageInfo lives in
+//! that struct, e.g.
+//!   struct MaterialDescriptors { VkDescriptorBufferInfo params; VkDescriptorImageInfo albedo; };
+//!   {template_entry(0, UNIFORM_BUFFER, offsetof(MaterialDescriptors, params)), ...}
+class DescriptorUpdateTemplate {
+  public:
+   DescriptorUpdateTemplate() = default;
+   static std::expected<DescriptorUpdateTemplate, error::Error> create(
+       Device* device,
+       const DescriptorSetLayout* layout,
+       std::span<const VkDescriptorUpdateTemplateEntry> entries);
+   ~DescriptorUpdateTemplate();
+
+   DescriptorUpdateTemplate(const DescriptorUpdateTemplate&) = delete;
+   DescriptorUpdateTemplate& operator=(const DescriptorUpdateTemplate&) = delete;
+   DescriptorUpdateTemplate(DescriptorUpdateTemplate&& other) noexcept;
+   DescriptorUpdateTemplate& operator=(DescriptorUpdateTemplate&& other) noexcept;
+
+   void update(VkDescriptorSet set, const void* data) const;
+   template <typename T>
+      requires(!std::is_pointer_v<T>)
+   void update(VkDescriptorSet set, const T& data) const
+   {
+      update(set, static_cast<const void*>(&data));
+   }
+
+   [[nodiscard]] VkDescriptorUpdateTemplate vk() const { return _template; }
+
+  private:
+   Device* _device{nullptr};
+   VkDescriptorUpdateTemplate _template{VK_NULL_HANDLE};
+};
+
+constexpr VkDescriptorUpdateTemplateEntry template_entry(uint32_t binding,
+                                                         VkDescriptorType type,
+                                                         size_t offset,
+                                                         uint32_t count = 1,
+                                                         size_t stride = 0,
+                                                         uint32_t array_element = 0)
+{
+   return VkDescriptorUpdateTemplateEntry{.dstBinding = binding,
+                                          .dstArrayElement = array_element,
+                                          .descriptorCount = count,
+                                          .descriptorType = type,
+                                          .offset = offset,
+                                          .stride = stride};
+}
 }  // namespace meddl::render::vk
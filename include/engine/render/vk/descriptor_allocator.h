@@ -0,0 +1,90 @@
+#pragma once
+
+#include <vulkan/vulkan_core.h>
+
+#include <expected>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "core/error.h"
+#include "engine/render/vk/descriptor.h"
+#include "engine/render/vk/device.h"
+
+namespace meddl::render::vk {
+
+//! One resource bound to a set, buffer or image depending on type
+struct DescriptorBinding {
+   uint32_t binding{0};
+   VkDescriptorType type{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER};
+   VkBuffer buffer{VK_NULL_HANDLE};
+   VkDeviceSize offset{0};
+   VkDeviceSize range{VK_WHOLE_SIZE};
+   VkImageView view{VK_NULL_HANDLE};
+   VkSampler sampler{VK_NULL_HANDLE};
+   VkImageLayout layout{VK_IMAGE_LAYOUT_UNDEFINED};
+
+   bool operator==(const DescriptorBinding& other) const = default;
+};
+
+//! Growable set of descriptor pools, meant to be owned per frame in flight
+//! Pools are created on demand, growing when a pool runs out of memory, and are all reset at
+//! once. get() caches sets by (layout, bindings) until the next reset, so identical materials
+//! share one set and one write per frame.
+class DescriptorAllocator {
+  public:
+   struct PoolRatio {
+      VkDescriptorType type;
+      float ratio;  // Descriptors of type per set
+   };
+
+   static constexpr uint32_t max_sets_per_pool = 4096;
+
+   DescriptorAllocator() = default;
+   static std::expected<DescriptorAllocator, error::Error> create(
+       Device* device, std::span<const PoolRatio> ratios, uint32_t initial_sets = 64);
+   //! Ratios covering the layouts in GraphicsConfiguration::descriptor_layouts
+   static std::expected<DescriptorAllocator, error::Error> create(Device* device,
+                                                                  uint32_t initial_sets = 64);
+   ~DescriptorAllocator();
+
+   DescriptorAllocator(const DescriptorAllocator&) = delete;
+   DescriptorAllocator& operator=(const DescriptorAllocator&) = delete;
+   DescriptorAllocator(DescriptorAllocator&&) noexcept;
+   DescriptorAllocator& operator=(DescriptorAllocator&&) noexcept;
+
+   //! Allocate an unwritten set
+   std::expected<VkDescriptorSet, error::Error> allocate(const DescriptorSetLayout* layout);
+   //! Cached set with bindings written, allocated and written on a miss
+   std::expected<VkDescriptorSet, error::Error> get(const DescriptorSetLayout* layout,
+                                                    std::span<const DescriptorBinding> bindings);
+
+   //! Return every set to the pools, only when no submitted work uses them
+   void reset();
+
+   [[nodiscard]] size_t pool_count() const { return _ready_pools.size() + _full_pools.size(); }
+   [[nodiscard]] size_t cached_sets() const { return _cache.size(); }
+
+  private:
+   struct CacheKey {
+      VkDescriptorSetLayout layout{VK_NULL_HANDLE};
+      std::vector<DescriptorBinding> bindings{};
+      bool operator==(const CacheKey& other) const = default;
+   };
+   struct CacheKeyHash {
+      size_t operator()(const CacheKey& key) const noexcept;
+   };
+
+   std::expected<VkDescriptorPool, error::Error> grab_pool();
+   std::expected<VkDescriptorPool, error::Error> create_pool(uint32_t set_count);
+   void destroy();
+
+   Device* _device{nullptr};
+   std::vector<PoolRatio> _ratios{};
+   uint32_t _sets_per_pool{0};
+   std::vector<VkDescriptorPool> _ready_pools{};
+   std::vector<VkDescriptorPool> _full_pools{};
+   std::unordered_map<CacheKey, VkDescriptorSet, CacheKeyHash> _cache{};
+};
+
+}  // namespace meddl::render::vk
@@ -26,8 +26,15 @@ enum class QueuePreset {
 
 struct DeviceConfiguration {
    std::unordered_map<uint32_t, QueueConfiguration> queue_configurations{};
+   //! Queue family per role, roles without one are served by the graphics queue
+   std::unordered_map<QueueFamilyType, uint32_t> queue_roles{};
    std::unordered_set<std::string> extensions{"VK_KHR_swapchain"};
    std::optional<VkPhysicalDeviceFeatures> features{};
+   //! Chained into VkDeviceCreateInfo, sType/pNext are filled in by Device::create
+   std::optional<VkPhysicalDeviceVulkan12Features> vulkan12_features{};
+   std::optional<VkPhysicalDeviceVulkan13Features> vulkan13_features{};
+   //! Enables the presentId/presentWait features, the extensions must be in extensions
+   bool present_wait{false};
    PhysicalDeviceRequirements physical_device_requirements{};
    struct {
       bool use_dedicated_allocations{true};
@@ -63,7 +70,31 @@ class Device {
    [[nodiscard]] VkDevice vk() const { return _device; }
 
    const std::vector<Queue>& queues() { return _queues; }
+   //! First queue of the role's family, the graphics queue if the role has none of its own
+   //! @note Roles can share a VkQueue, submissions to it must not race
+   [[nodiscard]] const Queue& queue(QueueFamilyType role) const;
+   //! False when queue(role) falls back to the graphics queue, work for it then serializes there
+   [[nodiscard]] bool has_own_queue(QueueFamilyType role) const;
+   //! First queue of the family, e.g. for the family a command pool was created for
+   [[nodiscard]] const Queue& queue_for_family(uint32_t queue_family_index) const;
    PhysicalDevice* physical_device() { return _physical_device; }
+   [[nodiscard]] const VkPhysicalDeviceFeatures& enabled_features() const
+   {
+      return _enabled_features;
+   }
+   [[nodiscard]] const VkPhysicalDeviceVulkan12Features& enabled_vulkan12_features() const
+   {
+      return _enabled_vulkan12_features;
+   }
+   [[nodiscard]] const VkPhysicalDeviceVulkan13Features& enabled_vulkan13_features() const
+   {
+      return _enabled_vulkan13_features;
+   }
+   [[nodiscard]] bool present_wait_enabled() const { return _present_wait; }
+   [[nodiscard]] bool has_extension(const std::string& extension) const
+   {
+      return _enabled_extensions.contains(extension);
+   }
 
    void wait_idle();
    // TODO: Allocator
@@ -79,6 +110,9 @@ class Device {
    PhysicalDevice* _physical_device{nullptr};
    std::unordered_set<std::string> _enabled_extensions{};
    VkPhysicalDeviceFeatures _enabled_features{};
+   VkPhysicalDeviceVulkan12Features _enabled_vulkan12_features{};
+   VkPhysicalDeviceVulkan13Features _enabled_vulkan13_features{};
+   bool _present_wait{false};
 };
 
 enum class DevicePickerStrategy : uint16_t {
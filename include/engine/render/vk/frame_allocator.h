@@ -0,0 +1,71 @@
+#pragma once
+
+#include <vulkan/vulkan_core.h>
+
+#include <cstring>
+#include <expected>
+#include <memory>
+#include <type_traits>
+
+#include "core/error.h"
+#include "engine/render/vk/buffer.h"
+#include "engine/render/vk/device.h"
+
+namespace meddl::render::vk {
+
+//! Per frame linear (bump) allocator over one persistently mapped buffer
+//! The buffer is split into one region per frame in flight, begin_frame rewinds that frame's
+//! region. Offsets are aligned to the device's min uniform/storage buffer offset alignment, so
+//! they can be passed as dynamic offsets to VK_DESCRIPTOR_TYPE_*_BUFFER_DYNAMIC descriptors
+//! written with offset 0.
+class FrameAllocator {
+  public:
+   struct Allocation {
+      VkDeviceSize offset{0};  // From the start of the buffer
+      VkDeviceSize size{0};
+      void* data{nullptr};
+
+      [[nodiscard]] uint32_t dynamic_offset() const { return static_cast<uint32_t>(offset); }
+   };
+
+   FrameAllocator() = default;
+   static std::expected<FrameAllocator, error::Error> create(
+       Device* device,
+       VkDeviceSize bytes_per_frame,
+       uint32_t frames_in_flight,
+       VkBufferUsageFlags usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT |
+                                  VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+
+   //! Must only be called once the frame's previous submission has completed
+   void begin_frame(uint32_t frame_index);
+
+   std::expected<Allocation, error::Error> allocate(VkDeviceSize size);
+
+   //! Copy value into the current frame and return its dynamic offset
+   template <typename T>
+      requires std::is_trivially_copyable_v<T>
+   std::expected<uint32_t, error::Error> push(const T& value)
+   {
+      auto allocation = allocate(sizeof(T));
+      if (!allocation) {
+         return std::unexpected(allocation.error());
+      }
+      std::memcpy(allocation->data, &value, sizeof(T));
+      return allocation->dynamic_offset();
+   }
+
+   [[nodiscard]] VkBuffer buffer() const { return _buffer ? _buffer->vk() : VK_NULL_HANDLE; }
+   [[nodiscard]] VkDeviceSize alignment() const { return _alignment; }
+   [[nodiscard]] VkDeviceSize frame_capacity() const { return _frame_size; }
+   [[nodiscard]] VkDeviceSize frame_used() const { return _cursor; }
+
+  private:
+   std::unique_ptr<Buffer> _buffer{};
+   VkDeviceSize _alignment{1};
+   VkDeviceSize _frame_size{0};
+   uint32_t _frames_in_flight{0};
+   VkDeviceSize _frame_begin{0};
+   VkDeviceSize _cursor{0};
+};
+
+}  // namespace meddl::render::vk
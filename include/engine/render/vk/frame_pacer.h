@@ -0,0 +1,79 @@
+#pragma once
+
+#include <vulkan/vulkan_core.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <span>
+
+#include "engine/render/vk/device.h"
+
+namespace meddl::render::vk {
+
+enum class PresentPolicy : uint8_t {
+   Vsync,          // FIFO, never tears
+   AdaptiveVsync,  // FIFO_RELAXED, tears instead of stuttering when a frame is late
+   LowLatency,     // MAILBOX, the newest frame replaces queued ones, IMMEDIATE if unsupported
+   Uncapped,       // IMMEDIATE, tears
+};
+
+//! Best supported mode for the policy, falls back to FIFO which every surface supports
+[[nodiscard]] VkPresentModeKHR choose_present_mode(PresentPolicy policy,
+                                                   std::span<const VkPresentModeKHR> supported);
+
+//! Frames in flight, latency waits and frame time statistics for the present loop
+//! With present wait (VK_KHR_present_wait) wait() blocks until all but max_queued_presents - 1
+//! presents are on screen, so the frame started next samples input as late as possible instead
+//! of queueing behind the display. Without it, pacing is left to the fences and acquire.
+class FramePacer {
+  public:
+   struct Config {
+      uint32_t frames_in_flight{2};
+      //! Presents allowed to wait for display, including the next one, present wait only
+      uint32_t max_queued_presents{1};
+      bool present_wait{true};
+   };
+
+   //! Present to present interval on the CPU, over the last SAMPLE_COUNT frames
+   struct Stats {
+      float mean_ms{0.0f};
+      float stddev_ms{0.0f};
+      float last_wait_ms{0.0f};  // Time spent in the last wait()
+      uint32_t samples{0};
+   };
+
+   static constexpr size_t SAMPLE_COUNT = 128;
+
+   FramePacer() = default;
+   //! config.present_wait is ignored unless the device enabled it
+   static FramePacer create(Device* device, const Config& config);
+
+   [[nodiscard]] uint32_t frames_in_flight() const { return _config.frames_in_flight; }
+   [[nodiscard]] bool waits_for_present() const { return _wait_for_present != nullptr; }
+
+   //! Call before sampling input for the next frame
+   void wait(VkSwapchainKHR swapchain);
+   //! Chains a present id into info, which must be presented before the next call
+   void on_present(VkPresentInfoKHR& info, VkSwapchainKHR swapchain);
+
+   [[nodiscard]] Stats stats() const;
+
+  private:
+   Device* _device{nullptr};
+   Config _config{};
+   PFN_vkWaitForPresentKHR _wait_for_present{nullptr};
+
+   // Ids only have to increase per swapchain, so one counter serves all of them
+   VkSwapchainKHR _swapchain{VK_NULL_HANDLE};  // Last presented to
+   uint64_t _present_id{0};                     // Last id presented
+   uint64_t _first_present_id{0};               // First id presented on _swapchain
+   VkPresentIdKHR _present_id_info{};
+
+   std::array<float, SAMPLE_COUNT> _frame_times{};
+   uint64_t _frame_count{0};
+   std::chrono::steady_clock::time_point _last_present{};
+   float _last_wait_ms{0.0f};
+};
+
+}  // namespace meddl::render::vk
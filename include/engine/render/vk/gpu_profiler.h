@@ -0,0 +1,119 @@
+#pragma once
+
+#include <vulkan/vulkan_core.h>
+
+#include <cstdint>
+#include <expected>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "core/error.h"
+#include "core/trace.h"
+#include "engine/render/vk/command.h"
+#include "engine/render/vk/device.h"
+
+namespace meddl::render::vk {
+
+//! GPU timings of command buffer regions from timestamp queries, no validation layers needed
+//! Every frame in flight owns a range of the query pool. begin_frame() reads back what the same
+//! frame slot recorded frames_in_flight frames earlier, whose fence was already waited on, so
+//! nothing ever stalls on the GPU. Regions nest like Debugger::begin_region:
+//!   profiler.begin_frame(cmd, frame);
+//!   profiler.begin_region(cmd, "shadows"); record; profiler.end_region(cmd);
+//! @note begin_frame() records a query reset, call it outside of a render pass
+class GpuProfiler {
+  public:
+   struct Config {
+      uint32_t frames_in_flight{2};
+      uint32_t max_regions{64};  // Per frame, regions past that are not timed
+      uint32_t history{128};     // Samples kept per region for averages and percentiles
+   };
+
+   struct RegionStats {
+      std::string name;
+      uint32_t depth{0};  // Nesting level when last seen, 0 is outermost
+      uint32_t samples{0};
+      float last_ms{0.0f};
+      float mean_ms{0.0f};
+      float p50_ms{0.0f};
+      float p95_ms{0.0f};
+      float p99_ms{0.0f};
+      float max_ms{0.0f};
+   };
+
+   GpuProfiler() = default;
+   //! Fails when the graphics queue family has no timestamp support
+   static std::expected<GpuProfiler, error::Error> create(Device* device,
+                                                          const Config& config = {});
+   ~GpuProfiler();
+
+   GpuProfiler(const GpuProfiler&) = delete;
+   GpuProfiler& operator=(const GpuProfiler&) = delete;
+   GpuProfiler(GpuProfiler&& other) noexcept;
+   GpuProfiler& operator=(GpuProfiler&& other) noexcept;
+
+   //! Collects the results of the frame slot and resets it, once its fence was waited on
+   void begin_frame(CommandBuffer* cmd, uint32_t frame);
+   void begin_region(CommandBuffer* cmd, const std::string& name);
+   void end_region(CommandBuffer* cmd);
+
+   //! Rolling statistics over the last Config::history samples, in order of first appearance
+   [[nodiscard]] std::vector<RegionStats> stats() const;
+   //! Regions of the last collected frame on tracks first_track + nesting level
+   //! Placed at the CPU time the frame was recorded, the GPU clock is not calibrated against it
+   void append_trace(trace::Snapshot& snapshot, uint32_t first_track) const;
+   //! Regions of the last collected frame as Chrome trace events, for chrome://tracing or Perfetto
+   [[nodiscard]] std::string trace_json() const;
+   [[nodiscard]] uint64_t frames_collected() const { return _frames_collected; }
+
+  private:
+   static constexpr uint32_t NOT_TIMED = UINT32_MAX;
+
+   struct Region {
+      uint32_t id;
+      uint32_t depth;
+      uint32_t begin_query;
+      uint32_t end_query{NOT_TIMED};
+   };
+   struct FrameQueries {
+      std::vector<Region> regions{};
+      uint32_t used{0};
+      bool recorded{false};
+      uint64_t cpu_start_ns{0};  // trace::now_ns() at begin_frame
+   };
+   struct History {
+      std::string name;
+      uint32_t depth{0};
+      std::vector<float> samples{};  // Ring buffer
+      uint32_t next{0};
+      uint32_t count{0};
+   };
+   struct TraceEvent {
+      uint32_t id;
+      uint32_t depth;
+      uint64_t start_ns;  // trace::now_ns() clock
+      uint64_t end_ns;
+   };
+
+   void collect(uint32_t frame);
+   [[nodiscard]] uint32_t region_id(const std::string& name, uint32_t depth);
+   [[nodiscard]] uint32_t queries_per_frame() const { return _config.max_regions * 2; }
+   void destroy();
+
+   Device* _device{nullptr};
+   Config _config{};
+   VkQueryPool _pool{VK_NULL_HANDLE};
+   double _period_ns{1.0};       // VkPhysicalDeviceLimits::timestampPeriod
+   uint64_t _valid_mask{~0ull};  // From timestampValidBits, counters wrap
+   uint32_t _frame{0};
+   std::vector<FrameQueries> _frames{};
+   std::vector<uint32_t> _open{};     // Regions of the recording frame not ended yet
+   std::vector<uint64_t> _results{};  // Scratch for vkGetQueryPoolResults
+   std::unordered_map<std::string, uint32_t> _ids{};
+   std::vector<History> _history{};  // By region id
+   std::vector<TraceEvent> _last_frame{};
+   uint64_t _frames_collected{0};
+};
+
+}  // namespace meddl::render::vk
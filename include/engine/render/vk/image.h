@@ -26,6 +26,13 @@ class Image {
                        uint32_t width,
                        uint32_t height);
 
+   //! Owns the handle but not the memory, bind_memory() before use
+   //! For attachments sharing (aliasing) one allocation, see AttachmentSet
+   static Image create_unbound(Device* device,
+                               const GraphicsConfiguration::AttachmentConfig& config,
+                               uint32_t width,
+                               uint32_t height);
+
    //! This image does not own the handle or the memory
    static Image create_deferred(VkImage image,
                                 Device* device,
@@ -42,6 +49,12 @@ class Image {
    [[nodiscard]] VkImageView view() const { return _image_view; }
    [[nodiscard]] VkDeviceMemory memory() const { return _memory; }
    [[nodiscard]] bool is_owner() const { return _owned_resources.has_value(); }
+   [[nodiscard]] VkExtent3D extent() const { return _extent; }
+   [[nodiscard]] const GraphicsConfiguration::AttachmentConfig& config() const { return _config; }
+
+   [[nodiscard]] VkMemoryRequirements memory_requirements() const;
+   //! Bind memory owned by someone else and create the view, for create_unbound images
+   void bind_memory(VkDeviceMemory memory, VkDeviceSize offset);
 
    void transition(CommandPool* pool, VkImageLayout old_layout, VkImageLayout new_layout);
    void copy_from_buffer(Buffer* buffer, CommandPool* pool);
@@ -43,6 +43,10 @@ class PhysicalDevice {
    //! @brief
    //! Returns the queue family only if it's a perfect match to flags
    [[nodiscard]] const std::optional<uint32_t> get_queue_family(VkQueueFlags flags) const;
+   //! A family with flags but none of excluded, e.g. compute without graphics for async compute
+   [[nodiscard]] const std::optional<uint32_t> get_dedicated_queue_family(
+       VkQueueFlags flags,
+       VkQueueFlags excluded) const;
    [[nodiscard]] const std::optional<uint32_t> get_present_family(Surface* surface) const;
    [[nodiscard]] const std::vector<VkQueueFamilyProperties>& get_queue_families() const;
    [[nodiscard]] const std::vector<VkSurfaceFormatKHR> formats(Surface* surface) const;
@@ -51,7 +55,22 @@ class PhysicalDevice {
 
    [[nodiscard]] const VkPhysicalDeviceProperties& get_properties() const { return _properties; }
    [[nodiscard]] const VkPhysicalDeviceFeatures& get_features() const { return _features; };
+   //! @note zero initialized if the device does not support Vulkan 1.2
+   [[nodiscard]] const VkPhysicalDeviceVulkan12Features& get_vulkan12_features() const
+   {
+      return _vulkan12_features;
+   }
+   //! @note zero initialized if the device does not support Vulkan 1.3
+   [[nodiscard]] const VkPhysicalDeviceVulkan13Features& get_vulkan13_features() const
+   {
+      return _vulkan13_features;
+   }
+   //! VK_KHR_present_id and VK_KHR_present_wait with both features, see FramePacer
+   [[nodiscard]] bool supports_present_wait() const { return _present_wait; }
    [[nodiscard]] VkPhysicalDeviceMemoryProperties get_memory_properties() const;
+   //! First memory type in type_bits with all of flags
+   [[nodiscard]] std::optional<uint32_t> find_memory_type(uint32_t type_bits,
+                                                          VkMemoryPropertyFlags flags) const;
    [[nodiscard]] std::vector<VkExtensionProperties> get_supported_exstensions() const;
    [[nodiscard]] bool has_extension_support(const std::string& extension_name) const;
    [[nodiscard]] bool has_extensions_support(
@@ -67,7 +86,10 @@ class PhysicalDevice {
    Instance* _instance;
 
    VkPhysicalDeviceFeatures _features{};
+   VkPhysicalDeviceVulkan12Features _vulkan12_features{};
+   VkPhysicalDeviceVulkan13Features _vulkan13_features{};
    VkPhysicalDeviceProperties _properties{};
+   bool _present_wait{false};
    std::vector<VkQueueFamilyProperties> _queue_families{};
    PFN_vkGetPhysicalDeviceFeatures2 _vkGetPhysicalDeviceFeatures2 = nullptr;
    PFN_vkGetPhysicalDeviceProperties2 _vkGetPhysicalDeviceProperties2 = nullptr;
@@ -2,20 +2,46 @@
 
 #include <vulkan/vulkan_core.h>
 
+#include <span>
+#include <vector>
+
 #include "core/error.h"
 #include "engine/render/vk/descriptor.h"
 #include "engine/render/vk/device.h"
 #include "engine/render/vk/renderpass.h"
 #include "engine/render/vk/shader.h"
+#include "engine/render/vk/shared.h"
 
 namespace meddl::render::vk {
 
+//! Push constant range covering a whole T, at offset
+template <typename T>
+constexpr VkPushConstantRange push_constant_range(VkShaderStageFlags stages, uint32_t offset = 0)
+{
+   static_assert(sizeof(T) % 4 == 0, "push constant size must be a multiple of 4");
+   return VkPushConstantRange{
+       .stageFlags = stages, .offset = offset, .size = static_cast<uint32_t>(sizeof(T))};
+}
+
 class PipelineLayout {
   public:
    PipelineLayout() = default;
    static std::expected<PipelineLayout, error::Error> create(Device* device,
                                                              const DescriptorSetLayout* dsl,
                                                              VkPipelineLayoutCreateFlags flags = 0);
+   //! Ranges are validated against maxPushConstantsSize (at least 128 bytes on every device),
+   //! a stage may appear in one range only
+   static std::expected<PipelineLayout, error::Error> create(
+       Device* device,
+       const DescriptorSetLayout* dsl,
+       std::span<const VkPushConstantRange> push_constant_ranges,
+       VkPipelineLayoutCreateFlags flags = 0);
+   //! Multiple descriptor sets, set i uses set_layouts[i]
+   static std::expected<PipelineLayout, error::Error> create(
+       Device* device,
+       std::span<const DescriptorSetLayout* const> set_layouts,
+       std::span<const VkPushConstantRange> push_constant_ranges = {},
+       VkPipelineLayoutCreateFlags flags = 0);
 
    ~PipelineLayout();
 
@@ -27,12 +53,26 @@ class PipelineLayout {
 
    operator VkPipelineLayout() const { return _layout; }
    [[nodiscard]] VkPipelineLayout vk() const { return _layout; }
+   [[nodiscard]] std::span<const VkPushConstantRange> push_constant_ranges() const
+   {
+      return _push_constant_ranges;
+   }
 
   private:
    Device* _device{nullptr};
    VkPipelineLayout _layout{VK_NULL_HANDLE};
+   std::vector<VkPushConstantRange> _push_constant_ranges{};
 };
 
+//! Attachment formats of a dynamic rendering pass, replaces the render pass at pipeline creation
+struct RenderingFormats {
+   std::vector<VkFormat> color_formats{};
+   VkFormat depth_format{VK_FORMAT_UNDEFINED};
+   VkFormat stencil_format{VK_FORMAT_UNDEFINED};
+};
+//! Color attachments in order and the depth attachment of a single pass configuration
+RenderingFormats rendering_formats(const GraphicsConfiguration::Shared& shared);
+
 class GraphicsPipeline {
   public:
    GraphicsPipeline() = default;
@@ -44,6 +84,24 @@ class GraphicsPipeline {
        RenderPass* render_pass,
        VkVertexInputBindingDescription binding_description,
        const std::array<VkVertexInputAttributeDescription, 4>& attribute_description);
+   //! Multiple vertex streams, e.g. per vertex + per instance bindings
+   static std::expected<GraphicsPipeline, error::Error> create(
+       ShaderModule* vert_shader,
+       ShaderModule* frag_shader,
+       Device* device,
+       PipelineLayout* layout,
+       RenderPass* render_pass,
+       std::span<const VkVertexInputBindingDescription> binding_descriptions,
+       std::span<const VkVertexInputAttributeDescription> attribute_descriptions);
+   //! Dynamic rendering (Vulkan 1.3), not tied to a render pass, only to the attachment formats
+   static std::expected<GraphicsPipeline, error::Error> create(
+       ShaderModule* vert_shader,
+       ShaderModule* frag_shader,
+       Device* device,
+       PipelineLayout* layout,
+       const RenderingFormats& formats,
+       std::span<const VkVertexInputBindingDescription> binding_descriptions,
+       std::span<const VkVertexInputAttributeDescription> attribute_descriptions);
    ~GraphicsPipeline();
 
    GraphicsPipeline(const GraphicsPipeline&) = delete;
@@ -54,6 +112,40 @@ class GraphicsPipeline {
 
    [[nodiscard]] VkPipeline vk() const { return _pipeline; }
 
+  private:
+   //! Exactly one of render_pass and formats is set
+   static std::expected<GraphicsPipeline, error::Error> create_impl(
+       ShaderModule* vert_shader,
+       ShaderModule* frag_shader,
+       Device* device,
+       PipelineLayout* layout,
+       const RenderPass* render_pass,
+       const RenderingFormats* formats,
+       std::span<const VkVertexInputBindingDescription> binding_descriptions,
+       std::span<const VkVertexInputAttributeDescription> attribute_descriptions);
+
+   PipelineLayout* _layout{nullptr};
+   Device* _device{nullptr};
+   VkPipeline _pipeline{VK_NULL_HANDLE};
+};
+
+class ComputePipeline {
+  public:
+   ComputePipeline() = default;
+   static std::expected<ComputePipeline, error::Error> create(ShaderModule* compute_shader,
+                                                              Device* device,
+                                                              PipelineLayout* layout);
+   ~ComputePipeline();
+
+   ComputePipeline(const ComputePipeline&) = delete;
+   ComputePipeline& operator=(const ComputePipeline&) = delete;
+
+   ComputePipeline(ComputePipeline&&) noexcept;
+   ComputePipeline& operator=(ComputePipeline&&) noexcept;
+
+   [[nodiscard]] VkPipeline vk() const { return _pipeline; }
+   [[nodiscard]] PipelineLayout* layout() const { return _layout; }
+
   private:
    PipelineLayout* _layout{nullptr};
    Device* _device{nullptr};
@@ -31,6 +31,11 @@ class Queue {
    ~Queue() = default;
 
    [[nodiscard]] VkQueue vk() const { return _queue; }
+   [[nodiscard]] uint32_t family_index() const { return _configuration._queue_family_index; }
+   [[nodiscard]] uint32_t index() const { return _queue_index; }
+   //! Roles this queue serves, see Device::queue
+   [[nodiscard]] bool has_type(QueueFamilyType type) const { return _types.contains(type); }
+   void add_type(QueueFamilyType type) { _types.insert(type); }
 
   private:
    QueueConfiguration _configuration;
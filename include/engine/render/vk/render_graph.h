@@ -0,0 +1,211 @@
+#pragma once
+
+#include <vulkan/vulkan_core.h>
+
+#include <expected>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "core/error.h"
+#include "engine/render/vk/command.h"
+#include "engine/render/vk/device.h"
+#include "engine/render/vk/gpu_profiler.h"
+
+namespace meddl::render::vk {
+
+//! How a pass touches a resource, decides the stages, access and image layout of the barriers
+enum class ResourceUsage : uint8_t {
+   // Images
+   ColorAttachment,
+   DepthAttachment,
+   DepthRead,  // Depth test without writes and/or sampled, read only layout
+   SampledFragment,
+   SampledCompute,
+   StorageRead,  // Compute, images in GENERAL
+   StorageWrite,
+   TransferSrc,
+   TransferDst,
+   Present,
+   // Buffers
+   IndirectRead,
+   VertexRead,
+   IndexRead,
+   UniformRead,
+};
+
+struct ResourceUsageInfo {
+   VkPipelineStageFlags2 stages;
+   VkAccessFlags2 access;
+   VkImageLayout layout;
+   VkImageUsageFlags image_usage;
+   bool write;
+};
+ResourceUsageInfo resource_usage_info(ResourceUsage usage);
+
+struct RGImage {
+   static constexpr uint32_t invalid = std::numeric_limits<uint32_t>::max();
+   uint32_t index{invalid};
+   [[nodiscard]] bool valid() const { return index != invalid; }
+};
+
+struct RGBuffer {
+   static constexpr uint32_t invalid = std::numeric_limits<uint32_t>::max();
+   uint32_t index{invalid};
+   [[nodiscard]] bool valid() const { return index != invalid; }
+};
+
+struct TransientImageDesc {
+   VkFormat format{VK_FORMAT_R8G8B8A8_UNORM};
+   VkExtent2D extent{};
+   VkImageAspectFlags aspect{VK_IMAGE_ASPECT_COLOR_BIT};
+};
+
+//! Frame graph of passes and the resources they read and write
+//! Passes run in the order they are added. compile():
+//!  - culls passes whose writes are never read, imported resources and passes marked with
+//!    side_effects() are always kept. Only read() keeps earlier writers alive, a pass that
+//!    blends into or loads an image declares both read() and write()
+//!  - computes the barriers between passes, batched into one vkCmdPipelineBarrier2 per pass,
+//!    only where there is a hazard or a layout change
+//!  - creates the transient images and aliases those with disjoint lifetimes in the same memory
+//! execute() records the barriers and calls each surviving pass.
+//! Built once and executed every frame, swap the per frame imports (e.g. the swapchain image)
+//! with update_import. Requires synchronization2 (Vulkan 1.3)
+//! @note Passes using a VkRenderPass must have its initial/final layouts match the declared usage
+class RenderGraph {
+  public:
+   using ExecuteFn = std::function<void(CommandBuffer& cmd, const RenderGraph& graph)>;
+
+   class PassBuilder {
+     public:
+      PassBuilder& read(RGImage image, ResourceUsage usage);
+      PassBuilder& write(RGImage image, ResourceUsage usage);
+      PassBuilder& read(RGBuffer buffer, ResourceUsage usage);
+      PassBuilder& write(RGBuffer buffer, ResourceUsage usage);
+      //! Never cull this pass, e.g. it writes to host visible memory or queries
+      PassBuilder& side_effects();
+
+     private:
+      friend class RenderGraph;
+      PassBuilder(RenderGraph* graph, uint32_t pass) : _graph(graph), _pass(pass) {}
+      RenderGraph* _graph;
+      uint32_t _pass;
+   };
+
+   struct Stats {
+      uint32_t passes{0};
+      uint32_t culled_passes{0};
+      uint32_t barriers{0};
+      uint32_t barrier_batches{0};
+      VkDeviceSize transient_bytes{0};  // Sum of all transient image sizes
+      VkDeviceSize allocated_bytes{0};  // Memory actually allocated after aliasing
+   };
+
+   RenderGraph() = default;
+   ~RenderGraph();
+
+   RenderGraph(const RenderGraph&) = delete;
+   RenderGraph& operator=(const RenderGraph&) = delete;
+   RenderGraph(RenderGraph&&) noexcept;
+   RenderGraph& operator=(RenderGraph&&) noexcept;
+
+   //! External image, e.g. the swapchain image or a persistent texture
+   //! initial_layout is the layout the image is in when the graph starts executing,
+   //! final_usage is transitioned to after the last pass
+   RGImage import_image(std::string name,
+                        VkImage image,
+                        VkImageView view,
+                        VkImageAspectFlags aspect,
+                        VkImageLayout initial_layout,
+                        std::optional<ResourceUsage> final_usage = std::nullopt);
+   void update_import(RGImage image, VkImage handle, VkImageView view);
+   RGBuffer import_buffer(std::string name, VkBuffer buffer);
+   //! Image owned by the graph, contents are undefined at the first pass using it each frame
+   RGImage create_image(std::string name, const TransientImageDesc& desc);
+
+   PassBuilder add_pass(std::string name, ExecuteFn execute);
+
+   std::expected<void, error::Error> compile(Device* device);
+   //! With a profiler, every pass is timed as a region named after it
+   std::expected<void, error::Error> execute(CommandBuffer* cmd, GpuProfiler* profiler = nullptr);
+   //! Drop all passes and resources, e.g. before rebuilding on resize
+   void reset();
+
+   [[nodiscard]] VkImage image(RGImage image) const { return _images.at(image.index).image; }
+   [[nodiscard]] VkImageView view(RGImage image) const { return _images.at(image.index).view; }
+   [[nodiscard]] VkBuffer buffer(RGBuffer buffer) const
+   {
+      return _buffers.at(buffer.index).buffer;
+   }
+   [[nodiscard]] bool is_culled(const std::string& pass) const;
+   [[nodiscard]] const Stats& stats() const { return _stats; }
+
+  private:
+   struct Access {
+      uint32_t resource;
+      bool is_image;
+      VkPipelineStageFlags2 stages;
+      VkAccessFlags2 access;
+      VkImageLayout layout;
+      bool write;
+      bool read;  // Declared with read(), the pass depends on the earlier contents
+   };
+
+   struct Barrier {
+      uint32_t resource;
+      bool is_image;
+      VkPipelineStageFlags2 src_stages;
+      VkAccessFlags2 src_access;
+      VkPipelineStageFlags2 dst_stages;
+      VkAccessFlags2 dst_access;
+      VkImageLayout old_layout;
+      VkImageLayout new_layout;
+   };
+
+   struct Pass {
+      std::string name;
+      ExecuteFn execute;
+      std::vector<Access> accesses{};
+      std::vector<Barrier> barriers{};
+      bool side_effects{false};
+      bool alive{false};
+   };
+
+   struct ImageResource {
+      std::string name;
+      VkImage image{VK_NULL_HANDLE};
+      VkImageView view{VK_NULL_HANDLE};
+      VkImageAspectFlags aspect{VK_IMAGE_ASPECT_COLOR_BIT};
+      VkImageLayout initial_layout{VK_IMAGE_LAYOUT_UNDEFINED};
+      std::optional<ResourceUsage> final_usage{};
+      bool transient{false};
+      TransientImageDesc desc{};
+      VkImageUsageFlags usage{0};
+   };
+
+   struct BufferResource {
+      std::string name;
+      VkBuffer buffer{VK_NULL_HANDLE};
+   };
+
+   void add_access(
+       uint32_t pass, uint32_t resource, bool is_image, ResourceUsage usage, bool write);
+   void cull_passes();
+   std::expected<void, error::Error> schedule_barriers();
+   std::expected<void, error::Error> create_transients();
+   void destroy_transients();
+
+   Device* _device{nullptr};
+   bool _compiled{false};
+   std::vector<Pass> _passes{};
+   std::vector<ImageResource> _images{};
+   std::vector<BufferResource> _buffers{};
+   std::vector<Barrier> _final_barriers{};
+   std::vector<VkDeviceMemory> _transient_memory{};
+   Stats _stats{};
+};
+
+}  // namespace meddl::render::vk
@@ -7,6 +7,8 @@
 
 #include <vulkan/vulkan.h>
 
+#include <algorithm>
+#include <optional>
 #include <vector>
 namespace {
 constexpr uint32_t MAX_DESCRIPTOR_SETS = 10;
@@ -53,11 +55,34 @@ struct GraphicsConfiguration {
                                     VK_COMPONENT_SWIZZLE_IDENTITY};
       VkImageCreateFlags image_flags{0};
       VkImageViewCreateFlags view_flags{0};
+      //! On top of the attachment usage, e.g. SAMPLED to read the depth buffer in a later pass
+      VkImageUsageFlags additional_usage{0};
+      //! Contents never leave the render pass (store DONT_CARE, read as input attachment)
+      //! Gets TRANSIENT_ATTACHMENT usage and lazily allocated memory where the device has it
+      bool transient{false};
+      //! First and last (sub)pass using the attachment, attachments with disjoint ranges may
+      //! share memory, see AttachmentSet
+      uint32_t first_pass{0};
+      uint32_t last_pass{0};
 
       [[nodiscard]] VkImageUsageFlags get_usage_flags() const
       {
-         return is_depth_stencil ? VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT
-                                 : VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+         return additional_usage |
+                (transient ? VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT : 0) |
+                (is_depth_stencil ? VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT
+                                  : VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT);
+      }
+
+      //! Color attachments presented at the end of the pass are backed by the swapchain images
+      [[nodiscard]] bool is_swapchain_image() const
+      {
+         return !is_depth_stencil && final_layout == VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+      }
+
+      //! Live in a common (sub)pass, such attachments never share memory
+      [[nodiscard]] bool overlaps(const AttachmentConfig& other) const
+      {
+         return first_pass <= other.last_pass && other.first_pass <= last_pass;
       }
 
       [[nodiscard]] VkImageAspectFlags get_aspect_mask() const
@@ -146,6 +171,7 @@ struct GraphicsConfiguration {
 
    struct RenderPassConfiguration {
       std::vector<std::vector<VkAttachmentReference>> color_references{};
+      std::vector<std::vector<VkAttachmentReference>> input_references{};
       std::vector<VkAttachmentReference> depth_references{};
       std::vector<VkSubpassDescription> subpasses{};
       std::vector<VkSubpassDependency> dependencies{};
@@ -176,6 +202,8 @@ struct GraphicsConfiguration {
 
    struct DescriptorSetLayoutConfiguration {
       std::vector<VkDescriptorSetLayoutBinding> bindings{};
+      //! Optional, one entry per binding (descriptor indexing, Vulkan 1.2)
+      std::vector<VkDescriptorBindingFlags> binding_flags{};
       VkDescriptorSetLayoutCreateFlags flags{0};
       VkAllocationCallbacks* custom_allocator{nullptr};
    };
@@ -206,6 +234,65 @@ struct GraphicsConfiguration {
                         .descriptorCount = 1,
                         .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
                         .pImmutableSamplers = nullptr}}};
+
+      //! Per draw data from the FrameAllocator, selected with dynamic offsets at bind time
+      DescriptorSetLayoutConfiguration ubo_dynamic_sampler = {
+          .bindings = {{.binding = 0,
+                        .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+                        .descriptorCount = 1,
+                        .stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+                        .pImmutableSamplers = nullptr},
+                       {.binding = 1,
+                        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                        .descriptorCount = 1,
+                        .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
+                        .pImmutableSamplers = nullptr}}};
+
+      //! Culling params, objects in, indirect commands out, draw count out
+      DescriptorSetLayoutConfiguration culling = {
+          .bindings = {{.binding = 0,
+                        .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                        .descriptorCount = 1,
+                        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+                        .pImmutableSamplers = nullptr},
+                       {.binding = 1,
+                        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                        .descriptorCount = 1,
+                        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+                        .pImmutableSamplers = nullptr},
+                       {.binding = 2,
+                        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                        .descriptorCount = 1,
+                        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+                        .pImmutableSamplers = nullptr},
+                       {.binding = 3,
+                        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                        .descriptorCount = 1,
+                        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+                        .pImmutableSamplers = nullptr},
+                       {.binding = 4,
+                        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                        .descriptorCount = 1,
+                        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+                        .pImmutableSamplers = nullptr},
+                       {.binding = 5,
+                        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                        .descriptorCount = 1,
+                        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+                        .pImmutableSamplers = nullptr}}};
+
+      //! Depth pyramid reduction, previous level in, next level out
+      DescriptorSetLayoutConfiguration depth_reduce = {
+          .bindings = {{.binding = 0,
+                        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                        .descriptorCount = 1,
+                        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+                        .pImmutableSamplers = nullptr},
+                       {.binding = 1,
+                        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+                        .descriptorCount = 1,
+                        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+                        .pImmutableSamplers = nullptr}}};
    } descriptor_layouts;
 
    struct DescriptorPoolConfig {
@@ -229,6 +316,22 @@ struct GraphicsConfiguration {
       DescriptorPoolConfig ubo_only = {.max_sets = MAX_DESCRIPTOR_SETS,
                                        .pool_sizes = {{.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
                                                        .descriptorCount = MAX_DESCRIPTOR_SETS}}};
+
+      DescriptorPoolConfig ubo_dynamic = {
+          .max_sets = MAX_DESCRIPTOR_SETS,
+          .pool_sizes = {{.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+                          .descriptorCount = MAX_DESCRIPTOR_SETS},
+                         {.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                          .descriptorCount = MAX_DESCRIPTOR_SETS}}};
+
+      DescriptorPoolConfig culling = {
+          .max_sets = MAX_DESCRIPTOR_SETS,
+          .pool_sizes = {{.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                          .descriptorCount = MAX_DESCRIPTOR_SETS},
+                         {.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                          .descriptorCount = MAX_DESCRIPTOR_SETS * 4},
+                         {.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                          .descriptorCount = MAX_DESCRIPTOR_SETS}}};
    } descriptor_pools;
 
    //! Configurations that apply do multiple components
@@ -237,12 +340,28 @@ struct GraphicsConfiguration {
       VkSurfaceFormatKHR surface_format{VK_FORMAT_B8G8R8A8_UNORM,
                                         VK_COLOR_SPACE_SRGB_NONLINEAR_KHR};
 
+      //! True if AttachmentSet may put the attachment in the same memory as another one
+      [[nodiscard]] bool may_alias(size_t index) const
+      {
+         const auto& config = attachments[index];
+         if (config.is_swapchain_image()) {
+            return false;
+         }
+         return std::ranges::any_of(attachments, [&](const AttachmentConfig& other) {
+            return !other.is_swapchain_image() && !config.overlaps(other);
+         });
+      }
+
+      //! Aliased attachments are flagged VK_ATTACHMENT_DESCRIPTION_MAY_ALIAS_BIT
       [[nodiscard]] std::vector<VkAttachmentDescription> get_attachment_descriptions() const
       {
          std::vector<VkAttachmentDescription> result;
          result.reserve(attachments.size());
-         for (const auto& config : attachments) {
-            result.push_back(config.get_attachment_description());
+         for (size_t i = 0; i < attachments.size(); i++) {
+            auto& description = result.emplace_back(attachments[i].get_attachment_description());
+            if (may_alias(i)) {
+               description.flags |= VK_ATTACHMENT_DESCRIPTION_MAY_ALIAS_BIT;
+            }
          }
          return result;
       }
@@ -297,17 +416,49 @@ constexpr GraphicsConfiguration::AttachmentConfig make_depth_attachment(VkFormat
    return config;
 }
 
+// Keep the depth attachment around after the renderpass so it can feed a depth pyramid
+inline void enable_depth_pyramid(GraphicsConfiguration& config)
+{
+   for (auto& attachment : config.shared.attachments) {
+      if (attachment.is_depth_stencil) {
+         attachment.store_op = VK_ATTACHMENT_STORE_OP_STORE;
+         attachment.additional_usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+      }
+   }
+}
+
+// Render into an owned image instead of the swapchain image, left in TRANSFER_SRC for readback
+// Returns the index of the attachment that would have been presented
+inline std::optional<uint32_t> apply_offscreen(GraphicsConfiguration& config)
+{
+   for (uint32_t i = 0; i < config.shared.attachments.size(); i++) {
+      auto& attachment = config.shared.attachments[i];
+      if (attachment.is_swapchain_image()) {
+         attachment.final_layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+         attachment.additional_usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+         return i;
+      }
+   }
+   return std::nullopt;
+}
+
 // Helper function to create a G-buffer attachment config
+// Written by the geometry subpass and read as an input attachment by the lighting subpass, so it
+// never has to leave tile memory
 constexpr GraphicsConfiguration::AttachmentConfig make_gbuffer_attachment(VkFormat format)
 {
    GraphicsConfiguration::AttachmentConfig config{};
    config.format = format;
    config.samples = VK_SAMPLE_COUNT_1_BIT;
    config.load_op = VK_ATTACHMENT_LOAD_OP_CLEAR;
-   config.store_op = VK_ATTACHMENT_STORE_OP_STORE;
+   config.store_op = VK_ATTACHMENT_STORE_OP_DONT_CARE;
    config.initial_layout = VK_IMAGE_LAYOUT_UNDEFINED;
    config.final_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
    config.is_depth_stencil = false;
+   config.additional_usage = VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+   config.transient = true;
+   config.first_pass = 0;
+   config.last_pass = 1;
    return config;
 }
 
@@ -340,9 +491,12 @@ inline GraphicsConfiguration::RenderPassConfiguration make_renderpass(
    subpass.colorAttachmentCount = static_cast<uint32_t>(config.color_references[0].size());
    subpass.pColorAttachments =
        config.color_references[0].empty() ? nullptr : config.color_references[0].data();
-   meddl::log::info("in factory: subpass pAttahcment color size {}, layout: {}",
-                    static_cast<int32_t>(subpass.colorAttachmentCount),
-                    static_cast<int32_t>(subpass.pColorAttachments->layout));
+   MEDDL_LOG_DEBUG(MEDDL_LOG_SITE(),
+                   "in factory: subpass pAttahcment color size {}, layout: {}",
+                   static_cast<int32_t>(subpass.colorAttachmentCount),
+                   subpass.pColorAttachments
+                       ? static_cast<int32_t>(subpass.pColorAttachments->layout)
+                       : -1);
 
    // Add depth attachment if one exists
    if (!config.depth_references.empty()) {
@@ -373,6 +527,71 @@ inline GraphicsConfiguration::RenderPassConfiguration make_renderpass(
    return config;
 }
 
+// Two subpasses: geometry writes the G-buffer and depth, lighting reads the G-buffer as input
+// attachments and writes the swapchain image. Attachment order as in apply_deferred_rendering
+inline GraphicsConfiguration::RenderPassConfiguration make_deferred_renderpass(
+    const GraphicsConfiguration::Shared& shared)
+{
+   GraphicsConfiguration::RenderPassConfiguration config;
+   config.color_references.resize(2);
+   config.input_references.resize(2);
+
+   for (size_t i = 0; i < shared.attachments.size(); ++i) {
+      const auto& attachment = shared.attachments[i];
+      const auto index = static_cast<uint32_t>(i);
+      if (attachment.is_depth_stencil) {
+         config.depth_references.push_back(
+             {index, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL});
+      }
+      else if (attachment.is_swapchain_image()) {
+         config.color_references[1].push_back({index, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL});
+      }
+      else {
+         config.color_references[0].push_back({index, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL});
+         config.input_references[1].push_back({index, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL});
+      }
+   }
+
+   for (size_t i = 0; i < 2; ++i) {
+      VkSubpassDescription subpass = {};
+      subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+      subpass.colorAttachmentCount = static_cast<uint32_t>(config.color_references[i].size());
+      subpass.pColorAttachments =
+          config.color_references[i].empty() ? nullptr : config.color_references[i].data();
+      subpass.inputAttachmentCount = static_cast<uint32_t>(config.input_references[i].size());
+      subpass.pInputAttachments =
+          config.input_references[i].empty() ? nullptr : config.input_references[i].data();
+      if (i == 0 && !config.depth_references.empty()) {
+         subpass.pDepthStencilAttachment = &config.depth_references[0];
+      }
+      config.subpasses.push_back(subpass);
+   }
+
+   VkSubpassDependency external = {};
+   external.srcSubpass = VK_SUBPASS_EXTERNAL;
+   external.dstSubpass = 0;
+   external.srcStageMask =
+       VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+   external.dstStageMask =
+       VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+   external.srcAccessMask = 0;
+   external.dstAccessMask =
+       VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+   config.dependencies.push_back(external);
+
+   // By region, each tile's G-buffer is consumed where it was produced
+   VkSubpassDependency gbuffer = {};
+   gbuffer.srcSubpass = 0;
+   gbuffer.dstSubpass = 1;
+   gbuffer.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+   gbuffer.dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+   gbuffer.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+   gbuffer.dstAccessMask = VK_ACCESS_INPUT_ATTACHMENT_READ_BIT;
+   gbuffer.dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+   config.dependencies.push_back(gbuffer);
+   return config;
+}
+
 // Apply forward rendering preset to an existing config
 inline void apply_forward_rendering(GraphicsConfiguration& config,
                                     VkFormat color_format = VK_FORMAT_B8G8R8A8_UNORM,
@@ -419,11 +638,15 @@ inline void apply_deferred_rendering(GraphicsConfiguration& config,
    config.shared.attachments.push_back(make_gbuffer_attachment(albedo_format));    // Albedo
 
    // Final color output
-   config.shared.attachments.push_back(make_color_attachment(color_format));
+   auto color_attachment = make_color_attachment(color_format);
+   color_attachment.first_pass = 1;
+   color_attachment.last_pass = 1;
+   config.shared.attachments.push_back(color_attachment);
 
-   // Depth attachment
+   // Depth attachment, only tested in the geometry subpass
    auto depth_attachment = make_depth_attachment(depth_format);
-   depth_attachment.final_layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+   depth_attachment.final_layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+   depth_attachment.transient = true;
    config.shared.attachments.push_back(depth_attachment);
 
    // Surface format
@@ -433,6 +656,8 @@ inline void apply_deferred_rendering(GraphicsConfiguration& config,
    // Swapchain config suitable for deferred rendering
    config.swapchain_config.image_usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
    config.swapchain_config.min_image_count = 2;
+
+   config.renderpass_config = make_deferred_renderpass(config.shared);
 }
 
 // Create commonly used config templates as functions
@@ -4,6 +4,7 @@
 
 #include "GLFW/glfw3.h"
 #include "core/error.h"
+#include "engine/render/vk/attachments.h"
 #include "engine/render/vk/device.h"
 #include "engine/render/vk/hash.hpp"
 #include "engine/render/vk/image.h"
@@ -16,11 +17,20 @@ namespace meddl::render::vk {
 class Swapchain {
   public:
    Swapchain() = default;
+   //! renderpass may be nullptr for dynamic rendering, then no framebuffers are created
    static std::expected<Swapchain, error::Error> create(Device* device,
                                                         Surface* surface,
                                                         const RenderPass* renderpass,
                                                         const GraphicsConfiguration& config,
                                                         const glfw::FrameBufferSize& fbs);
+   //! No VkSwapchainKHR, renders into an owned image instead, e.g. for headless rendering
+   //! color_attachment is the attachment read back, see presets::apply_offscreen
+   static std::expected<Swapchain, error::Error> create_offscreen(
+       Device* device,
+       const RenderPass* renderpass,
+       const GraphicsConfiguration& config,
+       VkExtent2D extent,
+       uint32_t color_attachment);
    ~Swapchain();
 
    Swapchain(const Swapchain&) = delete;
@@ -32,13 +42,41 @@ class Swapchain {
 
    [[nodiscard]] VkExtent2D extent() const { return _extent2d; }
    [[nodiscard]] VkSwapchainKHR vk() const { return _swapchain; }
+   [[nodiscard]] bool is_offscreen() const { return _offscreen; }
+   //! Attachment index of the presented (offscreen: read back) image
+   [[nodiscard]] uint32_t color_attachment() const { return _color_attachment; }
    [[nodiscard]] const GraphicsConfiguration& config() const { return _config; }
+   //! nullptr if the configuration has no depth attachment
+   [[nodiscard]] const Image* depth_image() const
+   {
+      for (size_t i = 0; i < _config.shared.attachments.size(); i++) {
+         if (_config.shared.attachments[i].is_depth_stencil) {
+            return _attachments.image(i);
+         }
+      }
+      return nullptr;
+   }
+   //! Images of the attachments that are not swapchain images
+   [[nodiscard]] const AttachmentSet& attachments() const { return _attachments; }
 
+   //! Offscreen there is one image, owned by the attachments
+   [[nodiscard]] const Image& image(uint32_t index) const
+   {
+      return _offscreen ? *_attachments.image(_color_attachment) : _images.at(index);
+   }
+   [[nodiscard]] uint32_t image_count() const
+   {
+      return _offscreen ? 1 : static_cast<uint32_t>(_images.size());
+   }
    [[nodiscard]] const std::vector<VkFramebuffer>& get_framebuffers() const
    {
       return _framebuffers;
    }
 
+   //! New swapchain created with old_swapchain as oldSwapchain, does not wait on the device
+   //! old_swapchain is retired: it can no longer acquire, but its images and framebuffers stay
+   //! valid until it is destroyed, which is only safe once the frames that used it are done.
+   //! Attachments (depth, ...) move over to the new swapchain when the extent is unchanged
    static std::expected<Swapchain, error::Error> recreate(Device* device,
                                                           Surface* surface,
                                                           const RenderPass* renderpass,
@@ -46,6 +84,15 @@ class Swapchain {
                                                           Swapchain& old_swapchain);
 
   private:
+   static std::expected<Swapchain, error::Error> create_impl(Device* device,
+                                                             Surface* surface,
+                                                             const RenderPass* renderpass,
+                                                             const GraphicsConfiguration& config,
+                                                             const glfw::FrameBufferSize& fbs,
+                                                             Swapchain* old_swapchain);
+
+   //! One per image, the swapchain attachment bound to that image
+   std::expected<void, error::Error> create_framebuffers(const RenderPass* renderpass);
    //! Swapchain needs to be manually destroyed on recreation, so allow this here
    void deinit();
 
@@ -55,9 +102,11 @@ class Swapchain {
    GraphicsConfiguration _config;
 
    VkExtent2D _extent2d{};
+   bool _offscreen{false};
+   uint32_t _color_attachment{0};
    std::unordered_set<VkSurfaceFormatKHR> _formats{};
    std::unordered_set<VkPresentModeKHR> _present_modes{};
-   std::optional<Image> _depth_image{std::nullopt};
+   AttachmentSet _attachments{};
    // std::vector<VkImage> _images{};
    std::vector<Image> _images{};
    // std::vector<VkImageView> _image_views{};
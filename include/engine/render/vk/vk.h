@@ -1,14 +1,24 @@
 #pragma once
 
 #include "engine/render/vk/async.h"
+#include "engine/render/vk/async_compute.h"
+#include "engine/render/vk/attachments.h"
+#include "engine/render/vk/bindless.h"
 #include "engine/render/vk/buffer.h"
 #include "engine/render/vk/command.h"
+#include "engine/render/vk/culling.h"
 #include "engine/render/vk/debug.h"
+#include "engine/render/vk/depth_pyramid.h"
 #include "engine/render/vk/descriptor.h"
+#include "engine/render/vk/descriptor_allocator.h"
 #include "engine/render/vk/device.h"
+#include "engine/render/vk/frame_allocator.h"
+#include "engine/render/vk/frame_pacer.h"
+#include "engine/render/vk/gpu_profiler.h"
 #include "engine/render/vk/instance.h"
 #include "engine/render/vk/pipeline.h"
 #include "engine/render/vk/queue.h"
+#include "engine/render/vk/render_graph.h"
 #include "engine/render/vk/sampler.h"
 #include "engine/render/vk/shader.h"
 #include "engine/render/vk/surface.h"
@@ -1,8 +1,21 @@
 #pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <span>
 #include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
+#include "core/metrics.h"
+#include "core/trace.h"
+#include "core/triple_buffer.h"
 #include "engine/gpu_types.h"
 #include "engine/loader.h"
 #include "engine/render/vk/texture.h"
@@ -18,7 +31,44 @@ struct render_config {
    int32_t window_height = 160;
    std::string title{"Meddl Engine"};
    bool enable_debugger{true};
-   bool vsync{true};
+   vk::PresentPolicy present_policy{vk::PresentPolicy::Vsync};
+   uint32_t frames_in_flight{2};
+   //! Wait for the previous present before the next frame when the device supports it
+   bool present_wait{true};
+   //! Record and submit on a dedicated thread, see Renderer::draw
+   bool render_thread{false};
+   //! Time the frame and its passes with timestamp queries, see Renderer::gpu_timings
+   bool gpu_profiling{false};
+   //! Log the change of every metric this often, 0 disables. Stops with the renderer
+   //! See core/metrics.h
+   std::chrono::milliseconds metrics_log_interval{0};
+};
+
+//! Everything a frame needs from the game thread, built by the draw calls and consumed by draw()
+struct FrameSnapshot {
+   struct InstanceBatch {
+      uint32_t first_instance;
+      uint32_t instance_count;
+   };
+   std::optional<glm::mat4> view{};
+   std::vector<InstanceData> instances{};
+   std::vector<InstanceBatch> batches{};
+   glfw::FrameBufferSize framebuffer_size{};
+   uint64_t swapchain_generation{0};  // Bumped on resize or draw(true)
+   uint64_t sequence{0};              // Number of the draw() that published it
+};
+
+//! A frame copied back from a headless renderer, rows are tightly packed
+struct FrameReadback {
+   uint32_t width{0};
+   uint32_t height{0};
+   VkFormat format{VK_FORMAT_UNDEFINED};
+   std::vector<uint8_t> pixels{};
+
+   [[nodiscard]] uint32_t bytes_per_pixel() const
+   {
+      return width * height > 0 ? static_cast<uint32_t>(pixels.size()) / (width * height) : 0;
+   }
 };
 
 class Renderer;
@@ -60,9 +110,46 @@ class RendererBuilder {
       return *this;
    }
 
+   //! Without vsync, MAILBOX is preferred over tearing, see present_policy for the others
    RendererBuilder& vsync(bool enable)
    {
-      _config.vsync = enable;
+      _config.present_policy = enable ? vk::PresentPolicy::Vsync : vk::PresentPolicy::LowLatency;
+      return *this;
+   }
+
+   RendererBuilder& present_policy(vk::PresentPolicy policy)
+   {
+      _config.present_policy = policy;
+      return *this;
+   }
+
+   RendererBuilder& frames_in_flight(uint32_t frames)
+   {
+      _config.frames_in_flight = frames;
+      return *this;
+   }
+
+   RendererBuilder& present_wait(bool enable)
+   {
+      _config.present_wait = enable;
+      return *this;
+   }
+
+   RendererBuilder& render_thread(bool enable)
+   {
+      _config.render_thread = enable;
+      return *this;
+   }
+
+   RendererBuilder& gpu_profiling(bool enable)
+   {
+      _config.gpu_profiling = enable;
+      return *this;
+   }
+
+   RendererBuilder& metrics_log_interval(std::chrono::milliseconds interval)
+   {
+      _config.metrics_log_interval = interval;
       return *this;
    }
 
@@ -77,7 +164,11 @@ class RendererBuilder {
 
 class Renderer {
   public:
-   Renderer(std::shared_ptr<glfw::Window> window);
+   Renderer(std::shared_ptr<glfw::Window> window, const render_config& config = {});
+   //! No window or surface, renders into an owned image that read_frame() copies back
+   //! Works on any device with a graphics queue, e.g. lavapipe in CI
+   //! @note Always one frame in flight, the window and present settings of config are ignored
+   static Renderer headless(uint32_t width, uint32_t height, const render_config& config = {});
    ~Renderer() = default;
 
    Renderer(const Renderer&) = delete;
@@ -88,36 +179,128 @@ class Renderer {
    void set_view_matrix(const glm::mat4 view_matrix);
    void set_vertices(const std::vector<Vertex>& vertices);
    void set_indices(const std::vector<uint32_t>& indices);
+   //! Uploads the textures and, when the device supports it, registers them in the bindless table
    void set_textures(const ModelData& data);
+   //! Fill the bindless material table, call after set_textures so texture slots resolve
+   void set_materials(const ModelData& data);
    void draw_vertices(uint32_t vertex_count = 0);
+   //! Queue instances of the current mesh for the next draw(), one draw call per call to this
+   //! material_ids is optional, missing entries default to 0
+   //! @note When instances are queued, the mesh is not drawn on its own that frame
+   void draw_instanced(std::span<const glm::mat4> transforms,
+                       std::span<const uint32_t> material_ids = {});
+   //! Blocks until the next frame can start, call before polling input to keep latency low
+   //! draw() waits as well, this only moves the wait in front of the input
+   //! With a render thread, blocks until it has picked up the last draw()
+   void wait_for_frame();
+   //! With a render thread, publishes the frame and returns, the render thread records and
+   //! submits it while the caller simulates the next one. Unpicked frames are replaced.
+   //! Rethrows what the render thread threw
    void draw(bool recreate_swapchain = false);
+   //! Headless only, waits for the last draw() and copies it to CPU memory
+   FrameReadback read_frame();
+   [[nodiscard]] bool is_headless() const { return _window == nullptr; }
 
    std::shared_ptr<glfw::Window> window() { return _window; };
+   //! For resources created outside the renderer, e.g. by benchmarks and tools
+   vk::Device* device() { return &_device; }
+   //! Per frame scratch memory for per draw uniforms, rewound at the start of every draw()
+   vk::FrameAllocator& frame_allocator() { return _frame_allocator; }
+   //! nullptr if the device lacks descriptor indexing
+   vk::BindlessTable* bindless() { return _bindless.get(); }
+   //! Updated by the render thread when there is one
+   [[nodiscard]] const vk::FramePacer& frame_pacer() const { return _frame_pacer; }
+   //! GPU time of the frame and each pass, a few frames behind. Empty without gpu_profiling
+   std::vector<vk::GpuProfiler::RegionStats> gpu_timings();
+   //! CPU trace events of every thread as Chrome trace JSON, merged with the last collected GPU
+   //! frame with gpu_profiling. See core/trace.h
+   std::string trace_json();
 
   private:
-   void update_uniform_buffer(uint32_t current_image);
+   //! Headless without a window, extent is only used then
+   Renderer(std::shared_ptr<glfw::Window> window, const render_config& config, VkExtent2D extent);
+   //! nullptr with dynamic rendering
+   const vk::RenderPass* renderpass() const
+   {
+      return _dynamic_rendering ? nullptr : &_renderpass;
+   }
+   struct RenderThread {
+      //! Wakes the thread so it sees the stop request, from the game thread
+      ~RenderThread()
+      {
+         thread.request_stop();
+         mailbox.publish();
+      }
+
+      async::TripleBuffer<FrameSnapshot> mailbox;
+      //! Held while rendering, and by the game thread while it replaces GPU resources
+      std::mutex mutex;
+      uint64_t published{0};               // Game thread only
+      std::atomic<uint64_t> picked_up{0};  // Sequence of the last frame taken from the mailbox
+      std::atomic<bool> failed{false};
+      std::exception_ptr error{};  // Set before failed
+      std::jthread thread;         // Last, joined before the rest goes away
+   };
+   void render_loop(std::stop_token stop);
+   //! Empty without a render thread
+   std::unique_lock<std::mutex> lock_render_thread();
+   void wait_for_gpu();
+   void render_frame(const FrameSnapshot& frame);
+   //! Viewport, pipeline, descriptors and draws, inside a render pass or dynamic rendering
+   void record_scene();
+   void build_render_graph();
+   void record_render_graph(uint32_t image_index);
+   //! Recreate from the current swapchain and retire it, false if recreation failed
+   bool rebuild_swapchain(const glfw::FrameBufferSize& framebuffer_size);
+   void release_retired_swapchains();
+   void update_uniform_buffer();
+   void upload_instances();
+   void record_instanced_draws();
    // "core"
    vk::Instance _instance;
-   std::shared_ptr<glfw::Window> _window{};
+   std::shared_ptr<glfw::Window> _window{};  // nullptr when headless
    vk::Surface _surface;
    vk::Device _device{};
 
    // Graphics
+   struct RetiredSwapchain {
+      vk::Swapchain swapchain;
+      uint64_t retired_at;  // _frame_count when it was replaced
+   };
    vk::Swapchain _swapchain{};
+   std::vector<RetiredSwapchain> _retired_swapchains{};
    vk::PipelineLayout _pipeline_layout{};
    vk::RenderPass _renderpass{};
    vk::GraphicsPipeline _graphics_pipeline{};
+   bool _dynamic_rendering{false};
+   //! Dynamic rendering only, transitions the swapchain and depth images around the pass
+   //! Built on the first draw(), its pass captures this
+   std::unique_ptr<vk::RenderGraph> _render_graph{};
+   vk::RGImage _color_target{};
+   vk::RGImage _depth_target{};
+   VkDescriptorSet _frame_set{VK_NULL_HANDLE};  // Current frame, for record_scene
    vk::CommandPool _command_pool{};
    std::vector<vk::CommandBuffer> _command_buffers{};
    std::unique_ptr<vk::Buffer> _vertex_buffer{};
    std::unique_ptr<vk::Buffer> _index_buffer{};
 
    std::vector<vk::Texture> _textures{};
+   std::unique_ptr<vk::BindlessTable> _bindless{};
+   std::unordered_map<std::string, vk::BindlessTexture> _texture_slots{};
+
+   // Instancing
+   vk::GraphicsPipeline _instanced_pipeline{};
+   std::unique_ptr<vk::ShaderModule> _instanced_vert_mod{};
+   std::unique_ptr<vk::ShaderModule> _instanced_frag_mod{};
+   std::vector<std::unique_ptr<vk::Buffer>> _instance_buffers{};  // Per frame, grown on demand
+   FrameSnapshot _pending{};              // Built by the game thread
+   const FrameSnapshot* _frame{nullptr};  // Being rendered, for record_scene
+   uint64_t _swapchain_generation{0};     // Last FrameSnapshot::swapchain_generation seen
 
    std::unique_ptr<vk::DescriptorSetLayout> _descriptor_set_layout{};
-   std::vector<vk::Buffer> _uniform_buffers{};
-   std::vector<vk::DescriptorPool> _descriptor_pools{};
-   std::vector<vk::DescriptorSet> _descriptor_sets{};
+   vk::FrameAllocator _frame_allocator{};
+   uint32_t _transform_offset{0};
+   std::vector<vk::DescriptorAllocator> _descriptor_allocators{};  // Per frame, reset in draw()
 
    // Shaders
    std::unique_ptr<vk::ShaderModule> _frag_mod{};
@@ -126,17 +309,42 @@ class Renderer {
    std::vector<uint32_t> _vert_spirv{};
 
    // Sync
+   vk::FramePacer _frame_pacer{};
+   //! nullptr unless gpu_profiling and the graphics queue has timestamps
+   std::unique_ptr<vk::GpuProfiler> _gpu_profiler{};
    std::vector<vk::Semaphore> _image_available{};
    std::vector<vk::Semaphore> _render_finished{};
    std::vector<vk::Fence> _fences{};
 
+   // Shared by every renderer, "render.*" in metrics::Registry
+   struct Metrics {
+      metrics::Counter* frames;
+      metrics::Counter* draw_calls;
+      metrics::Counter* triangles;
+      metrics::Histogram* frame_ms;  // Start to start of render_frame
+      metrics::Histogram* record_ms;
+      metrics::Histogram* submit_ms;
+      metrics::Histogram* present_ms;
+   };
+   Metrics _metrics{};
+   uint64_t _last_frame_start_ns{0};
+   //! Stops the metrics log sink this renderer started
+   struct MetricsLogSink {
+      ~MetricsLogSink() { metrics::Registry::instance().stop_log_sink(); }
+   };
+   std::unique_ptr<MetricsLogSink> _metrics_log_sink{};  // With metrics_log_interval
+
    // std::unique_ptr<render::vk::Texture> _texture;
 
    size_t _current_frame{0};
+   bool _frame_waited{false};  // wait_for_frame() was called ahead of draw()
+   uint64_t _frame_count{0};
    uint32_t _vertex_count{0};
    uint32_t _index_count{0};
-   glm::mat4 _view_matrix = glm::mat4(1.0f);
-   bool _camera_updated{false};
+
+   //! Started on the first draw(), it renders through this
+   //! Last, so the thread is stopped before anything it uses is destroyed
+   std::unique_ptr<RenderThread> _render_thread{};
 };
 }  // namespace meddl::render
 
@@ -10,7 +10,9 @@
 #include "GLFW/glfw3.h"
 #include "core/formatter_utils.h"
 #include "core/log.h"
+#include "engine/events/dispatcher.h"
 #include "engine/events/event.h"
+#include "engine/events/event_queue.h"
 
 namespace meddl::glfw {
 
@@ -25,7 +27,13 @@ class Window {
   public:
    Window() noexcept = default;
 
-   Window(GLFWwindow* window) : _handle(window, glfwDestroyWindow) {}
+   Window(GLFWwindow* window) : _handle(window, glfwDestroyWindow)
+   {
+      if (_handle) {
+         glfwSetWindowUserPointer(_handle.get(), this);
+         set_framebuffer_size_callback();
+      }
+   }
 
    Window(std::nullptr_t) noexcept : Window{} {}
 
@@ -44,6 +52,7 @@ class Window {
       (void)monitor;
       (void)share;
       glfwSetWindowUserPointer(_handle.get(), this);
+      set_framebuffer_size_callback();
    }
 
    ~Window() = default;
@@ -75,40 +84,137 @@ class Window {
    [[nodiscard]] bool is_resized() const { return _is_resized; }
    void reset_resized() { _is_resized = false; }
 
-   void poll_events() { glfwPollEvents(); }
+   //! Deferred, also dispatches everything queued by the callbacks in one batch
+   void poll_events()
+   {
+      glfwPollEvents();
+      if (_event_queue) {
+         _event_queue->drain([this](const auto& event) { deliver(event); });
+      }
+   }
+
+   //! Callbacks only queue events into a preallocated ring, poll_events() dispatches them
+   //! afterwards with runs of mouse moves, scrolls and resizes coalesced, see events::EventQueue
+   //! Keeps the callbacks short and the cost bounded when input floods in. Off by default
+   void set_deferred_events(bool deferred,
+                            size_t capacity = events::EventQueue::DEFAULT_CAPACITY)
+   {
+      if (_event_queue) {
+         _event_queue->drain([this](const auto& event) { deliver(event); });
+      }
+      _event_queue = deferred ? std::make_unique<events::EventQueue>(capacity) : nullptr;
+   }
+   //! nullptr unless deferred
+   [[nodiscard]] const events::EventQueue* event_queue() const { return _event_queue.get(); }
 
    void register_event_handler(events::EventHandler& handler)
    {
       _event_handler = &handler;
       glfwSetWindowUserPointer(_handle.get(), this);
+      set_key_callback();
+   }
+
+   //! Typed and allocation free, also gets mouse and resize events. Works next to a handler
+   //! Resizes come from the framebuffer size callback installed with the window
+   void register_event_dispatcher(events::EventDispatcher& dispatcher)
+   {
+      _event_dispatcher = &dispatcher;
+      glfwSetWindowUserPointer(_handle.get(), this);
+      set_key_callback();
+
+      glfwSetCursorPosCallback(_handle.get(), [](GLFWwindow* window, double x, double y) {
+         emit(window, events::MouseMoved{.x = static_cast<float>(x), .y = static_cast<float>(y)});
+      });
+      glfwSetMouseButtonCallback(
+          _handle.get(), [](GLFWwindow* window, int button, int action, int mods) {
+             const auto mouse_button = static_cast<events::MouseButton>(button);
+             const auto modifiers = static_cast<events::KeyModifier>(mods);
+             if (action == GLFW_PRESS) {
+                emit(window,
+                     events::MouseButtonPressed{.button = mouse_button, .modifiers = modifiers});
+             }
+             else if (action == GLFW_RELEASE) {
+                emit(window,
+                     events::MouseButtonReleased{.button = mouse_button, .modifiers = modifiers});
+             }
+          });
+      glfwSetScrollCallback(_handle.get(), [](GLFWwindow* window, double x, double y) {
+         emit(window,
+              events::MouseScrolled{.x_offset = static_cast<float>(x),
+                                    .y_offset = static_cast<float>(y)});
+      });
+      glfwSetWindowCloseCallback(
+          _handle.get(), [](GLFWwindow* window) { emit(window, events::WindowClose{}); });
+   }
+
+  private:
+   //! From a GLFW callback, queued when deferred
+   template <typename T>
+   static void emit(GLFWwindow* window, const T& event)
+   {
+      auto* self = static_cast<Window*>(glfwGetWindowUserPointer(window));
+      if (!self) return;
+      if (self->_event_queue) {
+         self->_event_queue->push(event);
+      }
+      else {
+         self->deliver(event);
+      }
+   }
+
+   //! The handler only ever got key events, the dispatcher gets everything
+   template <typename T>
+   void deliver(const T& event)
+   {
+      if (_event_dispatcher) {
+         _event_dispatcher->dispatch(event);
+      }
+      if constexpr (std::is_same_v<T, events::KeyPressed> ||
+                    std::is_same_v<T, events::KeyReleased>) {
+         if (_event_handler) {
+            auto wrapped = events::Event(T{event});
+            _event_handler->dispatch(wrapped);
+         }
+      }
+   }
 
+   //! Always installed, is_resized() works without a dispatcher, which also gets the event
+   void set_framebuffer_size_callback()
+   {
+      glfwSetFramebufferSizeCallback(_handle.get(), [](GLFWwindow* window, int width, int height) {
+         if (auto* self = static_cast<Window*>(glfwGetWindowUserPointer(window))) {
+            self->_is_resized = true;
+         }
+         emit(window,
+              events::WindowResize{.width = static_cast<uint32_t>(width),
+                                   .height = static_cast<uint32_t>(height)});
+      });
+   }
+
+   void set_key_callback()
+   {
       glfwSetKeyCallback(
           _handle.get(),
           [](GLFWwindow* window, int key, int scancode, int action, int mods) -> void {
-             auto* self = static_cast<Window*>(glfwGetWindowUserPointer(window));
-             if (!self || !self->_event_handler) return;
-
              auto keyCode = static_cast<events::Key>(key);
              auto modifiers = static_cast<events::KeyModifier>(mods);
 
-             if (action == GLFW_PRESS) {
-                auto event = events::createEvent<events::KeyPressed>(keyCode, modifiers, false);
-                self->_event_handler->dispatch(event);
+             if (action == GLFW_PRESS || action == GLFW_REPEAT) {
+                emit(window,
+                     events::KeyPressed{.keycode = keyCode,
+                                        .modifiers = modifiers,
+                                        .repeated = action == GLFW_REPEAT});
              }
              else if (action == GLFW_RELEASE) {
-                auto event = events::createEvent<events::KeyReleased>(keyCode, modifiers);
-                self->_event_handler->dispatch(event);
-             }
-             else if (action == GLFW_REPEAT) {
-                auto event = events::createEvent<events::KeyPressed>(keyCode, modifiers, true);
-                self->_event_handler->dispatch(event);
+                emit(window, events::KeyReleased{.keycode = keyCode, .modifiers = modifiers});
              }
           });
    }
 
-  private:
    bool _is_resized{false};
    events::EventHandler* _event_handler{nullptr};
+   events::EventDispatcher* _event_dispatcher{nullptr};
+   std::unique_ptr<events::EventQueue> _event_queue{};  // Deferred mode only
    std::unique_ptr<GLFWwindow, decltype(&glfwDestroyWindow)> _handle{nullptr, glfwDestroyWindow};
 };
 }  // namespace meddl::glfw
@@ -1,5 +1,6 @@
 #include "core/async.h"
 
+#include <array>
 #include <thread>
 
 #include "core/log.h"
@@ -37,10 +38,25 @@ void ThreadPoolManager::reset(std::optional<uint32_t> max_threads)
    meddl::log::debug("IO: {}", io_threads);
    _pools[PoolType::General] = std::make_unique<exec::static_thread_pool>(general_threads);
    meddl::log::debug("General: {}", general_threads);
+
+   metrics::gauge("pool.rendering.threads").set(render_threads);
+   metrics::gauge("pool.compute.threads").set(compute_threads);
+   metrics::gauge("pool.io.threads").set(io_threads);
+   metrics::gauge("pool.general.threads").set(general_threads);
+}
+
+metrics::Gauge& ThreadPoolManager::queued_gauge(PoolType type)
+{
+   static const std::array<metrics::Gauge*, 4> gauges = {
+       &metrics::gauge("pool.rendering.queued"),
+       &metrics::gauge("pool.compute.queued"),
+       &metrics::gauge("pool.io.queued"),
+       &metrics::gauge("pool.general.queued"),
+   };
+   return *gauges.at(static_cast<size_t>(type));
 }
 
-auto ThreadPoolManager::scheduler(PoolType type)
-    -> decltype(std::declval<exec::static_thread_pool>().get_scheduler())
+CountedScheduler ThreadPoolManager::scheduler(PoolType type)
 {
    auto it = _pools.find(type);
    if (it == _pools.end()) {
@@ -50,7 +66,7 @@ auto ThreadPoolManager::scheduler(PoolType type)
          it = _pools.find(PoolType::General);
       }
    }
-   return it->second->get_scheduler();
+   return {it->second->get_scheduler(), &queued_gauge(it->first)};
 }
 
 std::shared_ptr<exec::static_thread_pool> ThreadPoolManager::create_temporary_pool(
@@ -1,28 +1,232 @@
 #include "core/log.h"
 
+#include <algorithm>
+#include <condition_variable>
+#include <cstdlib>
 #include <mutex>
+#include <stop_token>
+#include <thread>
+#include <vector>
 
-#include "spdlog/async.h"
+#include "spdlog/details/log_msg.h"
+#include "spdlog/details/os.h"
 #include "spdlog/sinks/stdout_color_sinks.h"
 
 namespace {
-constexpr auto THREAD_POOL_SIZE = 8192;
-constexpr auto THREAD_COUNT = 1;
+//! Per thread, a few thousand messages between two backend passes
+constexpr size_t THREAD_BUFFER_SIZE = 256 * 1024;
+constexpr auto BACKEND_INTERVAL = std::chrono::milliseconds(2);
+
+using meddl::log::detail::RecordHeader;
+using meddl::log::detail::ThreadBuffer;
+
+std::mutex s_logger_mutex;
+
+class Backend {
+  public:
+   static Backend& instance()
+   {
+      // Leaked, threads may still log while statics are destroyed. The worker stops at exit,
+      // messages logged after that are drained by the thread logging them
+      static auto* backend = [] {
+         // The logger has to outlive the last drain at exit, so it is created first
+         meddl::log::get_logger();
+         auto* created = new Backend();
+         std::atexit([] { instance().stop(); });
+         return created;
+      }();
+      return *backend;
+   }
+
+   std::shared_ptr<ThreadBuffer> register_thread()
+   {
+      auto buffer =
+          std::make_shared<ThreadBuffer>(THREAD_BUFFER_SIZE, spdlog::details::os::thread_id());
+      const std::scoped_lock lock(_buffers_mutex);
+      _buffers.push_back(buffer);
+      return buffer;
+   }
+
+   void add_site(meddl::log::LogSite* site)
+   {
+      const std::scoped_lock lock(_sites_mutex);
+      _sites.push_back(site);
+   }
+
+   void remove_site(meddl::log::LogSite* site)
+   {
+      const std::scoped_lock lock(_sites_mutex);
+      std::erase(_sites, site);
+   }
+
+   //! Any thread, formats and writes every published record
+   void drain()
+   {
+      const std::scoped_lock drain_lock(_drain_mutex);
+      {
+         const std::scoped_lock lock(_buffers_mutex);
+         _draining = _buffers;
+      }
+      std::shared_ptr<spdlog::logger> logger;
+      {
+         const std::scoped_lock lock(s_logger_mutex);
+         logger = _exit_logger ? _exit_logger : meddl::log::get_logger();
+      }
+      for (const auto& buffer : _draining) {
+         while (const auto* record = buffer->peek()) {
+            write(*logger, *buffer, *record);
+            buffer->pop();
+         }
+      }
+
+      {
+         // Summaries of repeats that stopped, after the messages they follow
+         const auto now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                 std::chrono::steady_clock::now().time_since_epoch())
+                                 .count();
+         const std::scoped_lock lock(_sites_mutex);
+         for (auto* site : _sites) {
+            const auto pending = site->expire(now_ns);
+            if (pending.repeated > 0) {
+               _message = std::format("Last message repeated {} times", pending.repeated);
+               write(*logger, pending.level, spdlog::log_clock::now(), 0);
+            }
+            if (pending.suppressed > 0) {
+               _message =
+                   std::format("{} messages held back by the rate limit", pending.suppressed);
+               write(*logger, pending.level, spdlog::log_clock::now(), 0);
+            }
+         }
+      }
+
+      const auto lost = dropped();
+      if (lost > _reported_dropped) {
+         _message = std::format("Dropped {} log messages, thread buffers were full",
+                                lost - _reported_dropped);
+         write(*logger, spdlog::level::warn, spdlog::log_clock::now(), 0);
+         _reported_dropped = lost;
+      }
+      for (const auto& sink : logger->sinks()) {
+         sink->flush();
+      }
+
+      const std::scoped_lock lock(_buffers_mutex);
+      std::erase_if(_buffers, [this](const auto& buffer) {
+         if (!buffer->retired.load(std::memory_order_acquire) || buffer->peek()) {
+            return false;
+         }
+         _retired_dropped += buffer->dropped();
+         return true;
+      });
+      _draining.clear();
+   }
+
+   uint64_t dropped()
+   {
+      const std::scoped_lock lock(_buffers_mutex);
+      auto total = _retired_dropped;
+      for (const auto& buffer : _buffers) {
+         total += buffer->dropped();
+      }
+      return total;
+   }
+
+  private:
+   Backend()
+       : _worker([this](const std::stop_token& stop) {
+            std::mutex mutex;
+            std::unique_lock lock(mutex);
+            while (!stop.stop_requested()) {
+               drain();
+               _wake.wait_for(lock, stop, BACKEND_INTERVAL, [] { return false; });
+            }
+         })
+   {
+   }
+
+   void stop()
+   {
+      {
+         // get_logger()'s static may be destroyed before the last message
+         const std::scoped_lock lock(s_logger_mutex);
+         _exit_logger = meddl::log::get_logger();
+      }
+      _worker.request_stop();
+      if (_worker.joinable()) {
+         _worker.join();
+      }
+      meddl::log::detail::synchronous.store(true, std::memory_order_release);
+      drain();
+   }
+
+   void write(spdlog::logger& logger, ThreadBuffer& buffer, const RecordHeader& record)
+   {
+      _message.clear();
+      try {
+         record.format(std::string_view(record.fmt, record.fmt_size),
+                       reinterpret_cast<const std::byte*>(&record + 1),
+                       _message);
+      }
+      catch (const std::exception& e) {
+         _message = std::format("Bad log message \"{}\": {}",
+                                std::string_view(record.fmt, record.fmt_size),
+                                e.what());
+      }
+      const auto time = spdlog::log_clock::time_point(
+          std::chrono::duration_cast<spdlog::log_clock::duration>(
+              std::chrono::nanoseconds(record.time_ns)));
+      write(logger, record.level, time, buffer.thread_id());
+   }
+
+   //! Writes _message
+   void write(spdlog::logger& logger,
+              spdlog::level::level_enum level,
+              spdlog::log_clock::time_point time,
+              size_t thread_id)
+   {
+      if (!logger.should_log(level)) {
+         return;
+      }
+      spdlog::details::log_msg msg(time, spdlog::source_loc{}, logger.name(), level, _message);
+      msg.thread_id = thread_id;
+      for (const auto& sink : logger.sinks()) {
+         if (sink->should_log(level)) {
+            sink->log(msg);
+         }
+      }
+   }
+
+   std::shared_ptr<spdlog::logger> _exit_logger;  // Guarded by s_logger_mutex
+
+   std::mutex _sites_mutex;
+   std::vector<meddl::log::LogSite*> _sites;
+
+   std::mutex _buffers_mutex;
+   std::vector<std::shared_ptr<ThreadBuffer>> _buffers;
+   uint64_t _retired_dropped{0};
+
+   std::mutex _drain_mutex;  // Everything below is only touched while draining
+   std::vector<std::shared_ptr<ThreadBuffer>> _draining;
+   std::string _message;
+   uint64_t _reported_dropped{0};
+
+   std::condition_variable_any _wake;
+   std::jthread _worker;  // Last, starts draining right away
+};
 }  // namespace
+
 namespace meddl::log {
 std::shared_ptr<spdlog::logger>& get_logger()
 {
-   static std::mutex s_logger_mutex;
    static std::shared_ptr<spdlog::logger> s_logger;
    static std::once_flag s_init_flag;
 
    std::call_once(s_init_flag, []() {
-      spdlog::init_thread_pool(THREAD_POOL_SIZE, THREAD_COUNT);
+      // Formatting and the async hand off happen in the backend, the logger itself is plain
       auto console_sink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
-      s_logger = std::make_shared<spdlog::async_logger>(
-          "meddl", console_sink, spdlog::thread_pool(), spdlog::async_overflow_policy::block);
+      s_logger = std::make_shared<spdlog::logger>("meddl", console_sink);
       s_logger->set_pattern("%^[%H:%M:%S.%e] [%l] [%t] %v%$");
-      s_logger->set_level(spdlog::level::info);
+      s_logger->set_level(spdlog::level::trace);
       spdlog::register_logger(s_logger);
    });
 
@@ -31,20 +235,133 @@ std::shared_ptr<spdlog::logger>& get_logger()
 
 void init(spdlog::level::level_enum level)
 {
-   auto& logger = get_logger();
-   logger->set_level(level);
+   detail::runtime_level.store(level, std::memory_order_relaxed);
 }
 
 void set_logger(std::shared_ptr<spdlog::logger> logger)
 {
-   static std::mutex s_logger_mutex;
-   std::lock_guard<std::mutex> lock(s_logger_mutex);
-   get_logger() = logger;
+   flush();
+   const std::scoped_lock lock(s_logger_mutex);
+   get_logger() = std::move(logger);
 }
 
 void disable()
 {
-   get_logger()->set_level(spdlog::level::off);
+   detail::runtime_level.store(spdlog::level::off, std::memory_order_relaxed);
+}
+
+void flush()
+{
+   Backend::instance().drain();
+}
+
+uint64_t dropped()
+{
+   return Backend::instance().dropped();
+}
+
+LogSite::LogSite(double per_second, uint32_t burst, std::chrono::milliseconds repeat_interval)
+    : _interval_ns(static_cast<int64_t>(1e9 / std::max(per_second, 1e-9))),
+      _tolerance_ns(_interval_ns * (std::max(burst, 1u) - 1)),
+      _repeat_interval_ns(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(repeat_interval).count())
+{
+}
+
+LogSite::Decision LogSite::admit(uint64_t hash, int64_t now_ns, Level level)
+{
+   if (hash == _last_hash.load(std::memory_order_relaxed)) {
+      _repeated.fetch_add(1, std::memory_order_relaxed);
+      auto last = _last_emit_ns.load(std::memory_order_relaxed);
+      if (now_ns - last < _repeat_interval_ns ||
+          !_last_emit_ns.compare_exchange_strong(last, now_ns, std::memory_order_relaxed)) {
+         return {};
+      }
+      // Only the summary, the message itself is known by now
+      return {.repeated = _repeated.exchange(0, std::memory_order_relaxed),
+              .suppressed = _suppressed.exchange(0, std::memory_order_relaxed)};
+   }
+   if (!take_token(now_ns)) {
+      _suppressed.fetch_add(1, std::memory_order_relaxed);
+      return {};
+   }
+   _last_hash.store(hash, std::memory_order_relaxed);
+   _level.store(level, std::memory_order_relaxed);
+   _last_emit_ns.store(now_ns, std::memory_order_relaxed);
+   return {.message = true,
+           .repeated = _repeated.exchange(0, std::memory_order_relaxed),
+           .suppressed = _suppressed.exchange(0, std::memory_order_relaxed)};
+}
+
+LogSite::Decision LogSite::expire(int64_t now_ns)
+{
+   if (_repeated.load(std::memory_order_relaxed) == 0 &&
+       _suppressed.load(std::memory_order_relaxed) == 0) {
+      return {};
+   }
+   auto last = _last_emit_ns.load(std::memory_order_relaxed);
+   if (now_ns - last < _repeat_interval_ns ||
+       !_last_emit_ns.compare_exchange_strong(last, now_ns, std::memory_order_relaxed)) {
+      return {};
+   }
+   return {.repeated = _repeated.exchange(0, std::memory_order_relaxed),
+           .suppressed = _suppressed.exchange(0, std::memory_order_relaxed),
+           .level = _level.load(std::memory_order_relaxed)};
+}
+
+bool LogSite::take_token(int64_t now_ns)
+{
+   // Generic cell rate algorithm: a token is free while _next_ns is at most the tolerance ahead
+   auto next = _next_ns.load(std::memory_order_relaxed);
+   for (;;) {
+      const auto start = std::max(next, now_ns);
+      if (start - now_ns > _tolerance_ns) {
+         return false;
+      }
+      if (_next_ns.compare_exchange_weak(next, start + _interval_ns, std::memory_order_relaxed)) {
+         return true;
+      }
+   }
+}
+
+namespace detail {
+SiteRegistration::SiteRegistration(LogSite* site) : _site(site)
+{
+   Backend::instance().add_site(_site);
+}
+
+SiteRegistration::~SiteRegistration()
+{
+   Backend::instance().remove_site(_site);
+}
+
+ThreadBuffer* thread_buffer()
+{
+   // Trivially destructible, still usable from the destructors running after owner's
+   thread_local bool owner_destroyed = false;
+   thread_local ThreadBuffer* late = nullptr;
+   struct Owner {
+      std::shared_ptr<ThreadBuffer> buffer = Backend::instance().register_thread();
+      Owner(const Owner&) = delete;
+      Owner& operator=(const Owner&) = delete;
+      Owner() = default;
+      ~Owner()
+      {
+         buffer->retired.store(true, std::memory_order_release);
+         owner_destroyed = true;
+      }
+   };
+   if (owner_destroyed) {
+      // Logged from a later thread_local or static destructor, e.g. the main thread at exit.
+      // Never retired, the backend keeps it
+      if (!late) {
+         late = Backend::instance().register_thread().get();
+      }
+      return late;
+   }
+   thread_local Owner owner;
+   return owner.buffer.get();
 }
+}  // namespace detail
 
 }  // namespace meddl::log
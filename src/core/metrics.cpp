@@ -0,0 +1,233 @@
+#include "core/metrics.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <format>
+
+#include "core/log.h"
+
+namespace meddl::metrics {
+
+namespace detail {
+uint32_t shard_index()
+{
+   static std::atomic<uint32_t> next{0};
+   thread_local const uint32_t index = next.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+   return index;
+}
+}  // namespace detail
+
+uint64_t Counter::value() const
+{
+   uint64_t sum = 0;
+   for (const auto& shard : _shards) {
+      sum += shard.value.load(std::memory_order_relaxed);
+   }
+   return sum;
+}
+
+std::vector<double> Histogram::default_ms_bounds()
+{
+   return {0.5, 1, 2, 4, 8, 12, 16.7, 20, 25, 33.4, 50, 66.7, 100, 250, 500, 1000};
+}
+
+Histogram::Histogram(std::vector<double> bounds) : _bounds(std::move(bounds))
+{
+   std::ranges::sort(_bounds);
+   for (auto& shard : _shards) {
+      shard.buckets = std::make_unique<std::atomic<uint64_t>[]>(_bounds.size() + 1);
+   }
+}
+
+void Histogram::record(double value)
+{
+   const auto bucket =
+       static_cast<size_t>(std::ranges::lower_bound(_bounds, value) - _bounds.begin());
+   auto& shard = _shards[detail::shard_index()];
+   shard.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+   shard.sum.fetch_add(value, std::memory_order_relaxed);
+   shard.count.fetch_add(1, std::memory_order_relaxed);
+}
+
+Histogram::Data Histogram::data() const
+{
+   Data data;
+   data.buckets.resize(_bounds.size() + 1);
+   for (const auto& shard : _shards) {
+      data.count += shard.count.load(std::memory_order_relaxed);
+      data.sum += shard.sum.load(std::memory_order_relaxed);
+      for (size_t i = 0; i < data.buckets.size(); i++) {
+         data.buckets[i] += shard.buckets[i].load(std::memory_order_relaxed);
+      }
+   }
+   return data;
+}
+
+double HistogramValue::mean() const
+{
+   return data.count > 0 ? data.sum / static_cast<double>(data.count) : 0.0;
+}
+
+double HistogramValue::percentile(double p) const
+{
+   if (data.count == 0 || bounds.empty()) {
+      return 0.0;
+   }
+   const auto rank = static_cast<uint64_t>(p * static_cast<double>(data.count - 1)) + 1;
+   uint64_t seen = 0;
+   for (size_t i = 0; i < bounds.size(); i++) {
+      seen += data.buckets[i];
+      if (seen >= rank) {
+         return bounds[i];
+      }
+   }
+   return bounds.back();
+}
+
+Snapshot Snapshot::since(const Snapshot& earlier) const
+{
+   Snapshot delta = *this;
+   // Same registry, so the earlier names are a sorted subset
+   for (auto& counter : delta.counters) {
+      auto it = std::ranges::lower_bound(earlier.counters, counter.name, {}, &CounterValue::name);
+      if (it != earlier.counters.end() && it->name == counter.name) {
+         counter.value -= std::min(counter.value, it->value);
+      }
+   }
+   for (auto& histogram : delta.histograms) {
+      auto it =
+          std::ranges::lower_bound(earlier.histograms, histogram.name, {}, &HistogramValue::name);
+      if (it == earlier.histograms.end() || it->name != histogram.name) {
+         continue;
+      }
+      histogram.data.count -= std::min(histogram.data.count, it->data.count);
+      histogram.data.sum -= it->data.sum;
+      for (size_t i = 0; i < histogram.data.buckets.size() && i < it->data.buckets.size(); i++) {
+         histogram.data.buckets[i] -= std::min(histogram.data.buckets[i], it->data.buckets[i]);
+      }
+   }
+   return delta;
+}
+
+std::string Snapshot::to_string() const
+{
+   std::string line;
+   const auto separator = [&] {
+      if (!line.empty()) {
+         line += ", ";
+      }
+   };
+   for (const auto& counter : counters) {
+      if (counter.value > 0) {
+         separator();
+         line += std::format("{} {}", counter.name, counter.value);
+      }
+   }
+   for (const auto& gauge : gauges) {
+      separator();
+      line += std::format("{} {:.2f}", gauge.name, gauge.value);
+   }
+   for (const auto& histogram : histograms) {
+      if (histogram.data.count > 0) {
+         separator();
+         line += std::format("{} n {} mean {:.2f} p50 {} p95 {} p99 {}",
+                             histogram.name,
+                             histogram.data.count,
+                             histogram.mean(),
+                             histogram.percentile(0.50),
+                             histogram.percentile(0.95),
+                             histogram.percentile(0.99));
+      }
+   }
+   return line;
+}
+
+Registry& Registry::instance()
+{
+   static Registry instance;
+   return instance;
+}
+
+Registry::~Registry()
+{
+   stop_log_sink();
+}
+
+Counter& Registry::counter(const std::string& name)
+{
+   const std::scoped_lock lock(_mutex);
+   auto& counter = _counters[name];
+   if (!counter) {
+      counter = std::make_unique<Counter>();
+   }
+   return *counter;
+}
+
+Gauge& Registry::gauge(const std::string& name)
+{
+   const std::scoped_lock lock(_mutex);
+   auto& gauge = _gauges[name];
+   if (!gauge) {
+      gauge = std::make_unique<Gauge>();
+   }
+   return *gauge;
+}
+
+Histogram& Registry::histogram(const std::string& name, std::vector<double> bounds)
+{
+   const std::scoped_lock lock(_mutex);
+   auto& histogram = _histograms[name];
+   if (!histogram) {
+      histogram = std::make_unique<Histogram>(std::move(bounds));
+   }
+   return *histogram;
+}
+
+Snapshot Registry::snapshot() const
+{
+   Snapshot snapshot;
+   snapshot.time = std::chrono::steady_clock::now();
+   const std::scoped_lock lock(_mutex);
+   for (const auto& [name, counter] : _counters) {
+      snapshot.counters.push_back({.name = name, .value = counter->value()});
+   }
+   for (const auto& [name, gauge] : _gauges) {
+      snapshot.gauges.push_back({.name = name, .value = gauge->value()});
+   }
+   for (const auto& [name, histogram] : _histograms) {
+      snapshot.histograms.push_back(
+          {.name = name, .bounds = histogram->bounds(), .data = histogram->data()});
+   }
+   return snapshot;
+}
+
+void Registry::start_log_sink(std::chrono::milliseconds interval)
+{
+   stop_log_sink();
+   _log_sink = std::jthread([this, interval](std::stop_token stop) {
+      std::mutex mutex;
+      std::condition_variable_any wake;
+      auto previous = snapshot();
+      while (true) {
+         {
+            std::unique_lock lock(mutex);
+            if (wake.wait_for(lock, stop, interval, [] { return false; }); stop.stop_requested()) {
+               return;
+            }
+         }
+         auto current = snapshot();
+         meddl::log::info("Metrics: {}", current.since(previous).to_string());
+         previous = std::move(current);
+      }
+   });
+}
+
+void Registry::stop_log_sink()
+{
+   if (_log_sink.joinable()) {
+      _log_sink.request_stop();
+      _log_sink.join();
+   }
+}
+
+}  // namespace meddl::metrics
@@ -0,0 +1,185 @@
+#include "core/trace.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <format>
+#include <memory>
+#include <mutex>
+
+namespace meddl::trace {
+
+namespace {
+//! Single writer (the owning thread), any number of readers
+//! Every slot is a seqlock: its sequence is odd while push() fills it and tells which event it
+//! holds, so a reader racing the writer drops slots that changed under it instead of tearing them
+class Ring {
+  public:
+   explicit Ring(uint32_t track) : _track(track) {}
+
+   void push(const char* name, const char* category, uint64_t start_ns, uint64_t end_ns)
+   {
+      const auto head = _head.load(std::memory_order_relaxed);
+      auto& slot = _slots[head % RING_CAPACITY];
+      slot.sequence.store(head * 2 + 1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+      slot.name.store(name, std::memory_order_relaxed);
+      slot.category.store(category, std::memory_order_relaxed);
+      slot.start_ns.store(start_ns, std::memory_order_relaxed);
+      slot.end_ns.store(end_ns, std::memory_order_relaxed);
+      slot.sequence.store(head * 2 + 2, std::memory_order_release);
+      _head.store(head + 1, std::memory_order_release);
+   }
+
+   void read(std::vector<Event>& out) const
+   {
+      const auto head = _head.load(std::memory_order_acquire);
+      const auto tail = std::max(_tail.load(std::memory_order_acquire),
+                                 head > RING_CAPACITY ? head - RING_CAPACITY : 0);
+      for (auto i = tail; i < head; i++) {
+         const auto& slot = _slots[i % RING_CAPACITY];
+         const auto expected = i * 2 + 2;
+         if (slot.sequence.load(std::memory_order_acquire) != expected) {
+            continue;  // Overwritten by a newer event already
+         }
+         const Event event{.name = slot.name.load(std::memory_order_relaxed),
+                           .category = slot.category.load(std::memory_order_relaxed),
+                           .start_ns = slot.start_ns.load(std::memory_order_relaxed),
+                           .end_ns = slot.end_ns.load(std::memory_order_relaxed),
+                           .track = _track};
+         std::atomic_thread_fence(std::memory_order_acquire);
+         if (slot.sequence.load(std::memory_order_relaxed) == expected) {
+            out.push_back(event);
+         }
+      }
+   }
+
+   void clear() { _tail.store(_head.load(std::memory_order_acquire), std::memory_order_release); }
+
+   [[nodiscard]] uint32_t track() const { return _track; }
+
+  private:
+   struct Slot {
+      std::atomic<uint64_t> sequence{0};  // Event index * 2 + 2 when complete, odd while written
+      std::atomic<const char*> name{nullptr};
+      std::atomic<const char*> category{nullptr};
+      std::atomic<uint64_t> start_ns{0};
+      std::atomic<uint64_t> end_ns{0};
+   };
+
+   uint32_t _track;
+   std::atomic<uint64_t> _head{0};  // Events ever pushed
+   std::atomic<uint64_t> _tail{0};  // Events before this were cleared
+   std::array<Slot, RING_CAPACITY> _slots{};
+};
+
+struct Registry {
+   std::mutex mutex;
+   std::vector<std::unique_ptr<Ring>> rings;
+   std::vector<std::string> names;  // By track
+};
+
+Registry& registry()
+{
+   // Leaked, threads may still trace while statics are destroyed
+   static auto* registry = new Registry();
+   return *registry;
+}
+
+Ring& thread_ring()
+{
+   thread_local Ring* ring = [] {
+      auto& reg = registry();
+      const std::scoped_lock lock(reg.mutex);
+      const auto track = static_cast<uint32_t>(reg.rings.size());
+      reg.rings.push_back(std::make_unique<Ring>(track));
+      reg.names.push_back(std::format("Thread {}", track));
+      return reg.rings.back().get();
+   }();
+   return *ring;
+}
+
+void append_escaped(std::string& out, std::string_view text)
+{
+   for (char c : text) {
+      if (c == '"' || c == '\\') {
+         out += '\\';
+      }
+      out += c;
+   }
+}
+}  // namespace
+
+void record(const char* name, const char* category, uint64_t start_ns, uint64_t end_ns)
+{
+   thread_ring().push(name, category, start_ns, end_ns);
+}
+
+void set_thread_name(std::string name)
+{
+   const auto track = thread_ring().track();
+   auto& reg = registry();
+   const std::scoped_lock lock(reg.mutex);
+   reg.names.at(track) = std::move(name);
+}
+
+Snapshot snapshot()
+{
+   Snapshot snapshot;
+   auto& reg = registry();
+   const std::scoped_lock lock(reg.mutex);
+   for (const auto& ring : reg.rings) {
+      ring->read(snapshot.events);
+      snapshot.tracks.push_back({.id = ring->track(), .name = reg.names.at(ring->track())});
+   }
+   return snapshot;
+}
+
+void clear()
+{
+   auto& reg = registry();
+   const std::scoped_lock lock(reg.mutex);
+   for (auto& ring : reg.rings) {
+      ring->clear();
+   }
+}
+
+std::string to_chrome_json(const Snapshot& snapshot)
+{
+   // Timestamps in microseconds from the first event, complete events ("ph": "X")
+   uint64_t origin = UINT64_MAX;
+   for (const auto& event : snapshot.events) {
+      origin = std::min(origin, event.start_ns);
+   }
+
+   std::string json = R"({"displayTimeUnit":"ms","traceEvents":[)";
+   bool first = true;
+   const auto separator = [&] {
+      if (!first) {
+         json += ',';
+      }
+      first = false;
+   };
+   for (const auto& track : snapshot.tracks) {
+      separator();
+      json += std::format(
+          R"({{"name":"thread_name","ph":"M","pid":1,"tid":{},"args":{{"name":")", track.id);
+      append_escaped(json, track.name);
+      json += R"("}})";
+   }
+   for (const auto& event : snapshot.events) {
+      separator();
+      json += R"({"name":")";
+      append_escaped(json, event.name);
+      json += R"(","cat":")";
+      append_escaped(json, event.category);
+      json += std::format(R"(","ph":"X","pid":1,"tid":{},"ts":{:.3f},"dur":{:.3f}}})",
+                          event.track,
+                          static_cast<double>(event.start_ns - origin) / 1e3,
+                          static_cast<double>(event.end_ns - event.start_ns) / 1e3);
+   }
+   json += "]}";
+   return json;
+}
+
+}  // namespace meddl::trace
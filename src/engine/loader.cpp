@@ -5,6 +5,7 @@
 
 #include "core/error.h"
 #include "core/log.h"
+#include "core/trace.h"
 #include "engine/types.h"
 
 #define TINYGLTF_IMPLEMENTATION
@@ -35,6 +36,7 @@ void load_texture_from_image(const tinygltf::Model& model,
 
 std::expected<ImageData, error::Error> load_image(const std::filesystem::path& path)
 {
+   MEDDL_TRACE_SCOPE("loader", "load_image");
    if (!std::filesystem::exists(path)) {
       return std::unexpected(
           error::Error(std::format("Can not load image, file not found: {}", path.string())));
@@ -70,16 +72,20 @@ class Loader {
 
    std::expected<ModelData, error::Error> load()
    {
+      MEDDL_TRACE_SCOPE("loader", "load_gltf");
       tinygltf::TinyGLTF loader;
       std::string err;
       std::string warn;
       bool ret = false;
 
-      if (_path.extension() == ".glb") {
-         ret = loader.LoadBinaryFromFile(&_model, &err, &warn, _path.string());
-      }
-      else {
-         ret = loader.LoadASCIIFromFile(&_model, &err, &warn, _path.string());
+      {
+         MEDDL_TRACE_SCOPE("loader", "parse_gltf");
+         if (_path.extension() == ".glb") {
+            ret = loader.LoadBinaryFromFile(&_model, &err, &warn, _path.string());
+         }
+         else {
+            ret = loader.LoadASCIIFromFile(&_model, &err, &warn, _path.string());
+         }
       }
 
       if (!warn.empty()) {
@@ -136,6 +142,7 @@ class Loader {
   private:
    bool load_meshes(ModelData& model_data)
    {
+      MEDDL_TRACE_SCOPE("loader", "load_meshes");
       if (_model.meshes.empty()) {
          return true;
       }
@@ -258,6 +265,7 @@ class Loader {
 
    bool load_materials(ModelData& model_data)
    {
+      MEDDL_TRACE_SCOPE("loader", "load_materials");
       for (const auto& mat : _model.materials) {
          MaterialData material;
          material.name = mat.name;
@@ -322,6 +330,7 @@ class Loader {
 
    bool load_textures(ModelData& model_data)
    {
+      MEDDL_TRACE_SCOPE("loader", "load_textures");
       for (const auto& material : model_data.materials) {
          for (const auto& texture_ref : {material.albedo_texture,
                                          material.normal_texture,
@@ -345,6 +354,7 @@ class Loader {
 
    bool load_nodes(ModelData& model_data)
    {
+      MEDDL_TRACE_SCOPE("loader", "load_nodes");
       model_data.nodes.resize(_model.nodes.size());
 
       for (size_t i = 0; i < _model.nodes.size(); ++i) {
@@ -411,6 +421,7 @@ class Loader {
 
    bool load_animations(ModelData& model_data)
    {
+      MEDDL_TRACE_SCOPE("loader", "load_animations");
       for (const auto& gltf_anim : _model.animations) {
          Animation anim;
          anim.name = gltf_anim.name;
@@ -497,6 +508,7 @@ class Loader {
 
    bool load_skins(ModelData& model_data)
    {
+      MEDDL_TRACE_SCOPE("loader", "load_skins");
       for (const auto& gltf_skin : _model.skins) {
          Skin skin;
          skin.name = gltf_skin.name;
@@ -0,0 +1,168 @@
+#include "engine/render/vk/async_compute.h"
+
+#include <vulkan/vulkan_core.h>
+
+#include <format>
+
+#include "core/log.h"
+
+namespace meddl::render::vk {
+
+std::expected<AsyncCompute, error::Error> AsyncCompute::create(Device* device,
+                                                               uint32_t frames_in_flight)
+{
+   AsyncCompute compute;
+   compute._device = device;
+   compute._queue = &device->queue(QueueFamilyType::Compute);
+   compute._queue_family = compute._queue->family_index();
+   compute._graphics_family = device->queue(QueueFamilyType::Graphics).family_index();
+
+   auto pool = CommandPool::create(
+       device, compute._queue_family, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
+   if (!pool) {
+      return std::unexpected(pool.error());
+   }
+   compute._pool = std::make_unique<CommandPool>(std::move(pool.value()));
+
+   for (uint32_t i = 0; i < frames_in_flight; i++) {
+      auto cmd = CommandBuffer::create(device, compute._pool.get());
+      if (!cmd) {
+         return std::unexpected(cmd.error());
+      }
+      compute._command_buffers.emplace_back(std::move(cmd.value()));
+      compute._fences.emplace_back(device);
+      compute._semaphores.emplace_back(device);
+   }
+   meddl::log::debug("Async compute on family {} (graphics {}), async: {}",
+                     compute._queue_family,
+                     compute._graphics_family,
+                     compute.is_async());
+   return compute;
+}
+
+bool AsyncCompute::is_async() const
+{
+   return _queue && _device->has_own_queue(QueueFamilyType::Compute);
+}
+
+std::expected<CommandBuffer*, error::Error> AsyncCompute::begin(uint32_t frame)
+{
+   if (frame >= _command_buffers.size()) {
+      return std::unexpected(error::Error(std::format("No compute frame {}", frame)));
+   }
+   _frame = frame;
+   _fences.at(frame).wait(_device);
+   _fences.at(frame).reset(_device);
+
+   auto& cmd = _command_buffers.at(frame);
+   if (auto result = cmd.reset(); !result) {
+      return std::unexpected(result.error());
+   }
+   if (auto result = cmd.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT); !result) {
+      return std::unexpected(result.error());
+   }
+   return &cmd;
+}
+
+std::expected<void, error::Error> AsyncCompute::submit(std::span<const BufferHandoff> handoffs)
+{
+   auto& cmd = _command_buffers.at(_frame);
+   if (cmd.state() != CommandBuffer::State::Recording) {
+      return std::unexpected(error::Error("Commandbuffer state is not recording"));
+   }
+
+   if (transfers_ownership() && !handoffs.empty()) {
+      std::vector<VkBufferMemoryBarrier> releases;
+      releases.reserve(handoffs.size());
+      for (const auto& handoff : handoffs) {
+         VkBufferMemoryBarrier barrier{};
+         barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+         barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+         barrier.dstAccessMask = 0;  // Ignored on release
+         barrier.srcQueueFamilyIndex = _queue_family;
+         barrier.dstQueueFamilyIndex = _graphics_family;
+         barrier.buffer = handoff.buffer;
+         barrier.offset = handoff.offset;
+         barrier.size = handoff.size;
+         releases.push_back(barrier);
+      }
+      vkCmdPipelineBarrier(cmd.vk(),
+                           VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                           VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                           0,
+                           0,
+                           nullptr,
+                           static_cast<uint32_t>(releases.size()),
+                           releases.data(),
+                           0,
+                           nullptr);
+   }
+   if (auto result = cmd.end(); !result) {
+      return std::unexpected(result.error());
+   }
+
+   VkCommandBuffer command_buffer = cmd.vk();
+   VkSemaphore signal = _semaphores.at(_frame).vk();
+   VkSubmitInfo submit_info{};
+   submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+   submit_info.commandBufferCount = 1;
+   submit_info.pCommandBuffers = &command_buffer;
+   submit_info.signalSemaphoreCount = 1;
+   submit_info.pSignalSemaphores = &signal;
+   auto result = vkQueueSubmit(_queue->vk(), 1, &submit_info, _fences.at(_frame).vk());
+   if (result != VK_SUCCESS) {
+      return std::unexpected(
+          error::Error(std::format("vkQueueSubmit failed: {}", static_cast<int32_t>(result))));
+   }
+   return {};
+}
+
+std::expected<void, error::Error> AsyncCompute::acquire(
+    CommandBuffer* graphics,
+    std::span<const BufferHandoff> handoffs) const
+{
+   if (graphics->state() != CommandBuffer::State::Recording) {
+      return std::unexpected(error::Error("Commandbuffer state is not recording"));
+   }
+   // Same family: the semaphore wait alone makes the writes visible
+   if (!transfers_ownership() || handoffs.empty()) {
+      return {};
+   }
+
+   std::vector<VkBufferMemoryBarrier> acquires;
+   acquires.reserve(handoffs.size());
+   for (const auto& handoff : handoffs) {
+      VkBufferMemoryBarrier barrier{};
+      barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+      barrier.srcAccessMask = 0;  // Ignored on acquire
+      barrier.dstAccessMask = handoff.dst_access;
+      barrier.srcQueueFamilyIndex = _queue_family;
+      barrier.dstQueueFamilyIndex = _graphics_family;
+      barrier.buffer = handoff.buffer;
+      barrier.offset = handoff.offset;
+      barrier.size = handoff.size;
+      acquires.push_back(barrier);
+   }
+   vkCmdPipelineBarrier(graphics->vk(),
+                        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                        wait_stage(handoffs),
+                        0,
+                        0,
+                        nullptr,
+                        static_cast<uint32_t>(acquires.size()),
+                        acquires.data(),
+                        0,
+                        nullptr);
+   return {};
+}
+
+VkPipelineStageFlags AsyncCompute::wait_stage(std::span<const BufferHandoff> handoffs)
+{
+   VkPipelineStageFlags stages{0};
+   for (const auto& handoff : handoffs) {
+      stages |= handoff.dst_stage;
+   }
+   return stages != 0 ? stages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+}
+
+}  // namespace meddl::render::vk
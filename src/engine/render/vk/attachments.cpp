@@ -0,0 +1,174 @@
+#include "engine/render/vk/attachments.h"
+
+#include <vulkan/vulkan_core.h>
+
+#include <algorithm>
+#include <format>
+#include <iterator>
+
+#include "core/log.h"
+
+namespace meddl::render::vk {
+
+std::expected<AttachmentSet, error::Error> AttachmentSet::create(
+    Device* device,
+    std::span<const GraphicsConfiguration::AttachmentConfig> attachments,
+    uint32_t width,
+    uint32_t height)
+{
+   AttachmentSet set;
+   set._device = device;
+   set._images.resize(attachments.size());
+   auto* physical_device = device->physical_device();
+
+   const auto allocate = [&](VkDeviceSize size,
+                             uint32_t type_index) -> std::expected<VkDeviceMemory, error::Error> {
+      VkMemoryAllocateInfo alloc_info{};
+      alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+      alloc_info.allocationSize = size;
+      alloc_info.memoryTypeIndex = type_index;
+      VkDeviceMemory memory{VK_NULL_HANDLE};
+      auto result = vkAllocateMemory(device->vk(), &alloc_info, device->get_allocators(), &memory);
+      if (result != VK_SUCCESS) {
+         return std::unexpected(error::Error(
+             std::format("vkAllocateMemory failed: {}", static_cast<int32_t>(result))));
+      }
+      set._memory.push_back(memory);
+      set._stats.allocations++;
+      return memory;
+   };
+
+   // Attachments that need committed memory, candidates for aliasing
+   struct Candidate {
+      size_t attachment;
+      VkMemoryRequirements requirements;
+   };
+   std::vector<Candidate> candidates;
+
+   for (size_t i = 0; i < attachments.size(); i++) {
+      const auto& config = attachments[i];
+      if (config.is_swapchain_image()) {
+         continue;
+      }
+      auto& image = set._images[i].emplace(Image::create_unbound(device, config, width, height));
+      const auto requirements = image.memory_requirements();
+      set._stats.requested_bytes += requirements.size;
+
+      if (config.transient) {
+         auto lazy = physical_device->find_memory_type(
+             requirements.memoryTypeBits,
+             config.memory_flags | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT);
+         if (lazy) {
+            auto memory = allocate(requirements.size, lazy.value());
+            if (!memory) {
+               return std::unexpected(memory.error());
+            }
+            image.bind_memory(memory.value(), 0);
+            set._stats.lazy_attachments++;
+            continue;
+         }
+      }
+      candidates.push_back({.attachment = i, .requirements = requirements});
+   }
+
+   // Greedy, largest first: join the first block with compatible memory whose attachments are
+   // all live in other passes. Everything in a block is bound at offset 0
+   struct Block {
+      VkDeviceSize size;
+      uint32_t type_bits;
+      VkMemoryPropertyFlags flags;
+      std::vector<size_t> attachments;
+   };
+   std::vector<Block> blocks;
+   std::ranges::sort(candidates, std::greater{}, [](const Candidate& c) {
+      return c.requirements.size;
+   });
+   for (const auto& candidate : candidates) {
+      const auto& config = attachments[candidate.attachment];
+      const auto overlaps = [&](size_t other) { return config.overlaps(attachments[other]); };
+      auto block = std::ranges::find_if(blocks, [&](const Block& b) {
+         return b.flags == config.memory_flags &&
+                (b.type_bits & candidate.requirements.memoryTypeBits) != 0 &&
+                std::ranges::none_of(b.attachments, overlaps);
+      });
+      if (block == blocks.end()) {
+         blocks.push_back({.size = candidate.requirements.size,
+                           .type_bits = candidate.requirements.memoryTypeBits,
+                           .flags = config.memory_flags,
+                           .attachments = {}});
+         block = std::prev(blocks.end());
+      }
+      block->size = std::max(block->size, candidate.requirements.size);
+      block->type_bits &= candidate.requirements.memoryTypeBits;
+      block->attachments.push_back(candidate.attachment);
+   }
+
+   for (const auto& block : blocks) {
+      auto type_index = physical_device->find_memory_type(block.type_bits, block.flags);
+      if (!type_index) {
+         return std::unexpected(error::Error("No memory type for attachments"));
+      }
+      auto memory = allocate(block.size, type_index.value());
+      if (!memory) {
+         return std::unexpected(memory.error());
+      }
+      set._stats.allocated_bytes += block.size;
+      for (auto attachment : block.attachments) {
+         set._images[attachment]->bind_memory(memory.value(), 0);
+      }
+   }
+
+   meddl::log::debug("Attachments {}x{}: {} bytes requested, {} allocated, {} lazy",
+                     width,
+                     height,
+                     set._stats.requested_bytes,
+                     set._stats.allocated_bytes,
+                     set._stats.lazy_attachments);
+   return set;
+}
+
+AttachmentSet::~AttachmentSet()
+{
+   destroy();
+}
+
+AttachmentSet::AttachmentSet(AttachmentSet&& other) noexcept
+    : _device(other._device),
+      _images(std::move(other._images)),
+      _memory(std::move(other._memory)),
+      _stats(other._stats)
+{
+   other._device = nullptr;
+   other._images.clear();
+   other._memory.clear();
+}
+
+AttachmentSet& AttachmentSet::operator=(AttachmentSet&& other) noexcept
+{
+   if (this != &other) {
+      destroy();
+      _device = other._device;
+      _images = std::move(other._images);
+      _memory = std::move(other._memory);
+      _stats = other._stats;
+
+      other._device = nullptr;
+      other._images.clear();
+      other._memory.clear();
+   }
+   return *this;
+}
+
+void AttachmentSet::destroy()
+{
+   // Images first, they don't own the memory they are bound to
+   _images.clear();
+   if (_device) {
+      for (auto memory : _memory) {
+         vkFreeMemory(_device->vk(), memory, _device->get_allocators());
+      }
+   }
+   _memory.clear();
+}
+
+}  // namespace meddl::render::vk
@@ -0,0 +1,275 @@
+#include "engine/render/vk/bindless.h"
+
+#include <vulkan/vulkan_core.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "core/log.h"
+
+namespace meddl::render::vk {
+
+namespace {
+constexpr VkDescriptorBindingFlags array_binding_flags =
+    VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+    VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+
+const BindlessMaterial default_material = {
+    .diffuse_color = glm::vec4(1.0f),
+    .shininess = 0.0f,
+    .metallic = 0.0f,
+    .roughness = 1.0f,
+    .ao = 1.0f,
+    .albedo_texture = bindless_material_layout::invalid_index,
+    .normal_texture = bindless_material_layout::invalid_index,
+    .metallic_roughness_texture = bindless_material_layout::invalid_index,
+    .sampler_index = 0};
+}  // namespace
+
+bool BindlessTable::supported(const Device* device)
+{
+   const auto& features = device->enabled_vulkan12_features();
+   return features.descriptorIndexing && features.runtimeDescriptorArray &&
+          features.descriptorBindingPartiallyBound &&
+          features.descriptorBindingSampledImageUpdateAfterBind &&
+          features.descriptorBindingUpdateUnusedWhilePending &&
+          features.shaderSampledImageArrayNonUniformIndexing;
+}
+
+std::expected<BindlessTable, error::Error> BindlessTable::create(Device* device,
+                                                                 const BindlessConfig& config)
+{
+   if (!supported(device)) {
+      return std::unexpected(
+          error::Error("Bindless table requires the Vulkan 1.2 descriptor indexing features"));
+   }
+   if (config.max_images == 0 || config.max_samplers == 0 || config.max_materials == 0) {
+      return std::unexpected(error::Error("Bindless table needs non zero capacities"));
+   }
+
+   VkPhysicalDeviceDescriptorIndexingProperties indexing{};
+   indexing.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+   VkPhysicalDeviceProperties2 properties{};
+   properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+   properties.pNext = &indexing;
+   vkGetPhysicalDeviceProperties2(device->physical_device()->vk(), &properties);
+
+   BindlessTable table;
+   table._device = device;
+   table._config = config;
+   table._config.max_images =
+       std::min(config.max_images, indexing.maxDescriptorSetUpdateAfterBindSampledImages);
+   table._config.max_samplers =
+       std::min(config.max_samplers, indexing.maxDescriptorSetUpdateAfterBindSamplers);
+   if (table._config.max_images != config.max_images ||
+       table._config.max_samplers != config.max_samplers) {
+      meddl::log::warn("Bindless table clamped to {} images, {} samplers",
+                       table._config.max_images,
+                       table._config.max_samplers);
+   }
+
+   constexpr auto stages = VK_SHADER_STAGE_ALL_GRAPHICS | VK_SHADER_STAGE_COMPUTE_BIT;
+   GraphicsConfiguration::DescriptorSetLayoutConfiguration layout_config = {
+       .bindings = {{.binding = images_binding,
+                     .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+                     .descriptorCount = table._config.max_images,
+                     .stageFlags = stages,
+                     .pImmutableSamplers = nullptr},
+                    {.binding = samplers_binding,
+                     .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER,
+                     .descriptorCount = table._config.max_samplers,
+                     .stageFlags = stages,
+                     .pImmutableSamplers = nullptr},
+                    {.binding = materials_binding,
+                     .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                     .descriptorCount = 1,
+                     .stageFlags = stages,
+                     .pImmutableSamplers = nullptr}},
+       .binding_flags = {array_binding_flags, array_binding_flags, 0},
+       .flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT};
+   table._set_layout = std::make_unique<DescriptorSetLayout>(device, layout_config);
+
+   GraphicsConfiguration::DescriptorPoolConfig pool_config = {
+       .max_sets = 1,
+       .pool_sizes = {{.type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+                       .descriptorCount = table._config.max_images},
+                      {.type = VK_DESCRIPTOR_TYPE_SAMPLER,
+                       .descriptorCount = table._config.max_samplers},
+                      {.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 1}},
+       .flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT};
+   table._descriptor_pool = std::make_unique<DescriptorPool>(device, pool_config);
+   table._set = std::make_unique<DescriptorSet>(
+       device, table._descriptor_pool.get(), table._set_layout.get());
+
+   table._materials = std::make_unique<Buffer>(
+       device,
+       bindless_material_layout::stride * config.max_materials,
+       VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+       VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+   // The first upload() fills every entry, the memory starts out undefined
+   table._staged_materials.assign(config.max_materials, default_material);
+   table._dirty_materials = config.max_materials;
+   table._set->update(materials_binding,
+                      table._materials->vk(),
+                      0,
+                      VK_WHOLE_SIZE,
+                      VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+
+   meddl::log::debug("Created bindless table: {} images, {} samplers, {} materials",
+                     table._config.max_images,
+                     table._config.max_samplers,
+                     table._config.max_materials);
+   return table;
+}
+
+std::expected<uint32_t, error::Error> BindlessTable::add_image(VkImageView view,
+                                                               VkImageLayout layout)
+{
+   if (_image_count >= _config.max_images) {
+      return std::unexpected(
+          error::Error(std::format("Bindless table is full ({} images)", _config.max_images)));
+   }
+   const uint32_t slot = _image_count++;
+   _writer.write_image(_set->vk(),
+                       images_binding,
+                       view,
+                       VK_NULL_HANDLE,
+                       layout,
+                       VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+                       slot);
+   return slot;
+}
+
+std::expected<uint32_t, error::Error> BindlessTable::add_sampler(VkSampler sampler)
+{
+   if (auto it = _samplers.find(sampler); it != _samplers.end()) {
+      return it->second;
+   }
+   if (_samplers.size() >= _config.max_samplers) {
+      return std::unexpected(
+          error::Error(std::format("Bindless table is full ({} samplers)", _config.max_samplers)));
+   }
+   const auto slot = static_cast<uint32_t>(_samplers.size());
+   _writer.write_image(_set->vk(),
+                       samplers_binding,
+                       VK_NULL_HANDLE,
+                       sampler,
+                       VK_IMAGE_LAYOUT_UNDEFINED,
+                       VK_DESCRIPTOR_TYPE_SAMPLER,
+                       slot);
+   _samplers.emplace(sampler, slot);
+   return slot;
+}
+
+std::expected<BindlessTexture, error::Error> BindlessTable::add_texture(const Texture& texture)
+{
+   auto image = add_image(texture.image().view());
+   if (!image) {
+      return std::unexpected(image.error());
+   }
+   auto sampler = add_sampler(texture.sampler().vk());
+   if (!sampler) {
+      return std::unexpected(sampler.error());
+   }
+   return BindlessTexture{.image = image.value(), .sampler = sampler.value()};
+}
+
+std::expected<void, error::Error> BindlessTable::set_materials(
+    std::span<const BindlessMaterial> materials)
+{
+   if (materials.size() > _config.max_materials) {
+      return std::unexpected(error::Error(std::format("{} materials exceed the capacity of {}",
+                                                      materials.size(),
+                                                      _config.max_materials)));
+   }
+   const auto count = static_cast<uint32_t>(materials.size());
+   std::ranges::copy(materials, _staged_materials.begin());
+   // Entries of a longer previous table go back to the default
+   std::fill(_staged_materials.begin() + count,
+             _staged_materials.begin() + std::max(count, _material_count),
+             default_material);
+   _dirty_materials = std::max({_dirty_materials, count, _material_count});
+   _material_count = count;
+   return {};
+}
+
+std::expected<void, error::Error> BindlessTable::upload(CommandBuffer* cmd,
+                                                        FrameAllocator* staging)
+{
+   if (_dirty_materials == 0) {
+      return {};
+   }
+   if (cmd->state() != CommandBuffer::State::Recording) {
+      return std::unexpected(error::Error("Commandbuffer state is not recording"));
+   }
+   const VkDeviceSize size = bindless_material_layout::stride * _dirty_materials;
+   auto allocation = staging->allocate(size);
+   if (!allocation) {
+      return std::unexpected(allocation.error());
+   }
+   std::memcpy(allocation->data, _staged_materials.data(), size);
+
+   // Frames still in flight read the table until the copy starts, later draws after it ends
+   constexpr VkPipelineStageFlags shader_stages = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                                                  VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+                                                  VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+   VkBufferMemoryBarrier barrier{};
+   barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+   barrier.srcAccessMask = 0;
+   barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+   barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+   barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+   barrier.buffer = _materials->vk();
+   barrier.offset = 0;
+   barrier.size = size;
+   vkCmdPipelineBarrier(cmd->vk(),
+                        shader_stages,
+                        VK_PIPELINE_STAGE_TRANSFER_BIT,
+                        0,
+                        0,
+                        nullptr,
+                        1,
+                        &barrier,
+                        0,
+                        nullptr);
+
+   const VkBufferCopy region{.srcOffset = allocation->offset, .dstOffset = 0, .size = size};
+   vkCmdCopyBuffer(cmd->vk(), staging->buffer(), _materials->vk(), 1, &region);
+
+   barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+   barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+   vkCmdPipelineBarrier(cmd->vk(),
+                        VK_PIPELINE_STAGE_TRANSFER_BIT,
+                        shader_stages,
+                        0,
+                        0,
+                        nullptr,
+                        1,
+                        &barrier,
+                        0,
+                        nullptr);
+   _dirty_materials = 0;
+   return {};
+}
+
+void BindlessTable::flush()
+{
+   if (_device) {
+      _writer.flush(_device);
+   }
+}
+
+std::expected<void, error::Error> BindlessTable::bind(CommandBuffer* cmd,
+                                                      VkPipelineLayout layout,
+                                                      uint32_t set_index,
+                                                      VkPipelineBindPoint bind_point)
+{
+   if (cmd->state() != CommandBuffer::State::Recording) {
+      return std::unexpected(error::Error("Commandbuffer state is not recording"));
+   }
+   flush();
+   vkCmdBindDescriptorSets(cmd->vk(), bind_point, layout, set_index, 1, _set->vk_ptr(), 0, nullptr);
+   return {};
+}
+
+}  // namespace meddl::render::vk
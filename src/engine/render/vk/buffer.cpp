@@ -2,6 +2,8 @@
 
 #include <cstring>
 
+#include "core/metrics.h"
+
 namespace meddl::render::vk {
 
 const VkVertexInputBindingDescription create_vertex_binding_description(size_t stride,
@@ -51,6 +53,29 @@ const std::array<VkVertexInputAttributeDescription, 4> create_vertex_attribute_d
    return attributeDescriptions;
 }
 
+const std::array<VkVertexInputAttributeDescription, 5> create_instance_attribute_descriptions(
+    size_t model_offset, size_t material_id_offset, uint32_t binding, uint32_t first_location)
+{
+   std::array<VkVertexInputAttributeDescription, 5> attributeDescriptions{};
+
+   // Model matrix, one location per column
+   for (uint32_t column = 0; column < 4; column++) {
+      attributeDescriptions[column].binding = binding;
+      attributeDescriptions[column].location = first_location + column;
+      attributeDescriptions[column].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+      attributeDescriptions[column].offset =
+          static_cast<uint32_t>(model_offset + sizeof(float) * 4 * column);
+   }
+
+   // Material id
+   attributeDescriptions[4].binding = binding;
+   attributeDescriptions[4].location = first_location + 4;
+   attributeDescriptions[4].format = VK_FORMAT_R32_UINT;
+   attributeDescriptions[4].offset = static_cast<uint32_t>(material_id_offset);
+
+   return attributeDescriptions;
+}
+
 Buffer::Buffer(Device* device,
                VkDeviceSize size,
                VkBufferUsageFlags usage,
@@ -73,7 +98,12 @@ Buffer::Buffer(Device* device,
    VkMemoryAllocateInfo alloc_info{};
    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
    alloc_info.allocationSize = mem_req.size;
-   alloc_info.memoryTypeIndex = find_memory_type(mem_req.memoryTypeBits, properties);
+   const auto type_index =
+       _device->physical_device()->find_memory_type(mem_req.memoryTypeBits, properties);
+   if (!type_index) {
+      throw std::runtime_error("Failed to find suitable memory type");
+   }
+   alloc_info.memoryTypeIndex = type_index.value();
 
    // TODO:
    // It should be noted that in a real world application, you're not supposed to actually call
@@ -148,13 +178,20 @@ Buffer& Buffer::operator=(Buffer&& other) noexcept
 
 void Buffer::copy_from(Buffer* src, VkDeviceSize size)
 {
+   static auto& copies = metrics::counter("upload.buffer_copies");
+   static auto& bytes = metrics::counter("upload.buffer_bytes");
+   copies.add();
+   bytes.add(size);
+
    // Create a temporary command buffer
    VkCommandPool commandPool{};
 
    VkCommandPoolCreateInfo poolInfo{};
    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
-   poolInfo.queueFamilyIndex = 0;  // TODO: Use graphics queue family index
+   // Graphics, the buffer is used there and needs no ownership transfer
+   const auto& queue = _device->queue(QueueFamilyType::Graphics);
+   poolInfo.queueFamilyIndex = queue.family_index();
 
    vkCreateCommandPool(_device->vk(), &poolInfo, nullptr, &commandPool);
 
@@ -185,8 +222,8 @@ void Buffer::copy_from(Buffer* src, VkDeviceSize size)
    submitInfo.pCommandBuffers = &commandBuffer;
 
    // Submit to the graphics queue and wait until finished
-   vkQueueSubmit(_device->queues().at(0).vk(), 1, &submitInfo, VK_NULL_HANDLE);
-   vkQueueWaitIdle(_device->queues().at(0).vk());
+   vkQueueSubmit(queue.vk(), 1, &submitInfo, VK_NULL_HANDLE);
+   vkQueueWaitIdle(queue.vk());
 
    vkFreeCommandBuffers(_device->vk(), commandPool, 1, &commandBuffer);
    vkDestroyCommandPool(_device->vk(), commandPool, nullptr);
@@ -220,19 +257,4 @@ void Buffer::update(const void* data, VkDeviceSize size, VkDeviceSize offset)
       unmap();
    }
 }
-
-uint32_t Buffer::find_memory_type(uint32_t typeFilter, VkMemoryPropertyFlags properties)
-{
-   VkPhysicalDeviceMemoryProperties memory_properties;
-   vkGetPhysicalDeviceMemoryProperties(_device->physical_device()->vk(), &memory_properties);
-
-   for (uint32_t i = 0; i < memory_properties.memoryTypeCount; i++) {
-      if ((typeFilter & (1 << i)) &&
-          (memory_properties.memoryTypes[i].propertyFlags & properties) == properties) {
-         return i;
-      }
-   }
-
-   throw std::runtime_error("Failed to find suitable memory type");
-}
 }  // namespace meddl::render::vk
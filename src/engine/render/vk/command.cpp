@@ -2,6 +2,7 @@
 
 #include <vulkan/vulkan_core.h>
 
+#include <algorithm>
 #include <expected>
 
 namespace meddl::render::vk {
@@ -12,6 +13,7 @@ std::expected<CommandPool, error::Error> CommandPool::create(Device* device,
 {
    CommandPool pool;
    pool._device = device;
+   pool._queue_family_index = queue_family_index;
    VkCommandPoolCreateInfo create_info{};
    create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
    create_info.queueFamilyIndex = queue_family_index;
@@ -28,7 +30,9 @@ std::expected<CommandPool, error::Error> CommandPool::create(Device* device,
 }
 
 CommandPool::CommandPool(CommandPool&& other) noexcept
-    : _command_pool(other._command_pool), _device(other._device)
+    : _command_pool(other._command_pool),
+      _device(other._device),
+      _queue_family_index(other._queue_family_index)
 {
    other._command_pool = VK_NULL_HANDLE;
    other._device = nullptr;
@@ -39,6 +43,7 @@ CommandPool& CommandPool::operator=(CommandPool&& other) noexcept
    if (this != &other) {
       _device = other._device;
       _command_pool = other._command_pool;
+      _queue_family_index = other._queue_family_index;
       other._command_pool = VK_NULL_HANDLE;
       other._device = nullptr;
    }
@@ -225,6 +230,123 @@ std::expected<void, error::Error> CommandBuffer::end_renderpass()
    return {};
 }
 
+VkRenderingAttachmentInfo rendering_attachment(
+    VkImageView view,
+    VkImageLayout layout,
+    const GraphicsConfiguration::AttachmentConfig& config)
+{
+   VkRenderingAttachmentInfo info{};
+   info.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+   info.imageView = view;
+   info.imageLayout = layout;
+   info.resolveMode = VK_RESOLVE_MODE_NONE;
+   info.loadOp = config.load_op;
+   info.storeOp = config.store_op;
+   info.clearValue = config.get_clear_value();
+   return info;
+}
+
+std::expected<void, error::Error> CommandBuffer::begin_rendering(
+    const VkRect2D& area,
+    std::span<const VkRenderingAttachmentInfo> color_attachments,
+    const VkRenderingAttachmentInfo* depth_attachment,
+    const VkRenderingAttachmentInfo* stencil_attachment)
+{
+   if (_state != State::Recording) {
+      return std::unexpected(error::Error("Commandbuffer state is not recording"));
+   }
+   VkRenderingInfo rendering_info{};
+   rendering_info.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+   rendering_info.renderArea = area;
+   rendering_info.layerCount = 1;
+   rendering_info.colorAttachmentCount = static_cast<uint32_t>(color_attachments.size());
+   rendering_info.pColorAttachments = color_attachments.data();
+   rendering_info.pDepthAttachment = depth_attachment;
+   rendering_info.pStencilAttachment = stencil_attachment;
+
+   vkCmdBeginRendering(_command_buffer, &rendering_info);
+   return {};
+}
+
+std::expected<void, error::Error> CommandBuffer::end_rendering()
+{
+   if (_state != State::Recording) {
+      return std::unexpected(error::Error("Commandbuffer state is not recording"));
+   }
+   vkCmdEndRendering(_command_buffer);
+   return {};
+}
+
+std::expected<void, error::Error> CommandBuffer::bind_pipeline(const ComputePipeline* pipeline)
+{
+   if (_state != State::Recording) {
+      return std::unexpected(error::Error("Commandbuffer state is not recording"));
+   }
+   vkCmdBindPipeline(_command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->vk());
+   return {};
+}
+
+std::expected<void, error::Error> CommandBuffer::dispatch(uint32_t group_count_x,
+                                                          uint32_t group_count_y,
+                                                          uint32_t group_count_z)
+{
+   if (_state != State::Recording) {
+      return std::unexpected(error::Error("Commandbuffer state is not recording"));
+   }
+   vkCmdDispatch(_command_buffer, group_count_x, group_count_y, group_count_z);
+   return {};
+}
+
+std::expected<void, error::Error> CommandBuffer::push_constants(const PipelineLayout& layout,
+                                                                VkShaderStageFlags stages,
+                                                                uint32_t offset,
+                                                                uint32_t size,
+                                                                const void* data)
+{
+   if (_state != State::Recording) {
+      return std::unexpected(error::Error("Commandbuffer state is not recording"));
+   }
+   // Every range overlapping the bytes must be pushed with all of its stages, and every pushed
+   // stage needs its range (one per stage, see PipelineLayout::create) to cover them
+   const auto& ranges = layout.push_constant_ranges();
+   const bool overlaps_match = std::ranges::all_of(ranges, [&](const auto& r) {
+      const bool overlaps = offset < r.offset + r.size && r.offset < offset + size;
+      return !overlaps || (r.stageFlags & ~stages) == 0;
+   });
+   bool declared = stages != 0 && overlaps_match;
+   for (auto remaining = stages; declared && remaining != 0; remaining &= remaining - 1) {
+      const auto stage = remaining & ~(remaining - 1);
+      declared = std::ranges::any_of(ranges, [&](const auto& r) {
+         return (r.stageFlags & stage) != 0 && offset >= r.offset &&
+                offset + size <= r.offset + r.size;
+      });
+   }
+   if (!declared) {
+      return std::unexpected(
+          error::Error(std::format("Push constant range [{}, {}) is not declared in the layout",
+                                   offset,
+                                   offset + size)));
+   }
+   vkCmdPushConstants(_command_buffer, layout.vk(), stages, offset, size, data);
+   return {};
+}
+
+std::expected<void, error::Error> CommandBuffer::draw_indexed_indirect_count(
+    VkBuffer buffer,
+    VkDeviceSize offset,
+    VkBuffer count_buffer,
+    VkDeviceSize count_offset,
+    uint32_t max_draw_count,
+    uint32_t stride)
+{
+   if (_state != State::Recording) {
+      return std::unexpected(error::Error("Commandbuffer state is not recording"));
+   }
+   vkCmdDrawIndexedIndirectCount(
+       _command_buffer, buffer, offset, count_buffer, count_offset, max_draw_count, stride);
+   return {};
+}
+
 std::expected<CommandBuffer, error::Error> CommandBuffer::begin_one_time_submit(Device* device,
                                                                                 CommandPool* pool)
 {
@@ -254,7 +376,7 @@ std::expected<void, error::Error> CommandBuffer::end_and_submit(Device* device,
    info.commandBufferCount = 1;
    info.pCommandBuffers = &_command_buffer;
 
-   auto& queue = device->queues().front();
+   const auto& queue = device->queue_for_family(pool->queue_family_index());
    if (vkQueueSubmit(queue.vk(), 1, &info, VK_NULL_HANDLE) != VK_SUCCESS) {
       return std::unexpected(error::Error("Failed to submit command buffer"));
    }
@@ -32,16 +32,32 @@ bool ConfigValidator::validate_renderpass(const GraphicsConfiguration& config)
 {
    meddl::log::debug("Validating renderpass...");
    for (const auto& attachment : config.shared.attachments) {
+      // Transient images may only be used as attachments, and their contents can't be stored
+      constexpr VkImageUsageFlags transient_compatible = VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+      if (attachment.transient && (attachment.additional_usage & ~transient_compatible)) {
+         meddl::log::error("Transient attachment {} has non attachment usage {}",
+                           static_cast<int32_t>(attachment.format),
+                           attachment.additional_usage);
+         return false;
+      }
+      if (attachment.transient && attachment.store_op == VK_ATTACHMENT_STORE_OP_STORE) {
+         meddl::log::warn("Transient attachment {} is stored, it will not stay in tile memory",
+                          static_cast<int32_t>(attachment.format));
+      }
+
       VkFormatProperties formatProps;
       vkGetPhysicalDeviceFormatProperties(_physical_device->vk(), attachment.format, &formatProps);
 
       // Check if the format is supported with the specified tiling
       // get_usage_flags() returns either VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT or
-      // VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT based on is_depth_stencil
-      // We need to check format feature flags, not usage flags
+      // VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT based on is_depth_stencil, plus any
+      // additional usage. We need to check format feature flags, not usage flags
       VkFormatFeatureFlags required_features = attachment.is_depth_stencil
                                                    ? VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT
                                                    : VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT;
+      if (attachment.additional_usage & VK_IMAGE_USAGE_SAMPLED_BIT) {
+         required_features |= VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+      }
 
       if (attachment.tiling == VK_IMAGE_TILING_LINEAR &&
           !(formatProps.linearTilingFeatures & required_features)) {
@@ -0,0 +1,430 @@
+#include "engine/render/vk/culling.h"
+
+#include <vulkan/vulkan_core.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+#include "core/log.h"
+#include "engine/shader.h"
+
+namespace meddl::render::vk {
+
+namespace {
+constexpr auto culling_shader_source = R"(
+#version 450
+layout(local_size_x = 64) in;
+
+struct DrawObject {
+   vec4 bounding_sphere;
+   uint index_count;
+   uint first_index;
+   int vertex_offset;
+   uint instance_index;
+};
+
+struct DrawCommand {
+   uint index_count;
+   uint instance_count;
+   uint first_index;
+   int vertex_offset;
+   uint first_instance;
+};
+
+const uint OCCLUSION = 1u << 0;
+const uint LATE_PHASE = 1u << 1;
+
+layout(std140, set = 0, binding = 0) uniform CullingParams {
+   vec4 frustum_planes[6];
+   mat4 view_projection;
+   vec2 pyramid_size;
+   uint object_count;
+   uint flags;
+} params;
+
+layout(std430, set = 0, binding = 1) readonly buffer Objects { DrawObject objects[]; };
+layout(std430, set = 0, binding = 2) writeonly buffer Commands { DrawCommand commands[]; };
+layout(std430, set = 0, binding = 3) buffer Count { uint draw_count; };
+// 1 if the early phase found the object occluded and the late phase has to re-test it
+layout(std430, set = 0, binding = 4) buffer Visibility { uint retest[]; };
+
+#ifdef MEDDL_OCCLUSION
+layout(set = 0, binding = 5) uniform sampler2D depth_pyramid;
+
+bool occluded(vec3 center, float radius)
+{
+   vec2 uv_min = vec2(1.0);
+   vec2 uv_max = vec2(0.0);
+   float closest = 1.0;
+   for (int i = 0; i < 8; i++) {
+      vec3 corner = center + radius * vec3((i & 1) != 0 ? 1.0 : -1.0,
+                                           (i & 2) != 0 ? 1.0 : -1.0,
+                                           (i & 4) != 0 ? 1.0 : -1.0);
+      vec4 clip = params.view_projection * vec4(corner, 1.0);
+      if (clip.w <= 0.0) {
+         return false;  // Crosses the camera plane
+      }
+      vec3 ndc = clip.xyz / clip.w;
+      vec2 uv = ndc.xy * 0.5 + 0.5;
+      uv_min = min(uv_min, uv);
+      uv_max = max(uv_max, uv);
+      closest = min(closest, ndc.z);
+   }
+   uv_min = clamp(uv_min, 0.0, 1.0);
+   uv_max = clamp(uv_max, 0.0, 1.0);
+
+   // Pick the level where the bounds cover at most 2x2 texels
+   vec2 extent = (uv_max - uv_min) * params.pyramid_size;
+   int level = int(ceil(log2(max(max(extent.x, extent.y), 1.0))));
+   level = clamp(level, 0, textureQueryLevels(depth_pyramid) - 1);
+
+   ivec2 size = textureSize(depth_pyramid, level);
+   ivec2 p0 = clamp(ivec2(uv_min * vec2(size)), ivec2(0), size - 1);
+   ivec2 p1 = clamp(ivec2(uv_max * vec2(size)), ivec2(0), size - 1);
+   float farthest = max(max(texelFetch(depth_pyramid, p0, level).r,
+                            texelFetch(depth_pyramid, ivec2(p1.x, p0.y), level).r),
+                        max(texelFetch(depth_pyramid, ivec2(p0.x, p1.y), level).r,
+                            texelFetch(depth_pyramid, p1, level).r));
+   return closest > farthest;
+}
+#else
+bool occluded(vec3 center, float radius)
+{
+   return false;
+}
+#endif
+
+void main()
+{
+   uint id = gl_GlobalInvocationID.x;
+   if (id >= params.object_count) {
+      return;
+   }
+   DrawObject object = objects[id];
+   vec3 center = object.bounding_sphere.xyz;
+   float radius = object.bounding_sphere.w;
+   bool late = (params.flags & LATE_PHASE) != 0;
+   bool test_occlusion = (params.flags & OCCLUSION) != 0;
+
+   if (late) {
+      if (retest[id] == 0) {
+         return;
+      }
+   }
+   else {
+      retest[id] = 0;
+      for (int i = 0; i < 6; i++) {
+         if (dot(params.frustum_planes[i].xyz, center) + params.frustum_planes[i].w < -radius) {
+            return;
+         }
+      }
+   }
+
+   if (test_occlusion && occluded(center, radius)) {
+      if (!late) {
+         retest[id] = 1;
+      }
+      return;
+   }
+
+   uint slot = atomicAdd(draw_count, 1);
+   commands[slot] = DrawCommand(
+       object.index_count, 1, object.first_index, object.vertex_offset, object.instance_index);
+}
+)";
+}  // namespace
+
+std::array<glm::vec4, 6> extract_frustum_planes(const glm::mat4& view_projection)
+{
+   // glm is column major, rows are gathered across the columns
+   const auto& m = view_projection;
+   auto row = [&](int i) { return glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]); };
+   const auto r0 = row(0);
+   const auto r1 = row(1);
+   const auto r2 = row(2);
+   const auto r3 = row(3);
+
+   // Near plane uses the -1..1 clip range glm::perspective produces, which is conservative
+   std::array<glm::vec4, 6> planes = {r3 + r0, r3 - r0, r3 + r1, r3 - r1, r3 + r2, r3 - r2};
+   for (auto& plane : planes) {
+      plane /= glm::length(glm::vec3(plane));
+   }
+   return planes;
+}
+
+std::expected<GpuCulling, error::Error> GpuCulling::create(Device* device,
+                                                           uint32_t max_objects,
+                                                           const DepthPyramid* pyramid)
+{
+   if (!device->enabled_vulkan12_features().drawIndirectCount) {
+      return std::unexpected(error::Error("GPU culling requires the drawIndirectCount feature"));
+   }
+   // The compacted commands carry each object's instance index as first_instance
+   if (!device->enabled_features().drawIndirectFirstInstance) {
+      return std::unexpected(
+          error::Error("GPU culling requires the drawIndirectFirstInstance feature"));
+   }
+   if (max_objects == 0) {
+      return std::unexpected(error::Error("GPU culling requires max_objects > 0"));
+   }
+
+   GpuCulling culling;
+   culling._device = device;
+   culling._max_objects = max_objects;
+
+   // Occlusion is compiled out without a pyramid, binding 5 is never written then
+   std::string source = culling_shader_source;
+   if (pyramid) {
+      const std::string version = "#version 450\n";
+      source.insert(source.find(version) + version.size(), "#define MEDDL_OCCLUSION 1\n");
+   }
+   auto spirv = engine::loader::compile_glsl(source, shaderc_glsl_compute_shader, "culling.comp");
+   if (!spirv) {
+      return std::unexpected(error::Error(spirv.error().message()));
+   }
+   culling._shader = std::make_unique<ShaderModule>(device, spirv->spirv_code);
+
+   GraphicsConfiguration config{};
+   culling._set_layout =
+       std::make_unique<DescriptorSetLayout>(device, config.descriptor_layouts.culling);
+
+   auto layout = PipelineLayout::create(device, culling._set_layout.get());
+   if (!layout) {
+      return std::unexpected(layout.error());
+   }
+   culling._pipeline_layout = std::make_unique<PipelineLayout>(std::move(layout.value()));
+
+   auto pipeline =
+       ComputePipeline::create(culling._shader.get(), device, culling._pipeline_layout.get());
+   if (!pipeline) {
+      return std::unexpected(pipeline.error());
+   }
+   culling._pipeline = std::make_unique<ComputePipeline>(std::move(pipeline.value()));
+
+   constexpr auto host_visible =
+       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+   culling._objects = std::make_unique<Buffer>(device,
+                                               draw_object_layout::stride * max_objects,
+                                               VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                               host_visible);
+   culling._objects->map();
+   culling._visibility = std::make_unique<Buffer>(device,
+                                                  sizeof(uint32_t) * max_objects,
+                                                  VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                                  VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+   culling._descriptor_pool =
+       std::make_unique<DescriptorPool>(device, config.descriptor_pools.culling);
+
+   for (size_t i = 0; i < culling._phases.size(); i++) {
+      auto& phase = culling._phases[i];
+      phase.params.flags = i == static_cast<size_t>(CullingPhase::Late)
+                               ? culling_layout::late_phase_flag
+                               : 0;
+      phase.params_buffer = std::make_unique<Buffer>(
+          device, culling_layout::stride, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, host_visible);
+      phase.params_buffer->map();
+
+      phase.draw_commands = std::make_unique<Buffer>(
+          device,
+          sizeof(VkDrawIndexedIndirectCommand) * max_objects,
+          VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+              VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+      phase.draw_count =
+          std::make_unique<Buffer>(device,
+                                   sizeof(uint32_t),
+                                   VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                       VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                                       VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                                       VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                   VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+      phase.descriptor_set = std::make_unique<DescriptorSet>(
+          device, culling._descriptor_pool.get(), culling._set_layout.get());
+      auto* set = phase.descriptor_set.get();
+      set->update(0, phase.params_buffer->vk(), 0, culling_layout::stride);
+      set->update(1, culling._objects->vk(), 0, VK_WHOLE_SIZE, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+      set->update(
+          2, phase.draw_commands->vk(), 0, VK_WHOLE_SIZE, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+      set->update(3, phase.draw_count->vk(), 0, VK_WHOLE_SIZE, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+      set->update(
+          4, culling._visibility->vk(), 0, VK_WHOLE_SIZE, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+   }
+
+   if (pyramid) {
+      culling._pyramid = pyramid;
+      if (auto res = culling.set_depth_pyramid(pyramid); !res) {
+         return std::unexpected(res.error());
+      }
+   }
+   culling.upload_params();
+
+   meddl::log::debug("Created GPU culling pass for {} objects, occlusion: {}",
+                     max_objects,
+                     pyramid != nullptr);
+   return culling;
+}
+
+void GpuCulling::set_objects(std::span<const DrawObject> objects)
+{
+   if (objects.size() > _max_objects) {
+      meddl::log::warn("GPU culling: {} objects exceed the capacity of {}, truncating",
+                       objects.size(),
+                       _max_objects);
+   }
+   _object_count = static_cast<uint32_t>(std::min<size_t>(objects.size(), _max_objects));
+   if (_object_count > 0) {
+      _objects->update(objects.data(), draw_object_layout::stride * _object_count);
+   }
+   for (auto& phase : _phases) {
+      phase.params.object_count = _object_count;
+   }
+   upload_params();
+}
+
+void GpuCulling::update_frustum(const glm::mat4& view_projection,
+                                std::optional<glm::mat4> pyramid_view_projection)
+{
+   const auto planes = extract_frustum_planes(view_projection);
+   auto& early = _phases[static_cast<size_t>(CullingPhase::Early)];
+   auto& late = _phases[static_cast<size_t>(CullingPhase::Late)];
+
+   early.params.frustum_planes = planes;
+   early.params.view_projection = pyramid_view_projection.value_or(view_projection);
+   if (_pyramid && pyramid_view_projection.has_value()) {
+      early.params.flags |= culling_layout::occlusion_flag;
+   }
+   else {
+      early.params.flags &= ~culling_layout::occlusion_flag;
+   }
+
+   // The late phase runs after this frame's pyramid build
+   late.params.frustum_planes = planes;
+   late.params.view_projection = view_projection;
+   upload_params();
+}
+
+std::expected<void, error::Error> GpuCulling::set_depth_pyramid(const DepthPyramid* pyramid)
+{
+   if (!pyramid) {
+      return std::unexpected(error::Error("GPU culling: depth pyramid is null"));
+   }
+   if (_pyramid == nullptr) {
+      return std::unexpected(error::Error("GPU culling: created without occlusion culling"));
+   }
+
+   _pyramid = pyramid;
+   for (auto& phase : _phases) {
+      phase.descriptor_set->update_image(
+          5, pyramid->view(), pyramid->sampler(), VK_IMAGE_LAYOUT_GENERAL);
+      phase.params.pyramid_size = {static_cast<float>(pyramid->extent().width),
+                                   static_cast<float>(pyramid->extent().height)};
+   }
+
+   // Contents of a new pyramid are undefined until its first build
+   auto& early = _phases[static_cast<size_t>(CullingPhase::Early)];
+   early.params.flags &= ~culling_layout::occlusion_flag;
+   auto& late = _phases[static_cast<size_t>(CullingPhase::Late)];
+   late.params.flags |= culling_layout::occlusion_flag;
+   upload_params();
+   return {};
+}
+
+void GpuCulling::upload_params()
+{
+   for (auto& phase : _phases) {
+      phase.params_buffer->update(&phase.params, culling_layout::stride);
+   }
+}
+
+std::expected<void, error::Error> GpuCulling::record(CommandBuffer* cmd, CullingPhase phase)
+{
+   if (cmd->state() != CommandBuffer::State::Recording) {
+      return std::unexpected(error::Error("Commandbuffer state is not recording"));
+   }
+   auto& resources = _phases[static_cast<size_t>(phase)];
+
+   vkCmdFillBuffer(cmd->vk(), resources.draw_count->vk(), 0, sizeof(uint32_t), 0);
+
+   VkBufferMemoryBarrier reset_barrier{};
+   reset_barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+   reset_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+   reset_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+   reset_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+   reset_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+   reset_barrier.buffer = resources.draw_count->vk();
+   reset_barrier.offset = 0;
+   reset_barrier.size = VK_WHOLE_SIZE;
+   vkCmdPipelineBarrier(cmd->vk(),
+                        VK_PIPELINE_STAGE_TRANSFER_BIT,
+                        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                        0,
+                        0,
+                        nullptr,
+                        1,
+                        &reset_barrier,
+                        0,
+                        nullptr);
+
+   if (auto res = cmd->bind_pipeline(_pipeline.get()); !res) {
+      return res;
+   }
+   vkCmdBindDescriptorSets(cmd->vk(),
+                           VK_PIPELINE_BIND_POINT_COMPUTE,
+                           _pipeline_layout->vk(),
+                           0,
+                           1,
+                           resources.descriptor_set->vk_ptr(),
+                           0,
+                           nullptr);
+
+   const uint32_t group_count = (_object_count + workgroup_size - 1) / workgroup_size;
+   if (group_count > 0) {
+      if (auto res = cmd->dispatch(group_count); !res) {
+         return res;
+      }
+   }
+
+   // Commands/count to the indirect draw, retest flags to the late phase
+   std::array<VkBufferMemoryBarrier, 3> barriers{};
+   for (auto& barrier : barriers) {
+      barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+      barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+      barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+      barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      barrier.offset = 0;
+      barrier.size = VK_WHOLE_SIZE;
+   }
+   barriers[0].buffer = resources.draw_commands->vk();
+   barriers[1].buffer = resources.draw_count->vk();
+   barriers[2].buffer = _visibility->vk();
+   barriers[2].dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+   vkCmdPipelineBarrier(cmd->vk(),
+                        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                        0,
+                        0,
+                        nullptr,
+                        static_cast<uint32_t>(barriers.size()),
+                        barriers.data(),
+                        0,
+                        nullptr);
+   return {};
+}
+
+std::expected<void, error::Error> GpuCulling::draw(CommandBuffer* cmd, CullingPhase phase)
+{
+   const auto& resources = _phases[static_cast<size_t>(phase)];
+   return cmd->draw_indexed_indirect_count(resources.draw_commands->vk(),
+                                           0,
+                                           resources.draw_count->vk(),
+                                           0,
+                                           _max_objects,
+                                           sizeof(VkDrawIndexedIndirectCommand));
+}
+
+}  // namespace meddl::render::vk
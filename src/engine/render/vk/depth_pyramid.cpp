@@ -0,0 +1,369 @@
+#include "engine/render/vk/depth_pyramid.h"
+
+#include <vulkan/vulkan_core.h>
+
+#include <algorithm>
+#include <bit>
+
+#include "core/log.h"
+#include "engine/shader.h"
+
+namespace meddl::render::vk {
+
+namespace {
+constexpr auto depth_reduce_shader_source = R"(
+#version 450
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(set = 0, binding = 0) uniform sampler2D source;
+layout(set = 0, binding = 1, r32f) uniform writeonly image2D destination;
+
+void main()
+{
+   ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+   ivec2 dst_size = imageSize(destination);
+   if (any(greaterThanEqual(texel, dst_size))) {
+      return;
+   }
+
+   // Footprint of the destination texel in the source, covers non power of two sources
+   ivec2 src_size = textureSize(source, 0);
+   ivec2 begin = (texel * src_size) / dst_size;
+   ivec2 end = min(max(((texel + 1) * src_size + dst_size - 1) / dst_size, begin + 1), src_size);
+
+   float depth = 0.0;
+   for (int y = begin.y; y < end.y; y++) {
+      for (int x = begin.x; x < end.x; x++) {
+         depth = max(depth, texelFetch(source, ivec2(x, y), 0).r);
+      }
+   }
+   imageStore(destination, texel, vec4(depth));
+}
+)";
+
+uint32_t previous_power_of_two(uint32_t value)
+{
+   return value == 0 ? 1 : std::bit_floor(value);
+}
+}  // namespace
+
+std::expected<DepthPyramid, error::Error> DepthPyramid::create(Device* device,
+                                                               VkExtent2D depth_extent)
+{
+   DepthPyramid pyramid;
+   pyramid._device = device;
+   pyramid._extent = {.width = previous_power_of_two(depth_extent.width),
+                      .height = previous_power_of_two(depth_extent.height)};
+   pyramid._levels = std::bit_width(std::max(pyramid._extent.width, pyramid._extent.height));
+
+   pyramid._image = Image::create_texture(device,
+                                          pyramid._extent.width,
+                                          pyramid._extent.height,
+                                          format,
+                                          pyramid._levels,
+                                          VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT |
+                                              VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
+
+   for (uint32_t level = 0; level < pyramid._levels; level++) {
+      VkImageViewCreateInfo view_info{};
+      view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+      view_info.image = pyramid._image.vk();
+      view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+      view_info.format = format;
+      view_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+      view_info.subresourceRange.baseMipLevel = level;
+      view_info.subresourceRange.levelCount = 1;
+      view_info.subresourceRange.baseArrayLayer = 0;
+      view_info.subresourceRange.layerCount = 1;
+
+      VkImageView view{VK_NULL_HANDLE};
+      auto result = vkCreateImageView(device->vk(), &view_info, device->get_allocators(), &view);
+      if (result != VK_SUCCESS) {
+         return std::unexpected(error::Error(
+             std::format("vkCreateImageView failed: {}", static_cast<int32_t>(result))));
+      }
+      pyramid._mip_views.push_back(view);
+   }
+
+   // texelFetch only, but a sampler is still required for the combined image sampler
+   auto sampler = Sampler::create(device,
+                                  {.magFilter = VK_FILTER_NEAREST,
+                                   .minFilter = VK_FILTER_NEAREST,
+                                   .addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+                                   .addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+                                   .addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+                                   .anisotropyEnable = VK_FALSE,
+                                   .maxAnisotropy = 1.0f,
+                                   .mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST});
+   if (!sampler) {
+      return std::unexpected(sampler.error());
+   }
+   pyramid._sampler = std::move(sampler.value());
+
+   auto spirv = engine::loader::compile_glsl(
+       depth_reduce_shader_source, shaderc_glsl_compute_shader, "depth_reduce.comp");
+   if (!spirv) {
+      return std::unexpected(error::Error(spirv.error().message()));
+   }
+   pyramid._shader = std::make_unique<ShaderModule>(device, spirv->spirv_code);
+
+   GraphicsConfiguration config{};
+   pyramid._set_layout =
+       std::make_unique<DescriptorSetLayout>(device, config.descriptor_layouts.depth_reduce);
+
+   auto layout = PipelineLayout::create(device, pyramid._set_layout.get());
+   if (!layout) {
+      return std::unexpected(layout.error());
+   }
+   pyramid._pipeline_layout = std::make_unique<PipelineLayout>(std::move(layout.value()));
+
+   auto pipeline =
+       ComputePipeline::create(pyramid._shader.get(), device, pyramid._pipeline_layout.get());
+   if (!pipeline) {
+      return std::unexpected(pipeline.error());
+   }
+   pyramid._pipeline = std::make_unique<ComputePipeline>(std::move(pipeline.value()));
+
+   GraphicsConfiguration::DescriptorPoolConfig pool_config{
+       .max_sets = pyramid._levels,
+       .pool_sizes = {
+           {.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, .descriptorCount = pyramid._levels},
+           {.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, .descriptorCount = pyramid._levels}}};
+   pyramid._descriptor_pool = std::make_unique<DescriptorPool>(device, pool_config);
+
+   // Level 0 reads the depth attachment, bound on the first build
+   pyramid._descriptor_sets.reserve(pyramid._levels);
+   for (uint32_t level = 0; level < pyramid._levels; level++) {
+      auto& set = pyramid._descriptor_sets.emplace_back(
+          device, pyramid._descriptor_pool.get(), pyramid._set_layout.get());
+      if (level > 0) {
+         set.update_image(0,
+                          pyramid._mip_views[level - 1],
+                          pyramid._sampler.vk(),
+                          VK_IMAGE_LAYOUT_GENERAL);
+      }
+      set.update_image(1,
+                       pyramid._mip_views[level],
+                       VK_NULL_HANDLE,
+                       VK_IMAGE_LAYOUT_GENERAL,
+                       VK_DESCRIPTOR_TYPE_STORAGE_IMAGE);
+   }
+
+   meddl::log::debug("Created depth pyramid {}x{} with {} levels",
+                     pyramid._extent.width,
+                     pyramid._extent.height,
+                     pyramid._levels);
+   return pyramid;
+}
+
+DepthPyramid::~DepthPyramid()
+{
+   destroy_views();
+}
+
+DepthPyramid::DepthPyramid(DepthPyramid&& other) noexcept
+    : _device(other._device),
+      _extent(other._extent),
+      _levels(other._levels),
+      _bound_source(other._bound_source),
+      _source_view(other._source_view),
+      _image(std::move(other._image)),
+      _mip_views(std::move(other._mip_views)),
+      _sampler(std::move(other._sampler)),
+      _shader(std::move(other._shader)),
+      _set_layout(std::move(other._set_layout)),
+      _pipeline_layout(std::move(other._pipeline_layout)),
+      _pipeline(std::move(other._pipeline)),
+      _descriptor_pool(std::move(other._descriptor_pool)),
+      _descriptor_sets(std::move(other._descriptor_sets))
+{
+   other._mip_views.clear();
+   other._device = nullptr;
+   other._bound_source = VK_NULL_HANDLE;
+   other._source_view = VK_NULL_HANDLE;
+}
+
+DepthPyramid& DepthPyramid::operator=(DepthPyramid&& other) noexcept
+{
+   if (this != &other) {
+      destroy_views();
+      _descriptor_sets.clear();
+
+      _device = other._device;
+      _extent = other._extent;
+      _levels = other._levels;
+      _bound_source = other._bound_source;
+      _source_view = other._source_view;
+      _image = std::move(other._image);
+      _mip_views = std::move(other._mip_views);
+      _sampler = std::move(other._sampler);
+      _shader = std::move(other._shader);
+      _set_layout = std::move(other._set_layout);
+      _pipeline_layout = std::move(other._pipeline_layout);
+      _pipeline = std::move(other._pipeline);
+      _descriptor_pool = std::move(other._descriptor_pool);
+      _descriptor_sets = std::move(other._descriptor_sets);
+
+      other._mip_views.clear();
+      other._device = nullptr;
+      other._bound_source = VK_NULL_HANDLE;
+      other._source_view = VK_NULL_HANDLE;
+   }
+   return *this;
+}
+
+void DepthPyramid::destroy_views()
+{
+   for (auto view : _mip_views) {
+      vkDestroyImageView(_device->vk(), view, _device->get_allocators());
+   }
+   _mip_views.clear();
+   if (_source_view != VK_NULL_HANDLE) {
+      vkDestroyImageView(_device->vk(), _source_view, _device->get_allocators());
+      _source_view = VK_NULL_HANDLE;
+   }
+}
+
+std::expected<void, error::Error> DepthPyramid::build(CommandBuffer* cmd,
+                                                      const Image& depth,
+                                                      VkImageLayout depth_layout)
+{
+   if (cmd->state() != CommandBuffer::State::Recording) {
+      return std::unexpected(error::Error("Commandbuffer state is not recording"));
+   }
+
+   if (_bound_source != depth.vk()) {
+      // The attachment's own view includes stencil for combined formats, which can't be sampled
+      auto view_info = depth.config().get_view_create_info(depth.vk());
+      view_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+      VkImageView view{VK_NULL_HANDLE};
+      auto result = vkCreateImageView(_device->vk(), &view_info, _device->get_allocators(), &view);
+      if (result != VK_SUCCESS) {
+         return std::unexpected(error::Error(
+             std::format("vkCreateImageView failed: {}", static_cast<int32_t>(result))));
+      }
+      if (_source_view != VK_NULL_HANDLE) {
+         vkDestroyImageView(_device->vk(), _source_view, _device->get_allocators());
+      }
+      _source_view = view;
+      _descriptor_sets.front().update_image(
+          0, _source_view, _sampler.vk(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+      _bound_source = depth.vk();
+   }
+
+   // Depth writes -> compute reads, the previous pyramid contents are discarded
+   std::array<VkImageMemoryBarrier, 2> begin_barriers{};
+   auto& depth_barrier = begin_barriers[0];
+   depth_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+   depth_barrier.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+   depth_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+   depth_barrier.oldLayout = depth_layout;
+   depth_barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+   depth_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+   depth_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+   depth_barrier.image = depth.vk();
+   depth_barrier.subresourceRange = {.aspectMask = depth.config().get_aspect_mask(),
+                                     .baseMipLevel = 0,
+                                     .levelCount = 1,
+                                     .baseArrayLayer = 0,
+                                     .layerCount = 1};
+
+   auto& pyramid_barrier = begin_barriers[1];
+   pyramid_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+   pyramid_barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+   pyramid_barrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+   pyramid_barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+   pyramid_barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+   pyramid_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+   pyramid_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+   pyramid_barrier.image = _image.vk();
+   pyramid_barrier.subresourceRange = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                                       .baseMipLevel = 0,
+                                       .levelCount = VK_REMAINING_MIP_LEVELS,
+                                       .baseArrayLayer = 0,
+                                       .layerCount = 1};
+
+   vkCmdPipelineBarrier(cmd->vk(),
+                        VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+                            VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT |
+                            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                        0,
+                        0,
+                        nullptr,
+                        0,
+                        nullptr,
+                        static_cast<uint32_t>(begin_barriers.size()),
+                        begin_barriers.data());
+
+   if (auto res = cmd->bind_pipeline(_pipeline.get()); !res) {
+      return res;
+   }
+
+   for (uint32_t level = 0; level < _levels; level++) {
+      vkCmdBindDescriptorSets(cmd->vk(),
+                              VK_PIPELINE_BIND_POINT_COMPUTE,
+                              _pipeline_layout->vk(),
+                              0,
+                              1,
+                              _descriptor_sets[level].vk_ptr(),
+                              0,
+                              nullptr);
+
+      const uint32_t width = std::max(_extent.width >> level, 1u);
+      const uint32_t height = std::max(_extent.height >> level, 1u);
+      if (auto res = cmd->dispatch((width + workgroup_size - 1) / workgroup_size,
+                                   (height + workgroup_size - 1) / workgroup_size);
+          !res) {
+         return res;
+      }
+
+      // The level just written is the input of the next one, and of the culling pass
+      VkImageMemoryBarrier level_barrier{};
+      level_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+      level_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+      level_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+      level_barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+      level_barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+      level_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      level_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      level_barrier.image = _image.vk();
+      level_barrier.subresourceRange = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                                        .baseMipLevel = level,
+                                        .levelCount = 1,
+                                        .baseArrayLayer = 0,
+                                        .layerCount = 1};
+      vkCmdPipelineBarrier(cmd->vk(),
+                           VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                           VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                           0,
+                           0,
+                           nullptr,
+                           0,
+                           nullptr,
+                           1,
+                           &level_barrier);
+   }
+
+   // Hand the depth attachment back to the next renderpass
+   VkImageMemoryBarrier end_barrier = depth_barrier;
+   end_barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+   end_barrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+                               VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+   end_barrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+   end_barrier.newLayout = depth_layout;
+   vkCmdPipelineBarrier(cmd->vk(),
+                        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                        VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+                            VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                        0,
+                        0,
+                        nullptr,
+                        0,
+                        nullptr,
+                        1,
+                        &end_barrier);
+   return {};
+}
+
+}  // namespace meddl::render::vk
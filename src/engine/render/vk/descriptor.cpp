@@ -1,5 +1,6 @@
 #include "engine/render/vk/descriptor.h"
 
+#include <format>
 #include <stdexcept>
 
 #include "engine/render/vk/shared.h"
@@ -16,6 +17,17 @@ DescriptorSetLayout::DescriptorSetLayout(
    layout_info.pBindings = config.bindings.data();
    layout_info.flags = config.flags;
 
+   VkDescriptorSetLayoutBindingFlagsCreateInfo binding_flags{};
+   if (!config.binding_flags.empty()) {
+      if (config.binding_flags.size() != config.bindings.size()) {
+         throw std::runtime_error("Descriptor binding flags must match the number of bindings");
+      }
+      binding_flags.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+      binding_flags.bindingCount = static_cast<uint32_t>(config.binding_flags.size());
+      binding_flags.pBindingFlags = config.binding_flags.data();
+      layout_info.pNext = &binding_flags;
+   }
+
    if (vkCreateDescriptorSetLayout(
            _device->vk(), &layout_info, config.custom_allocator, &_layout) != VK_SUCCESS) {
       throw std::runtime_error("Failed to create descriptor set layout");
@@ -104,7 +116,8 @@ DescriptorSet::DescriptorSet(Device* device, DescriptorPool* pool, DescriptorSet
 void DescriptorSet::update(uint32_t binding,
                            VkBuffer buffer,
                            VkDeviceSize offset,
-                           VkDeviceSize range)
+                           VkDeviceSize range,
+                           VkDescriptorType type)
 {
    VkDescriptorBufferInfo buffer_info{};
    buffer_info.buffer = buffer;
@@ -116,7 +129,7 @@ void DescriptorSet::update(uint32_t binding,
    descriptor_write.dstSet = _set;
    descriptor_write.dstBinding = binding;
    descriptor_write.dstArrayElement = 0;
-   descriptor_write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+   descriptor_write.descriptorType = type;
    descriptor_write.descriptorCount = 1;
    descriptor_write.pBufferInfo = &buffer_info;
 
@@ -125,7 +138,9 @@ void DescriptorSet::update(uint32_t binding,
 void DescriptorSet::update_image(uint32_t binding,
                                  VkImageView view,
                                  VkSampler sampler,
-                                 VkImageLayout layout)
+                                 VkImageLayout layout,
+                                 VkDescriptorType type,
+                                 uint32_t array_element)
 {
    VkDescriptorImageInfo image_info{};
    image_info.imageLayout = layout;
@@ -136,12 +151,138 @@ void DescriptorSet::update_image(uint32_t binding,
    descriptor_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
    descriptor_write.dstSet = _set;
    descriptor_write.dstBinding = binding;
-   descriptor_write.dstArrayElement = 0;
-   descriptor_write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+   descriptor_write.dstArrayElement = array_element;
+   descriptor_write.descriptorType = type;
    descriptor_write.descriptorCount = 1;
    descriptor_write.pImageInfo = &image_info;
 
    vkUpdateDescriptorSets(_device->vk(), 1, &descriptor_write, 0, nullptr);
 }
 
+DescriptorWriter& DescriptorWriter::write_buffer(VkDescriptorSet set,
+                                                 uint32_t binding,
+                                                 VkBuffer buffer,
+                                                 VkDeviceSize offset,
+                                                 VkDeviceSize range,
+                                                 VkDescriptorType type,
+                                                 uint32_t array_element)
+{
+   auto& info = _buffer_infos.emplace_back(
+       VkDescriptorBufferInfo{.buffer = buffer, .offset = offset, .range = range});
+
+   VkWriteDescriptorSet write{};
+   write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+   write.dstSet = set;
+   write.dstBinding = binding;
+   write.dstArrayElement = array_element;
+   write.descriptorType = type;
+   write.descriptorCount = 1;
+   write.pBufferInfo = &info;
+   _writes.push_back(write);
+   return *this;
+}
+
+DescriptorWriter& DescriptorWriter::write_image(VkDescriptorSet set,
+                                                uint32_t binding,
+                                                VkImageView view,
+                                                VkSampler sampler,
+                                                VkImageLayout layout,
+                                                VkDescriptorType type,
+                                                uint32_t array_element)
+{
+   auto& info = _image_infos.emplace_back(
+       VkDescriptorImageInfo{.sampler = sampler, .imageView = view, .imageLayout = layout});
+
+   VkWriteDescriptorSet write{};
+   write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+   write.dstSet = set;
+   write.dstBinding = binding;
+   write.dstArrayElement = array_element;
+   write.descriptorType = type;
+   write.descriptorCount = 1;
+   write.pImageInfo = &info;
+   _writes.push_back(write);
+   return *this;
+}
+
+void DescriptorWriter::flush(const Device* device)
+{
+   if (!_writes.empty()) {
+      vkUpdateDescriptorSets(
+          device->vk(), static_cast<uint32_t>(_writes.size()), _writes.data(), 0, nullptr);
+   }
+   clear();
+}
+
+void DescriptorWriter::clear()
+{
+   _writes.clear();
+   _buffer_infos.clear();
+   _image_infos.clear();
+}
+
+std::expected<DescriptorUpdateTemplate, error::Error> DescriptorUpdateTemplate::create(
+    Device* device,
+    const DescriptorSetLayout* layout,
+    std::span<const VkDescriptorUpdateTemplateEntry> entries)
+{
+   if (entries.empty()) {
+      return std::unexpected(error::Error("Descriptor update template needs entries"));
+   }
+   DescriptorUpdateTemplate update_template;
+   update_template._device = device;
+
+   VkDescriptorUpdateTemplateCreateInfo create_info{};
+   create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+   create_info.descriptorUpdateEntryCount = static_cast<uint32_t>(entries.size());
+   create_info.pDescriptorUpdateEntries = entries.data();
+   create_info.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+   create_info.descriptorSetLayout = layout->vk();
+
+   auto result = vkCreateDescriptorUpdateTemplate(device->vk(),
+                                                  &create_info,
+                                                  device->get_allocators(),
+                                                  &update_template._template);
+   if (result != VK_SUCCESS) {
+      return std::unexpected(error::Error(std::format(
+          "vkCreateDescriptorUpdateTemplate failed: {}", static_cast<int32_t>(result))));
+   }
+   return update_template;
+}
+
+DescriptorUpdateTemplate::~DescriptorUpdateTemplate()
+{
+   if (_template && _device) {
+      vkDestroyDescriptorUpdateTemplate(_device->vk(), _template, _device->get_allocators());
+   }
+}
+
+DescriptorUpdateTemplate::DescriptorUpdateTemplate(DescriptorUpdateTemplate&& other) noexcept
+    : _device(other._device), _template(other._template)
+{
+   other._device = nullptr;
+   other._template = VK_NULL_HANDLE;
+}
+
+DescriptorUpdateTemplate& DescriptorUpdateTemplate::operator=(
+    DescriptorUpdateTemplate&& other) noexcept
+{
+   if (this != &other) {
+      if (_template && _device) {
+         vkDestroyDescriptorUpdateTemplate(_device->vk(), _template, _device->get_allocators());
+      }
+      _device = other._device;
+      _template = other._template;
+
+      other._device = nullptr;
+      other._template = VK_NULL_HANDLE;
+   }
+   return *this;
+}
+
+void DescriptorUpdateTemplate::update(VkDescriptorSet set, const void* data) const
+{
+   vkUpdateDescriptorSetWithTemplate(_device->vk(), set, _template, data);
+}
+
 }  // namespace meddl::render::vk
@@ -0,0 +1,239 @@
+#include "engine/render/vk/descriptor_allocator.h"
+
+#include <vulkan/vulkan_core.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include "core/log.h"
+#include "engine/render/vk/hash.hpp"
+
+namespace meddl::render::vk {
+
+namespace {
+constexpr std::array default_ratios = {
+    DescriptorAllocator::PoolRatio{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1.0f},
+    DescriptorAllocator::PoolRatio{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.0f},
+    DescriptorAllocator::PoolRatio{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.0f},
+    DescriptorAllocator::PoolRatio{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2.0f},
+    DescriptorAllocator::PoolRatio{VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.0f},
+};
+}  // namespace
+
+size_t DescriptorAllocator::CacheKeyHash::operator()(const CacheKey& key) const noexcept
+{
+   size_t seed = std::hash<VkDescriptorSetLayout>{}(key.layout);
+   for (const auto& b : key.bindings) {
+      seed = hash_combine(seed, b.binding);
+      seed = hash_combine(seed, static_cast<uint32_t>(b.type));
+      seed = hash_combine(seed, b.buffer);
+      seed = hash_combine(seed, b.offset);
+      seed = hash_combine(seed, b.range);
+      seed = hash_combine(seed, b.view);
+      seed = hash_combine(seed, b.sampler);
+      seed = hash_combine(seed, static_cast<uint32_t>(b.layout));
+   }
+   return seed;
+}
+
+std::expected<DescriptorAllocator, error::Error> DescriptorAllocator::create(
+    Device* device, std::span<const PoolRatio> ratios, uint32_t initial_sets)
+{
+   if (ratios.empty() || initial_sets == 0) {
+      return std::unexpected(error::Error("DescriptorAllocator needs pool ratios and sets"));
+   }
+   DescriptorAllocator allocator;
+   allocator._device = device;
+   allocator._ratios.assign(ratios.begin(), ratios.end());
+   allocator._sets_per_pool = std::min(initial_sets, max_sets_per_pool);
+
+   auto pool = allocator.create_pool(allocator._sets_per_pool);
+   if (!pool) {
+      return std::unexpected(pool.error());
+   }
+   allocator._ready_pools.push_back(pool.value());
+   return allocator;
+}
+
+std::expected<DescriptorAllocator, error::Error> DescriptorAllocator::create(Device* device,
+                                                                             uint32_t initial_sets)
+{
+   return create(device, default_ratios, initial_sets);
+}
+
+DescriptorAllocator::~DescriptorAllocator()
+{
+   destroy();
+}
+
+DescriptorAllocator::DescriptorAllocator(DescriptorAllocator&& other) noexcept
+    : _device(other._device),
+      _ratios(std::move(other._ratios)),
+      _sets_per_pool(other._sets_per_pool),
+      _ready_pools(std::move(other._ready_pools)),
+      _full_pools(std::move(other._full_pools)),
+      _cache(std::move(other._cache))
+{
+   other._device = nullptr;
+   other._ready_pools.clear();
+   other._full_pools.clear();
+   other._cache.clear();
+}
+
+DescriptorAllocator& DescriptorAllocator::operator=(DescriptorAllocator&& other) noexcept
+{
+   if (this != &other) {
+      destroy();
+      _device = other._device;
+      _ratios = std::move(other._ratios);
+      _sets_per_pool = other._sets_per_pool;
+      _ready_pools = std::move(other._ready_pools);
+      _full_pools = std::move(other._full_pools);
+      _cache = std::move(other._cache);
+
+      other._device = nullptr;
+      other._ready_pools.clear();
+      other._full_pools.clear();
+      other._cache.clear();
+   }
+   return *this;
+}
+
+void DescriptorAllocator::destroy()
+{
+   if (!_device) {
+      return;
+   }
+   for (auto pool : _ready_pools) {
+      vkDestroyDescriptorPool(_device->vk(), pool, _device->get_allocators());
+   }
+   for (auto pool : _full_pools) {
+      vkDestroyDescriptorPool(_device->vk(), pool, _device->get_allocators());
+   }
+   _ready_pools.clear();
+   _full_pools.clear();
+   _cache.clear();
+}
+
+std::expected<VkDescriptorPool, error::Error> DescriptorAllocator::create_pool(uint32_t set_count)
+{
+   std::vector<VkDescriptorPoolSize> sizes;
+   sizes.reserve(_ratios.size());
+   for (const auto& ratio : _ratios) {
+      sizes.push_back(
+          {.type = ratio.type,
+           .descriptorCount = std::max(
+               1u, static_cast<uint32_t>(std::ceil(ratio.ratio * static_cast<float>(set_count))))});
+   }
+
+   VkDescriptorPoolCreateInfo pool_info{};
+   pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+   pool_info.maxSets = set_count;
+   pool_info.poolSizeCount = static_cast<uint32_t>(sizes.size());
+   pool_info.pPoolSizes = sizes.data();
+
+   VkDescriptorPool pool{VK_NULL_HANDLE};
+   auto result =
+       vkCreateDescriptorPool(_device->vk(), &pool_info, _device->get_allocators(), &pool);
+   if (result != VK_SUCCESS) {
+      return std::unexpected(error::Error(
+          std::format("vkCreateDescriptorPool failed: {}", static_cast<int32_t>(result))));
+   }
+   return pool;
+}
+
+std::expected<VkDescriptorPool, error::Error> DescriptorAllocator::grab_pool()
+{
+   if (!_ready_pools.empty()) {
+      auto pool = _ready_pools.back();
+      _ready_pools.pop_back();
+      return pool;
+   }
+   // Grow geometrically so the number of pools stays logarithmic in the peak set count
+   _sets_per_pool = std::min(_sets_per_pool + (_sets_per_pool + 1) / 2, max_sets_per_pool);
+   meddl::log::debug("Descriptor allocator growing, new pool with {} sets", _sets_per_pool);
+   return create_pool(_sets_per_pool);
+}
+
+std::expected<VkDescriptorSet, error::Error> DescriptorAllocator::allocate(
+    const DescriptorSetLayout* layout)
+{
+   if (!_device) {
+      return std::unexpected(error::Error("DescriptorAllocator is not created"));
+   }
+   auto pool = grab_pool();
+   if (!pool) {
+      return std::unexpected(pool.error());
+   }
+
+   VkDescriptorSetAllocateInfo alloc_info{};
+   alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+   alloc_info.descriptorPool = pool.value();
+   alloc_info.descriptorSetCount = 1;
+   alloc_info.pSetLayouts = layout->vk_ptr();
+
+   VkDescriptorSet set{VK_NULL_HANDLE};
+   auto result = vkAllocateDescriptorSets(_device->vk(), &alloc_info, &set);
+   if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL) {
+      _full_pools.push_back(pool.value());
+      pool = grab_pool();
+      if (!pool) {
+         return std::unexpected(pool.error());
+      }
+      alloc_info.descriptorPool = pool.value();
+      result = vkAllocateDescriptorSets(_device->vk(), &alloc_info, &set);
+   }
+   _ready_pools.push_back(pool.value());
+   if (result != VK_SUCCESS) {
+      return std::unexpected(error::Error(
+          std::format("vkAllocateDescriptorSets failed: {}", static_cast<int32_t>(result))));
+   }
+   return set;
+}
+
+std::expected<VkDescriptorSet, error::Error> DescriptorAllocator::get(
+    const DescriptorSetLayout* layout, std::span<const DescriptorBinding> bindings)
+{
+   CacheKey key{.layout = layout->vk(), .bindings = {bindings.begin(), bindings.end()}};
+   if (auto it = _cache.find(key); it != _cache.end()) {
+      return it->second;
+   }
+
+   auto set = allocate(layout);
+   if (!set) {
+      return std::unexpected(set.error());
+   }
+
+   DescriptorWriter writer;
+   for (const auto& b : bindings) {
+      if (b.buffer != VK_NULL_HANDLE) {
+         writer.write_buffer(set.value(), b.binding, b.buffer, b.offset, b.range, b.type);
+      }
+      else {
+         writer.write_image(set.value(), b.binding, b.view, b.sampler, b.layout, b.type);
+      }
+   }
+   writer.flush(_device);
+
+   _cache.emplace(std::move(key), set.value());
+   return set.value();
+}
+
+void DescriptorAllocator::reset()
+{
+   if (!_device) {
+      return;
+   }
+   for (auto pool : _ready_pools) {
+      vkResetDescriptorPool(_device->vk(), pool, 0);
+   }
+   for (auto pool : _full_pools) {
+      vkResetDescriptorPool(_device->vk(), pool, 0);
+      _ready_pools.push_back(pool);
+   }
+   _full_pools.clear();
+   _cache.clear();
+}
+
+}  // namespace meddl::render::vk
@@ -2,6 +2,7 @@
 
 #include <vulkan/vulkan_core.h>
 
+#include <algorithm>
 #include <expected>
 #include <vector>
 
@@ -64,6 +65,38 @@ std::expected<Device, meddl::error::Error> Device::create(PhysicalDevice* physic
    create_info.ppEnabledLayerNames = layers_cstyle.data();
 
    auto* last_structure = std::bit_cast<VkBaseOutStructure*>(&create_info);
+
+   VkPhysicalDeviceVulkan12Features vulkan12_features{};
+   if (config.vulkan12_features.has_value()) {
+      vulkan12_features = config.vulkan12_features.value();
+      vulkan12_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+      vulkan12_features.pNext = nullptr;
+      last_structure->pNext = std::bit_cast<VkBaseOutStructure*>(&vulkan12_features);
+      last_structure = last_structure->pNext;
+   }
+
+   VkPhysicalDeviceVulkan13Features vulkan13_features{};
+   if (config.vulkan13_features.has_value()) {
+      vulkan13_features = config.vulkan13_features.value();
+      vulkan13_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+      vulkan13_features.pNext = nullptr;
+      last_structure->pNext = std::bit_cast<VkBaseOutStructure*>(&vulkan13_features);
+      last_structure = last_structure->pNext;
+   }
+
+   VkPhysicalDevicePresentWaitFeaturesKHR present_wait_features{};
+   VkPhysicalDevicePresentIdFeaturesKHR present_id_features{};
+   if (config.present_wait) {
+      present_id_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+      present_id_features.presentId = VK_TRUE;
+      present_wait_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+      present_wait_features.presentWait = VK_TRUE;
+      last_structure->pNext = std::bit_cast<VkBaseOutStructure*>(&present_id_features);
+      last_structure = last_structure->pNext;
+      last_structure->pNext = std::bit_cast<VkBaseOutStructure*>(&present_wait_features);
+      last_structure = last_structure->pNext;
+   }
+
    for (const auto& feature_pair : config.feature_chain) {
       auto structure = std::bit_cast<VkBaseOutStructure*>(feature_pair.second);
       structure->sType = feature_pair.first;
@@ -80,6 +113,11 @@ std::expected<Device, meddl::error::Error> Device::create(PhysicalDevice* physic
 
    device._enabled_extensions = config.extensions;
    device._enabled_features = device_features;
+   device._enabled_vulkan12_features = vulkan12_features;
+   device._enabled_vulkan12_features.pNext = nullptr;
+   device._enabled_vulkan13_features = vulkan13_features;
+   device._enabled_vulkan13_features.pNext = nullptr;
+   device._present_wait = config.present_wait;
 
    for (auto& config_pair : config.queue_configurations) {
       for (uint32_t i = 0; i < config_pair.second._queue_count; i++) {
@@ -88,9 +126,44 @@ std::expected<Device, meddl::error::Error> Device::create(PhysicalDevice* physic
          device._queues.emplace_back(queue, i, config_pair.second);
       }
    }
+   for (const auto& [role, family] : config.queue_roles) {
+      auto queue = std::ranges::find_if(
+          device._queues, [family](const Queue& q) { return q.family_index() == family; });
+      if (queue != device._queues.end()) {
+         queue->add_type(role);
+      }
+   }
+   if (!device.has_own_queue(QueueFamilyType::Compute)) {
+      meddl::log::info("No queue of its own for compute, it shares the graphics queue");
+   }
+   if (!device.has_own_queue(QueueFamilyType::Transfer)) {
+      meddl::log::info("No queue of its own for transfers, they share the graphics queue");
+   }
    return device;
 }
 
+const Queue& Device::queue(QueueFamilyType role) const
+{
+   auto queue = std::ranges::find_if(_queues, [role](const Queue& q) { return q.has_type(role); });
+   if (queue == _queues.end() && role != QueueFamilyType::Graphics) {
+      return this->queue(QueueFamilyType::Graphics);
+   }
+   return queue != _queues.end() ? *queue : _queues.at(0);
+}
+
+bool Device::has_own_queue(QueueFamilyType role) const
+{
+   return queue(role).vk() != queue(QueueFamilyType::Graphics).vk();
+}
+
+const Queue& Device::queue_for_family(uint32_t queue_family_index) const
+{
+   auto queue = std::ranges::find_if(_queues, [queue_family_index](const Queue& q) {
+      return q.family_index() == queue_family_index;
+   });
+   return queue != _queues.end() ? *queue : _queues.at(0);
+}
+
 Device::Device(PhysicalDevice* physical_device,
                const DeviceConfiguration& config,
                const std::optional<Debugger>& debugger)
@@ -109,7 +182,12 @@ Device::~Device()
 Device::Device(Device&& other) noexcept
     : _queues(std::move(other._queues)),
       _device(other._device),
-      _physical_device(other._physical_device)
+      _physical_device(other._physical_device),
+      _enabled_extensions(std::move(other._enabled_extensions)),
+      _enabled_features(other._enabled_features),
+      _enabled_vulkan12_features(other._enabled_vulkan12_features),
+      _enabled_vulkan13_features(other._enabled_vulkan13_features),
+      _present_wait(other._present_wait)
 {
    other._device = VK_NULL_HANDLE;
    other._physical_device = nullptr;
@@ -125,6 +203,11 @@ Device& Device::operator=(Device&& other) noexcept
       _physical_device = other._physical_device;
       _device = other._device;
       _queues = std::move(other._queues);
+      _enabled_extensions = std::move(other._enabled_extensions);
+      _enabled_features = other._enabled_features;
+      _enabled_vulkan12_features = other._enabled_vulkan12_features;
+      _enabled_vulkan13_features = other._enabled_vulkan13_features;
+      _present_wait = other._present_wait;
 
       other._device = VK_NULL_HANDLE;
       other._physical_device = nullptr;
@@ -202,7 +285,9 @@ DeviceConfiguration DevicePicker::create_config(PhysicalDevice* device,
    std::unordered_map<uint32_t, QueueConfiguration> queue_configs;
 
    auto graphics_family = device->get_queue_family(VK_QUEUE_GRAPHICS_BIT);
-   auto present_family = device->get_present_family(_surface);
+   // No surface when headless
+   auto present_family =
+       _surface ? device->get_present_family(_surface) : std::optional<uint32_t>{};
    if (reqs.required_queue_types.find(VK_QUEUE_GRAPHICS_BIT) != reqs.required_queue_types.end()) {
       if (!graphics_family.has_value()) {
          meddl::log::error("Graphics family required, but not found");
@@ -210,6 +295,7 @@ DeviceConfiguration DevicePicker::create_config(PhysicalDevice* device,
       }
       queue_configs.emplace(graphics_family.value(),
                             QueueConfiguration(graphics_family.value(), 1.0f, 1));
+      config.queue_roles.emplace(QueueFamilyType::Graphics, graphics_family.value());
       meddl::log::debug("Picked graphics family: {}, prio: 1.0, count: 1", graphics_family.value());
    }
 
@@ -224,10 +310,16 @@ DeviceConfiguration DevicePicker::create_config(PhysicalDevice* device,
          meddl::log::debug("Picked present family: {}, prio: 1.0, count: 1",
                            present_family.value());
       }
+      config.queue_roles.emplace(QueueFamilyType::Present, present_family.value());
    }
 
+   // Dedicated families first, so compute and transfer can overlap with graphics
    if (reqs.required_queue_types.find(VK_QUEUE_COMPUTE_BIT) != reqs.required_queue_types.end()) {
-      auto compute_family = device->get_queue_family(VK_QUEUE_COMPUTE_BIT);
+      auto compute_family =
+          device->get_dedicated_queue_family(VK_QUEUE_COMPUTE_BIT, VK_QUEUE_GRAPHICS_BIT);
+      if (!compute_family.has_value()) {
+         compute_family = device->get_queue_family(VK_QUEUE_COMPUTE_BIT);
+      }
       if (compute_family.has_value()) {
          if (queue_configs.find(compute_family.value()) == queue_configs.end()) {
             queue_configs.emplace(compute_family.value(),
@@ -235,19 +327,25 @@ DeviceConfiguration DevicePicker::create_config(PhysicalDevice* device,
             meddl::log::debug("Picked compute family: {}, prio: 1.0, count: 1",
                               compute_family.value());
          }
+         config.queue_roles.emplace(QueueFamilyType::Compute, compute_family.value());
       }
    }
 
    if (reqs.required_queue_types.find(VK_QUEUE_TRANSFER_BIT) != reqs.required_queue_types.end()) {
-      auto transfer_family = device->get_queue_family(VK_QUEUE_TRANSFER_BIT);
+      auto transfer_family = device->get_dedicated_queue_family(
+          VK_QUEUE_TRANSFER_BIT, VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT);
+      if (!transfer_family.has_value()) {
+         transfer_family = device->get_queue_family(VK_QUEUE_TRANSFER_BIT);
+      }
 
       if (transfer_family.has_value()) {
          if (queue_configs.find(transfer_family.value()) == queue_configs.end()) {
             queue_configs.emplace(transfer_family.value(),
                                   QueueConfiguration(transfer_family.value(), 1.0f, 1));
-            meddl::log::debug("Picked compute family: {}, prio: 1.0, count: 1",
+            meddl::log::debug("Picked transfer family: {}, prio: 1.0, count: 1",
                               transfer_family.value());
          }
+         config.queue_roles.emplace(QueueFamilyType::Transfer, transfer_family.value());
       }
    }
 
@@ -257,6 +355,43 @@ DeviceConfiguration DevicePicker::create_config(PhysicalDevice* device,
    }
 
    config.queue_configurations = std::move(queue_configs);
+
+   // Indirect drawing is opt-in per device, GPU driven passes check the enabled features
+   const auto& supported = device->get_features();
+   if (config.features.has_value()) {
+      config.features->multiDrawIndirect = supported.multiDrawIndirect;
+      config.features->drawIndirectFirstInstance = supported.drawIndirectFirstInstance;
+   }
+   if (device->get_properties().apiVersion >= VK_API_VERSION_1_2) {
+      const auto& supported12 = device->get_vulkan12_features();
+      VkPhysicalDeviceVulkan12Features vulkan12{};
+      vulkan12.drawIndirectCount = supported12.drawIndirectCount;
+      // Bindless, see BindlessTable
+      vulkan12.descriptorIndexing = supported12.descriptorIndexing;
+      vulkan12.runtimeDescriptorArray = supported12.runtimeDescriptorArray;
+      vulkan12.descriptorBindingPartiallyBound = supported12.descriptorBindingPartiallyBound;
+      vulkan12.descriptorBindingSampledImageUpdateAfterBind =
+          supported12.descriptorBindingSampledImageUpdateAfterBind;
+      vulkan12.descriptorBindingUpdateUnusedWhilePending =
+          supported12.descriptorBindingUpdateUnusedWhilePending;
+      vulkan12.shaderSampledImageArrayNonUniformIndexing =
+          supported12.shaderSampledImageArrayNonUniformIndexing;
+      config.vulkan12_features = vulkan12;
+   }
+   if (device->get_properties().apiVersion >= VK_API_VERSION_1_3) {
+      VkPhysicalDeviceVulkan13Features vulkan13{};
+      // vkCmdPipelineBarrier2, see RenderGraph
+      vulkan13.synchronization2 = device->get_vulkan13_features().synchronization2;
+      // vkCmdBeginRendering, see CommandBuffer::begin_rendering
+      vulkan13.dynamicRendering = device->get_vulkan13_features().dynamicRendering;
+      config.vulkan13_features = vulkan13;
+   }
+   // Latency waits in FramePacer, optional
+   if (reqs.requires_presentation && device->supports_present_wait()) {
+      config.extensions.insert(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+      config.extensions.insert(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+      config.present_wait = true;
+   }
    return config;
 };
 
@@ -292,6 +427,11 @@ std::optional<DevicePickerResult> DevicePicker::pick_best(DevicePickerStrategy s
          // Scoring function emphasizing compute capabilities
          break;
    }
+   // Headless, nothing to present to
+   if (!_surface) {
+      reqs.required_extensions.clear();
+      reqs.requires_presentation = false;
+   }
    return pick_custom(reqs, allow_best_effort);
 }
 
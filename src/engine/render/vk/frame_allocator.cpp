@@ -0,0 +1,77 @@
+#include "engine/render/vk/frame_allocator.h"
+
+#include <vulkan/vulkan_core.h>
+
+#include <algorithm>
+
+#include "core/log.h"
+
+namespace meddl::render::vk {
+
+namespace {
+constexpr VkDeviceSize align_up(VkDeviceSize value, VkDeviceSize alignment)
+{
+   return (value + alignment - 1) / alignment * alignment;
+}
+}  // namespace
+
+std::expected<FrameAllocator, error::Error> FrameAllocator::create(Device* device,
+                                                                   VkDeviceSize bytes_per_frame,
+                                                                   uint32_t frames_in_flight,
+                                                                   VkBufferUsageFlags usage)
+{
+   if (bytes_per_frame == 0 || frames_in_flight == 0) {
+      return std::unexpected(error::Error("FrameAllocator needs a non zero size and frame count"));
+   }
+
+   FrameAllocator allocator;
+   const auto& limits = device->physical_device()->get_properties().limits;
+   if (usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT) {
+      allocator._alignment = std::max(allocator._alignment, limits.minUniformBufferOffsetAlignment);
+   }
+   if (usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT) {
+      allocator._alignment = std::max(allocator._alignment, limits.minStorageBufferOffsetAlignment);
+   }
+   allocator._frame_size = align_up(bytes_per_frame, allocator._alignment);
+   allocator._frames_in_flight = frames_in_flight;
+
+   allocator._buffer = std::make_unique<Buffer>(
+       device,
+       allocator._frame_size * frames_in_flight,
+       usage,
+       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+   allocator._buffer->map();
+
+   meddl::log::debug("Created frame allocator: {} bytes x {} frames, alignment {}",
+                     allocator._frame_size,
+                     frames_in_flight,
+                     allocator._alignment);
+   return allocator;
+}
+
+void FrameAllocator::begin_frame(uint32_t frame_index)
+{
+   _frame_begin = _frame_size * (frame_index % _frames_in_flight);
+   _cursor = 0;
+}
+
+std::expected<FrameAllocator::Allocation, error::Error> FrameAllocator::allocate(VkDeviceSize size)
+{
+   if (!_buffer) {
+      return std::unexpected(error::Error("FrameAllocator is not created"));
+   }
+   const VkDeviceSize offset = align_up(_cursor, _alignment);
+   if (offset + size > _frame_size) {
+      return std::unexpected(error::Error(std::format(
+          "FrameAllocator out of memory: {} + {} > {} bytes", offset, size, _frame_size)));
+   }
+   _cursor = offset + size;
+
+   Allocation allocation;
+   allocation.offset = _frame_begin + offset;
+   allocation.size = size;
+   allocation.data = static_cast<char*>(_buffer->mapped_data()) + allocation.offset;
+   return allocation;
+}
+
+}  // namespace meddl::render::vk
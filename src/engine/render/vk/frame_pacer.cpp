@@ -0,0 +1,139 @@
+#include "engine/render/vk/frame_pacer.h"
+
+#include <vulkan/vulkan_core.h>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <initializer_list>
+
+#include "core/log.h"
+
+namespace meddl::render::vk {
+
+namespace {
+// Long enough for any sane refresh rate, short enough not to hang on a hidden window
+constexpr uint64_t PRESENT_WAIT_TIMEOUT_NS = 100'000'000;
+
+using Clock = std::chrono::steady_clock;
+
+float elapsed_ms(Clock::time_point from, Clock::time_point to)
+{
+   return std::chrono::duration<float, std::milli>(to - from).count();
+}
+}  // namespace
+
+VkPresentModeKHR choose_present_mode(PresentPolicy policy,
+                                     std::span<const VkPresentModeKHR> supported)
+{
+   const auto pick = [&](std::initializer_list<VkPresentModeKHR> preferred) {
+      for (auto mode : preferred) {
+         if (std::ranges::find(supported, mode) != supported.end()) {
+            return mode;
+         }
+      }
+      return VK_PRESENT_MODE_FIFO_KHR;
+   };
+
+   switch (policy) {
+      case PresentPolicy::Vsync:
+         return VK_PRESENT_MODE_FIFO_KHR;
+      case PresentPolicy::AdaptiveVsync:
+         return pick({VK_PRESENT_MODE_FIFO_RELAXED_KHR});
+      case PresentPolicy::LowLatency:
+         return pick({VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR});
+      case PresentPolicy::Uncapped:
+         return pick({VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR});
+   }
+   return VK_PRESENT_MODE_FIFO_KHR;
+}
+
+FramePacer FramePacer::create(Device* device, const Config& config)
+{
+   FramePacer pacer;
+   pacer._device = device;
+   pacer._config = config;
+   pacer._config.frames_in_flight = std::max(config.frames_in_flight, 1u);
+   pacer._config.max_queued_presents = std::max(config.max_queued_presents, 1u);
+
+   if (config.present_wait && device->present_wait_enabled()) {
+      pacer._wait_for_present = std::bit_cast<PFN_vkWaitForPresentKHR>(
+          vkGetDeviceProcAddr(device->vk(), "vkWaitForPresentKHR"));
+   }
+   meddl::log::debug("Frame pacer: {} frames in flight, present wait: {}",
+                     pacer._config.frames_in_flight,
+                     pacer.waits_for_present());
+   return pacer;
+}
+
+void FramePacer::wait(VkSwapchainKHR swapchain)
+{
+   _last_wait_ms = 0.0f;
+   if (!_wait_for_present || swapchain != _swapchain) {
+      return;
+   }
+   // Presenting the next frame makes max_queued_presents, so everything before that is on screen
+   const uint64_t queued = _config.max_queued_presents - 1;
+   if (_present_id < _first_present_id + queued) {
+      return;
+   }
+   const auto start = Clock::now();
+   const auto result =
+       _wait_for_present(_device->vk(), swapchain, _present_id - queued, PRESENT_WAIT_TIMEOUT_NS);
+   _last_wait_ms = elapsed_ms(start, Clock::now());
+   // Out of date/suboptimal are handled by acquire and present, a timeout just stops pacing
+   if (result != VK_SUCCESS && result != VK_TIMEOUT && result != VK_SUBOPTIMAL_KHR &&
+       result != VK_ERROR_OUT_OF_DATE_KHR) {
+      meddl::log::warn("vkWaitForPresentKHR failed: {}", static_cast<int32_t>(result));
+   }
+}
+
+void FramePacer::on_present(VkPresentInfoKHR& info, VkSwapchainKHR swapchain)
+{
+   const auto now = Clock::now();
+   if (_frame_count > 0) {
+      _frame_times[(_frame_count - 1) % SAMPLE_COUNT] = elapsed_ms(_last_present, now);
+   }
+   _last_present = now;
+   _frame_count++;
+
+   if (!_wait_for_present) {
+      return;
+   }
+   _present_id++;
+   if (swapchain != _swapchain) {
+      _swapchain = swapchain;
+      _first_present_id = _present_id;
+   }
+   _present_id_info = {};
+   _present_id_info.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+   _present_id_info.pNext = info.pNext;
+   _present_id_info.swapchainCount = 1;
+   _present_id_info.pPresentIds = &_present_id;
+   info.pNext = &_present_id_info;
+}
+
+FramePacer::Stats FramePacer::stats() const
+{
+   Stats stats{};
+   stats.last_wait_ms = _last_wait_ms;
+   stats.samples = static_cast<uint32_t>(
+       std::min<uint64_t>(_frame_count > 0 ? _frame_count - 1 : 0, SAMPLE_COUNT));
+   if (stats.samples == 0) {
+      return stats;
+   }
+   const auto samples = std::span(_frame_times).first(stats.samples);
+   float sum = 0.0f;
+   for (auto time : samples) {
+      sum += time;
+   }
+   stats.mean_ms = sum / static_cast<float>(stats.samples);
+   float squares = 0.0f;
+   for (auto time : samples) {
+      squares += (time - stats.mean_ms) * (time - stats.mean_ms);
+   }
+   stats.stddev_ms = std::sqrt(squares / static_cast<float>(stats.samples));
+   return stats;
+}
+
+}  // namespace meddl::render::vk
@@ -0,0 +1,265 @@
+#include "engine/render/vk/gpu_profiler.h"
+
+#include <vulkan/vulkan_core.h>
+
+#include <algorithm>
+#include <format>
+#include <utility>
+
+#include "core/log.h"
+
+namespace meddl::render::vk {
+
+std::expected<GpuProfiler, error::Error> GpuProfiler::create(Device* device, const Config& config)
+{
+   auto* physical = device->physical_device();
+   const auto family = device->queue(QueueFamilyType::Graphics).family_index();
+   const auto valid_bits = physical->get_queue_families().at(family).timestampValidBits;
+   const auto period = physical->get_properties().limits.timestampPeriod;
+   if (valid_bits == 0 || period <= 0.0f) {
+      return std::unexpected(
+          error::Error(std::format("Queue family {} has no timestamp support", family)));
+   }
+
+   GpuProfiler profiler;
+   profiler._device = device;
+   profiler._config = config;
+   profiler._config.frames_in_flight = std::max(config.frames_in_flight, 1u);
+   profiler._config.max_regions = std::max(config.max_regions, 1u);
+   profiler._config.history = std::max(config.history, 1u);
+   profiler._period_ns = period;
+   profiler._valid_mask = valid_bits >= 64 ? ~0ull : (1ull << valid_bits) - 1;
+   profiler._frames.resize(profiler._config.frames_in_flight);
+   profiler._results.reserve(profiler.queries_per_frame());
+
+   VkQueryPoolCreateInfo info{};
+   info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+   info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+   info.queryCount = profiler.queries_per_frame() * profiler._config.frames_in_flight;
+   auto result =
+       vkCreateQueryPool(device->vk(), &info, device->get_allocators(), &profiler._pool);
+   if (result != VK_SUCCESS) {
+      return std::unexpected(
+          error::Error(std::format("vkCreateQueryPool failed: {}", static_cast<int32_t>(result))));
+   }
+   meddl::log::debug("GPU profiler: {} queries, {} ns per tick, {} valid bits",
+                     info.queryCount,
+                     period,
+                     valid_bits);
+   return profiler;
+}
+
+GpuProfiler::~GpuProfiler()
+{
+   destroy();
+}
+
+GpuProfiler::GpuProfiler(GpuProfiler&& other) noexcept
+{
+   *this = std::move(other);
+}
+
+GpuProfiler& GpuProfiler::operator=(GpuProfiler&& other) noexcept
+{
+   if (this != &other) {
+      destroy();
+      _device = std::exchange(other._device, nullptr);
+      _pool = std::exchange(other._pool, VK_NULL_HANDLE);
+      _config = other._config;
+      _period_ns = other._period_ns;
+      _valid_mask = other._valid_mask;
+      _frame = other._frame;
+      _frames = std::move(other._frames);
+      _open = std::move(other._open);
+      _results = std::move(other._results);
+      _ids = std::move(other._ids);
+      _history = std::move(other._history);
+      _last_frame = std::move(other._last_frame);
+      _frames_collected = other._frames_collected;
+   }
+   return *this;
+}
+
+void GpuProfiler::destroy()
+{
+   if (_device && _pool) {
+      vkDestroyQueryPool(_device->vk(), _pool, _device->get_allocators());
+   }
+   _pool = VK_NULL_HANDLE;
+}
+
+void GpuProfiler::begin_frame(CommandBuffer* cmd, uint32_t frame)
+{
+   if (!_pool || frame >= _frames.size()) {
+      return;
+   }
+   // Unbalanced regions leave queries unwritten, the frame would never become available
+   if (!_open.empty()) {
+      meddl::log::warn("GPU profiler: {} regions not ended, frame dropped", _open.size());
+      _frames.at(_frame).recorded = false;
+      _open.clear();
+   }
+   collect(frame);
+
+   _frame = frame;
+   auto& queries = _frames.at(frame);
+   queries.regions.clear();
+   queries.used = 0;
+   queries.recorded = true;
+   queries.cpu_start_ns = trace::now_ns();
+   vkCmdResetQueryPool(cmd->vk(), _pool, frame * queries_per_frame(), queries_per_frame());
+}
+
+void GpuProfiler::begin_region(CommandBuffer* cmd, const std::string& name)
+{
+   if (!_pool) {
+      return;
+   }
+   auto& queries = _frames.at(_frame);
+   if (queries.used + 2 > queries_per_frame()) {
+      _open.push_back(NOT_TIMED);
+      return;
+   }
+   const auto depth = static_cast<uint32_t>(_open.size());
+   _open.push_back(static_cast<uint32_t>(queries.regions.size()));
+   queries.regions.push_back(
+       {.id = region_id(name, depth), .depth = depth, .begin_query = queries.used});
+   vkCmdWriteTimestamp(cmd->vk(),
+                       VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                       _pool,
+                       _frame * queries_per_frame() + queries.used++);
+}
+
+void GpuProfiler::end_region(CommandBuffer* cmd)
+{
+   if (!_pool || _open.empty()) {
+      return;
+   }
+   const auto region = _open.back();
+   _open.pop_back();
+   if (region == NOT_TIMED) {
+      return;
+   }
+   auto& queries = _frames.at(_frame);
+   queries.regions.at(region).end_query = queries.used;
+   vkCmdWriteTimestamp(cmd->vk(),
+                       VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                       _pool,
+                       _frame * queries_per_frame() + queries.used++);
+}
+
+void GpuProfiler::collect(uint32_t frame)
+{
+   auto& queries = _frames.at(frame);
+   if (!queries.recorded || queries.used == 0) {
+      return;
+   }
+   queries.recorded = false;
+
+   _results.resize(queries.used);
+   // No WAIT flag, the fence of this frame was waited on, so NOT_READY means it never ran
+   auto result = vkGetQueryPoolResults(_device->vk(),
+                                       _pool,
+                                       frame * queries_per_frame(),
+                                       queries.used,
+                                       _results.size() * sizeof(uint64_t),
+                                       _results.data(),
+                                       sizeof(uint64_t),
+                                       VK_QUERY_RESULT_64_BIT);
+   if (result != VK_SUCCESS) {
+      return;
+   }
+
+   const auto ticks_between = [this](uint32_t from, uint32_t to) {
+      return static_cast<double>((_results[to] - _results[from]) & _valid_mask);
+   };
+   _last_frame.clear();
+   for (const auto& region : queries.regions) {
+      if (region.end_query == NOT_TIMED) {
+         continue;
+      }
+      const double duration_ns = ticks_between(region.begin_query, region.end_query) * _period_ns;
+      const auto start_ns =
+          queries.cpu_start_ns +
+          static_cast<uint64_t>(ticks_between(0, region.begin_query) * _period_ns);
+      auto& history = _history.at(region.id);
+      history.samples[history.next] = static_cast<float>(duration_ns / 1e6);
+      history.next = (history.next + 1) % _config.history;
+      history.count = std::min(history.count + 1, _config.history);
+      _last_frame.push_back({.id = region.id,
+                             .depth = region.depth,
+                             .start_ns = start_ns,
+                             .end_ns = start_ns + static_cast<uint64_t>(duration_ns)});
+   }
+   _frames_collected++;
+}
+
+uint32_t GpuProfiler::region_id(const std::string& name, uint32_t depth)
+{
+   auto it = _ids.find(name);
+   if (it == _ids.end()) {
+      it = _ids.emplace(name, static_cast<uint32_t>(_history.size())).first;
+      _history.push_back({.name = name, .samples = std::vector<float>(_config.history)});
+   }
+   _history[it->second].depth = depth;
+   return it->second;
+}
+
+std::vector<GpuProfiler::RegionStats> GpuProfiler::stats() const
+{
+   std::vector<RegionStats> stats;
+   stats.reserve(_history.size());
+   std::vector<float> sorted;
+   for (const auto& history : _history) {
+      RegionStats& region = stats.emplace_back();
+      region.name = history.name;
+      region.depth = history.depth;
+      region.samples = history.count;
+      if (history.count == 0) {
+         continue;
+      }
+      region.last_ms = history.samples[(history.next + _config.history - 1) % _config.history];
+
+      sorted.assign(history.samples.begin(), history.samples.begin() + history.count);
+      std::ranges::sort(sorted);
+      float sum = 0.0f;
+      for (auto sample : sorted) {
+         sum += sample;
+      }
+      const auto percentile = [&](float p) {
+         const auto index = static_cast<size_t>(p * static_cast<float>(sorted.size() - 1));
+         return sorted[index];
+      };
+      region.mean_ms = sum / static_cast<float>(sorted.size());
+      region.p50_ms = percentile(0.50f);
+      region.p95_ms = percentile(0.95f);
+      region.p99_ms = percentile(0.99f);
+      region.max_ms = sorted.back();
+   }
+   return stats;
+}
+
+void GpuProfiler::append_trace(trace::Snapshot& snapshot, uint32_t first_track) const
+{
+   uint32_t depth = 0;
+   for (const auto& event : _last_frame) {
+      snapshot.events.push_back({.name = _history.at(event.id).name,
+                                 .category = "gpu",
+                                 .start_ns = event.start_ns,
+                                 .end_ns = event.end_ns,
+                                 .track = first_track + event.depth});
+      depth = std::max(depth, event.depth + 1);
+   }
+   for (uint32_t i = 0; i < depth; i++) {
+      snapshot.tracks.push_back({.id = first_track + i, .name = std::format("GPU {}", i)});
+   }
+}
+
+std::string GpuProfiler::trace_json() const
+{
+   trace::Snapshot snapshot;
+   append_trace(snapshot, 0);
+   return trace::to_chrome_json(snapshot);
+}
+
+}  // namespace meddl::render::vk
@@ -1,6 +1,7 @@
 #include "engine/render/vk/image.h"
 
 #include <cmath>
+#include <optional>
 #include <stdexcept>
 
 #include "engine/render/vk/buffer.h"
@@ -20,36 +21,29 @@ Image Image::create(Device* device,
                     uint32_t width,
                     uint32_t height)
 {
-   Image result(device, config);
-   result._extent = {.width = width, .height = height, .depth = 1};
-   auto image_info = config.get_image_create_info(width, height);
-
-   if (vkCreateImage(device->vk(), &image_info, device->get_allocators(), &result._image) !=
-       VK_SUCCESS) {
-      meddl::log::error("Failed to create image, GG");
-   }
+   Image result = create_unbound(device, config, width, height);
 
    // Get memory requirements
-   VkMemoryRequirements mem_requirements;
-   vkGetImageMemoryRequirements(device->vk(), result._image, &mem_requirements);
-   uint32_t type_index{0};
-
-   auto mem_properties = device->physical_device()->get_memory_properties();
-
-   for (uint32_t i = 0; i < mem_properties.memoryTypeCount; i++) {
-      if ((mem_requirements.memoryTypeBits & (1 << i)) &&
-          (mem_properties.memoryTypes[i].propertyFlags & config.memory_flags) ==
-              config.memory_flags) {
-         type_index = i;
-         break;
-      }
+   auto mem_requirements = result.memory_requirements();
+   auto* physical_device = device->physical_device();
+
+   // Transient attachments can live in tile memory only, where the device has it
+   std::optional<uint32_t> type_index;
+   if (config.transient) {
+      type_index = physical_device->find_memory_type(
+          mem_requirements.memoryTypeBits,
+          config.memory_flags | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT);
+   }
+   if (!type_index) {
+      type_index =
+          physical_device->find_memory_type(mem_requirements.memoryTypeBits, config.memory_flags);
    }
 
    // Allocate memory
    VkMemoryAllocateInfo alloc_info{};
    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
    alloc_info.allocationSize = mem_requirements.size;
-   alloc_info.memoryTypeIndex = type_index;
+   alloc_info.memoryTypeIndex = type_index.value_or(0);
 
    if (vkAllocateMemory(device->vk(), &alloc_info, device->get_allocators(), &result._memory) !=
        VK_SUCCESS) {
@@ -66,6 +60,40 @@ Image Image::create(Device* device,
    return result;
 }
 
+Image Image::create_unbound(Device* device,
+                            const GraphicsConfiguration::AttachmentConfig& config,
+                            uint32_t width,
+                            uint32_t height)
+{
+   Image result(device, config);
+   result._extent = {.width = width, .height = height, .depth = 1};
+   auto image_info = config.get_image_create_info(width, height);
+
+   if (vkCreateImage(device->vk(), &image_info, device->get_allocators(), &result._image) !=
+       VK_SUCCESS) {
+      meddl::log::error("Failed to create image, GG");
+   }
+   // Owns the image, the memory is bound later and belongs to the caller
+   result._owned_resources = Owned{VK_NULL_HANDLE};
+   return result;
+}
+
+VkMemoryRequirements Image::memory_requirements() const
+{
+   VkMemoryRequirements requirements{};
+   vkGetImageMemoryRequirements(_device->vk(), _image, &requirements);
+   return requirements;
+}
+
+void Image::bind_memory(VkDeviceMemory memory, VkDeviceSize offset)
+{
+   if (vkBindImageMemory(_device->vk(), _image, memory, offset) != VK_SUCCESS) {
+      meddl::log::error("Failed to bind image memory, GG");
+   }
+   _memory = memory;
+   populate_image_view();
+}
+
 Image Image::create_deferred(VkImage image,
                              Device* device,
                              const GraphicsConfiguration::AttachmentConfig& config)
@@ -122,24 +150,14 @@ Image Image::create_texture(Device* device,
    // Get memory requirements
    VkMemoryRequirements mem_requirements;
    vkGetImageMemoryRequirements(device->vk(), result._image, &mem_requirements);
-   uint32_t type_index{0};
-
-   auto mem_properties = device->physical_device()->get_memory_properties();
-
-   for (uint32_t i = 0; i < mem_properties.memoryTypeCount; i++) {
-      if ((mem_requirements.memoryTypeBits & (1 << i)) &&
-          (mem_properties.memoryTypes[i].propertyFlags & config.memory_flags) ==
-              config.memory_flags) {
-         type_index = i;
-         break;
-      }
-   }
+   const auto type_index = device->physical_device()->find_memory_type(
+       mem_requirements.memoryTypeBits, config.memory_flags);
 
    // Allocate memory
    VkMemoryAllocateInfo alloc_info{};
    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
    alloc_info.allocationSize = mem_requirements.size;
-   alloc_info.memoryTypeIndex = type_index;
+   alloc_info.memoryTypeIndex = type_index.value_or(0);
 
    if (vkAllocateMemory(device->vk(), &alloc_info, device->get_allocators(), &result._memory) !=
        VK_SUCCESS) {
@@ -198,6 +216,8 @@ Image::Image(Image&& other) noexcept
       _image_view(other._image_view),
       _current_layout(other._current_layout),
       _memory(other._memory),
+      _extent(other._extent),
+      _type(other._type),
       _owned_resources(std::move(other._owned_resources))
 {
    other._memory = VK_NULL_HANDLE;
@@ -217,6 +237,8 @@ Image& Image::operator=(Image&& other) noexcept
       _memory = other._memory;
       _config = other._config;
       _current_layout = other._current_layout;
+      _extent = other._extent;
+      _type = other._type;
       _owned_resources = std::move(other._owned_resources);
 
       other._memory = VK_NULL_HANDLE;
@@ -462,7 +484,9 @@ void Image::populate_image_view()
       meddl::log::error("Can not populate an image view without a valid image");
    }
    auto info = _config.get_view_create_info(_image);
-   meddl::log::info("Creating image view with format: {}", static_cast<int32_t>(info.format));
+   MEDDL_LOG_DEBUG(MEDDL_LOG_SITE(),
+                   "Creating image view with format: {}",
+                   static_cast<int32_t>(info.format));
    if (vkCreateImageView(_device->vk(), &info, _device->get_allocators(), &_image_view) !=
        VK_SUCCESS) {
       meddl::log::error("Create image view failed, GG");
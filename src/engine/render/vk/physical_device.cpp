@@ -17,6 +17,35 @@ PhysicalDevice::PhysicalDevice(Instance* instance, VkPhysicalDevice device)
 
    vkGetPhysicalDeviceProperties(_device, &_properties);
 
+   if (_properties.apiVersion >= VK_API_VERSION_1_2) {
+      _vulkan12_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+      VkPhysicalDeviceFeatures2 features2{};
+      features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+      features2.pNext = &_vulkan12_features;
+      if (_properties.apiVersion >= VK_API_VERSION_1_3) {
+         _vulkan13_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+         _vulkan12_features.pNext = &_vulkan13_features;
+      }
+      vkGetPhysicalDeviceFeatures2(_device, &features2);
+      _vulkan12_features.pNext = nullptr;
+      _vulkan13_features.pNext = nullptr;
+   }
+
+   if (_properties.apiVersion >= VK_API_VERSION_1_1 &&
+       has_extensions_support({VK_KHR_PRESENT_ID_EXTENSION_NAME,
+                               VK_KHR_PRESENT_WAIT_EXTENSION_NAME})) {
+      VkPhysicalDevicePresentWaitFeaturesKHR present_wait{};
+      present_wait.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+      VkPhysicalDevicePresentIdFeaturesKHR present_id{};
+      present_id.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+      present_id.pNext = &present_wait;
+      VkPhysicalDeviceFeatures2 features2{};
+      features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+      features2.pNext = &present_id;
+      vkGetPhysicalDeviceFeatures2(_device, &features2);
+      _present_wait = present_id.presentId && present_wait.presentWait;
+   }
+
    uint32_t n_families = 0;
    vkGetPhysicalDeviceQueueFamilyProperties(_device, &n_families, nullptr);
 
@@ -33,7 +62,10 @@ PhysicalDevice::PhysicalDevice(PhysicalDevice&& other) noexcept
     : _device(other._device),
       _instance(other._instance),
       _features(other._features),
+      _vulkan12_features(other._vulkan12_features),
+      _vulkan13_features(other._vulkan13_features),
       _properties(other._properties),
+      _present_wait(other._present_wait),
       _queue_families(std::move(other._queue_families))
 {
    other._device = VK_NULL_HANDLE;
@@ -46,7 +78,10 @@ PhysicalDevice& PhysicalDevice::operator=(PhysicalDevice&& other) noexcept
       _device = other._device;
       _instance = other._instance;
       _features = other._features;
+      _vulkan12_features = other._vulkan12_features;
+      _vulkan13_features = other._vulkan13_features;
       _properties = other._properties;
+      _present_wait = other._present_wait;
       _queue_families = std::move(other._queue_families);
 
       other._device = VK_NULL_HANDLE;
@@ -66,6 +101,19 @@ const std::optional<uint32_t> PhysicalDevice::get_queue_family(VkQueueFlags flag
    return {};
 }
 
+const std::optional<uint32_t> PhysicalDevice::get_dedicated_queue_family(
+    VkQueueFlags flags,
+    VkQueueFlags excluded) const
+{
+   for (uint32_t idx = 0; idx < _queue_families.size(); idx++) {
+      const auto queue_flags = _queue_families[idx].queueFlags;
+      if ((queue_flags & flags) == flags && (queue_flags & excluded) == 0) {
+         return idx;
+      }
+   }
+   return {};
+}
+
 const std::optional<uint32_t> PhysicalDevice::get_present_family(Surface* surface) const
 {
    VkBool32 has_present{false};
@@ -88,6 +136,18 @@ VkPhysicalDeviceMemoryProperties PhysicalDevice::get_memory_properties() const
    return props;
 }
 
+std::optional<uint32_t> PhysicalDevice::find_memory_type(uint32_t type_bits,
+                                                         VkMemoryPropertyFlags flags) const
+{
+   const auto properties = get_memory_properties();
+   for (uint32_t i = 0; i < properties.memoryTypeCount; i++) {
+      if ((type_bits & (1u << i)) && (properties.memoryTypes[i].propertyFlags & flags) == flags) {
+         return i;
+      }
+   }
+   return std::nullopt;
+}
+
 const std::vector<VkSurfaceFormatKHR> PhysicalDevice::formats(Surface* surface) const
 {
    uint32_t format_count{};
@@ -2,6 +2,8 @@
 
 #include <array>
 #include <memory>
+#include <span>
+#include <vector>
 
 #include "core/error.h"
 #include "engine/render/vk/descriptor.h"
@@ -16,6 +18,91 @@ std::expected<GraphicsPipeline, error::Error> GraphicsPipeline::create(
     RenderPass* render_pass,
     VkVertexInputBindingDescription binding_description,
     const std::array<VkVertexInputAttributeDescription, 4>& attribute_description)
+{
+   if (binding_description.stride == 0) {
+      return create(vert_shader,
+                    frag_shader,
+                    device,
+                    layout,
+                    render_pass,
+                    std::span<const VkVertexInputBindingDescription>{},
+                    std::span<const VkVertexInputAttributeDescription>{});
+   }
+   return create(vert_shader,
+                 frag_shader,
+                 device,
+                 layout,
+                 render_pass,
+                 std::span(&binding_description, 1),
+                 std::span(attribute_description));
+}
+
+RenderingFormats rendering_formats(const GraphicsConfiguration::Shared& shared)
+{
+   RenderingFormats formats;
+   for (const auto& attachment : shared.attachments) {
+      if (!attachment.is_depth_stencil) {
+         formats.color_formats.push_back(attachment.format);
+         continue;
+      }
+      formats.depth_format = attachment.format;
+      if (attachment.get_aspect_mask() & VK_IMAGE_ASPECT_STENCIL_BIT) {
+         formats.stencil_format = attachment.format;
+      }
+   }
+   return formats;
+}
+
+std::expected<GraphicsPipeline, error::Error> GraphicsPipeline::create(
+    ShaderModule* vert_shader,
+    ShaderModule* frag_shader,
+    Device* device,
+    PipelineLayout* layout,
+    RenderPass* render_pass,
+    std::span<const VkVertexInputBindingDescription> binding_descriptions,
+    std::span<const VkVertexInputAttributeDescription> attribute_descriptions)
+{
+   return create_impl(vert_shader,
+                      frag_shader,
+                      device,
+                      layout,
+                      render_pass,
+                      nullptr,
+                      binding_descriptions,
+                      attribute_descriptions);
+}
+
+std::expected<GraphicsPipeline, error::Error> GraphicsPipeline::create(
+    ShaderModule* vert_shader,
+    ShaderModule* frag_shader,
+    Device* device,
+    PipelineLayout* layout,
+    const RenderingFormats& formats,
+    std::span<const VkVertexInputBindingDescription> binding_descriptions,
+    std::span<const VkVertexInputAttributeDescription> attribute_descriptions)
+{
+   if (!device->enabled_vulkan13_features().dynamicRendering) {
+      return std::unexpected(error::Error("Dynamic rendering is not enabled on the device"));
+   }
+   return create_impl(vert_shader,
+                      frag_shader,
+                      device,
+                      layout,
+                      nullptr,
+                      &formats,
+                      binding_descriptions,
+                      attribute_descriptions);
+}
+
+std::expected<GraphicsPipeline, error::Error> GraphicsPipeline::create_impl(
+    ShaderModule* vert_shader,
+    ShaderModule* frag_shader,
+    Device* device,
+    PipelineLayout* layout,
+    const RenderPass* render_pass,
+    const RenderingFormats* formats,
+    std::span<const VkVertexInputBindingDescription> binding_descriptions,
+    std::span<const VkVertexInputAttributeDescription> attribute_descriptions)
 {
    GraphicsPipeline pipeline;
    pipeline._device = device;
@@ -37,13 +124,14 @@ std::expected<GraphicsPipeline, error::Error> GraphicsPipeline::create(
 
    VkPipelineVertexInputStateCreateInfo vertex_input_info{};
    vertex_input_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-   bool has_vertex_info = binding_description.stride > 0;
+   bool has_vertex_info = !binding_descriptions.empty();
    if (has_vertex_info) {
-      vertex_input_info.vertexBindingDescriptionCount = 1;
-      vertex_input_info.pVertexBindingDescriptions = &binding_description;
+      vertex_input_info.vertexBindingDescriptionCount =
+          static_cast<uint32_t>(binding_descriptions.size());
+      vertex_input_info.pVertexBindingDescriptions = binding_descriptions.data();
       vertex_input_info.vertexAttributeDescriptionCount =
-          static_cast<uint32_t>(attribute_description.size());
-      vertex_input_info.pVertexAttributeDescriptions = attribute_description.data();
+          static_cast<uint32_t>(attribute_descriptions.size());
+      vertex_input_info.pVertexAttributeDescriptions = attribute_descriptions.data();
    }
    else {
       vertex_input_info.vertexBindingDescriptionCount = 0;
@@ -87,13 +175,17 @@ std::expected<GraphicsPipeline, error::Error> GraphicsPipeline::create(
    color_blend_attachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
                                            VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
    color_blend_attachment.blendEnable = VK_FALSE;
+   // One blend state per color attachment
+   const size_t color_count = formats ? formats->color_formats.size() : 1;
+   std::vector<VkPipelineColorBlendAttachmentState> color_blend_attachments(
+       color_count, color_blend_attachment);
 
    VkPipelineColorBlendStateCreateInfo color_blending{};
    color_blending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
    color_blending.logicOpEnable = VK_FALSE;
    color_blending.logicOp = VK_LOGIC_OP_COPY;
-   color_blending.attachmentCount = 1;
-   color_blending.pAttachments = &color_blend_attachment;
+   color_blending.attachmentCount = static_cast<uint32_t>(color_blend_attachments.size());
+   color_blending.pAttachments = color_blend_attachments.data();
    color_blending.blendConstants[0] = 0.0f;
    color_blending.blendConstants[1] = 0.0f;
    color_blending.blendConstants[2] = 0.0f;
@@ -119,8 +211,21 @@ std::expected<GraphicsPipeline, error::Error> GraphicsPipeline::create(
    pipeline_info.pDynamicState = &dynamic_state;
    pipeline_info.pDepthStencilState = &depth_stencil;
    pipeline_info.layout = *pipeline._layout;
-   pipeline_info.renderPass = render_pass->vk();
    pipeline_info.subpass = 0;
+
+   VkPipelineRenderingCreateInfo rendering_info{};
+   if (formats) {
+      rendering_info.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+      rendering_info.colorAttachmentCount = static_cast<uint32_t>(formats->color_formats.size());
+      rendering_info.pColorAttachmentFormats = formats->color_formats.data();
+      rendering_info.depthAttachmentFormat = formats->depth_format;
+      rendering_info.stencilAttachmentFormat = formats->stencil_format;
+      pipeline_info.pNext = &rendering_info;
+      pipeline_info.renderPass = VK_NULL_HANDLE;
+   }
+   else {
+      pipeline_info.renderPass = render_pass->vk();
+   }
    pipeline_info.basePipelineHandle = VK_NULL_HANDLE;
 
    auto result = vkCreateGraphicsPipelines(pipeline._device->vk(),
@@ -169,19 +274,136 @@ GraphicsPipeline::~GraphicsPipeline()
    }
 }
 
+std::expected<ComputePipeline, error::Error> ComputePipeline::create(ShaderModule* compute_shader,
+                                                                    Device* device,
+                                                                    PipelineLayout* layout)
+{
+   ComputePipeline pipeline;
+   pipeline._device = device;
+   pipeline._layout = layout;
+
+   VkPipelineShaderStageCreateInfo stage_info{};
+   stage_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+   stage_info.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+   stage_info.module = compute_shader->vk();
+   stage_info.pName = "main";
+
+   VkComputePipelineCreateInfo pipeline_info{};
+   pipeline_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+   pipeline_info.stage = stage_info;
+   pipeline_info.layout = *pipeline._layout;
+   pipeline_info.basePipelineHandle = VK_NULL_HANDLE;
+
+   auto result = vkCreateComputePipelines(pipeline._device->vk(),
+                                          VK_NULL_HANDLE,
+                                          1,
+                                          &pipeline_info,
+                                          pipeline._device->get_allocators(),
+                                          &pipeline._pipeline);
+   if (result != VK_SUCCESS) {
+      return std::unexpected(error::Error(
+          std::format("vkCreateComputePipelines failed: {}", static_cast<int32_t>(result))));
+   }
+
+   return pipeline;
+}
+
+ComputePipeline::ComputePipeline(ComputePipeline&& other) noexcept
+    : _layout(other._layout), _device(other._device), _pipeline(other._pipeline)
+{
+   other._device = nullptr;
+   other._layout = nullptr;
+   other._pipeline = VK_NULL_HANDLE;
+}
+
+ComputePipeline& ComputePipeline::operator=(ComputePipeline&& other) noexcept
+{
+   if (this != &other) {
+      if (_pipeline && _device) {
+         vkDestroyPipeline(*_device, _pipeline, _device->get_allocators());
+      }
+      _device = other._device;
+      _layout = other._layout;
+      _pipeline = other._pipeline;
+
+      other._device = nullptr;
+      other._layout = nullptr;
+      other._pipeline = VK_NULL_HANDLE;
+   }
+   return *this;
+}
+
+ComputePipeline::~ComputePipeline()
+{
+   if (_pipeline) {
+      vkDestroyPipeline(*_device, _pipeline, _device->get_allocators());
+   }
+}
+
 std::expected<PipelineLayout, error::Error> PipelineLayout::create(
     Device* device, const DescriptorSetLayout* dsl, VkPipelineLayoutCreateFlags flags)
 {
+   return create(device, dsl, std::span<const VkPushConstantRange>{}, flags);
+}
+
+std::expected<PipelineLayout, error::Error> PipelineLayout::create(
+    Device* device,
+    const DescriptorSetLayout* dsl,
+    std::span<const VkPushConstantRange> push_constant_ranges,
+    VkPipelineLayoutCreateFlags flags)
+{
+   return create(
+       device, std::span<const DescriptorSetLayout* const>(&dsl, 1), push_constant_ranges, flags);
+}
+
+std::expected<PipelineLayout, error::Error> PipelineLayout::create(
+    Device* device,
+    std::span<const DescriptorSetLayout* const> set_layouts,
+    std::span<const VkPushConstantRange> push_constant_ranges,
+    VkPipelineLayoutCreateFlags flags)
+{
+   const auto max_size = device->physical_device()->get_properties().limits.maxPushConstantsSize;
+   VkShaderStageFlags declared_stages = 0;
+   for (const auto& range : push_constant_ranges) {
+      if ((range.stageFlags & declared_stages) != 0) {
+         return std::unexpected(error::Error(
+             std::format("Push constant range [{}, {}) repeats a stage of an earlier range",
+                         range.offset,
+                         range.offset + range.size)));
+      }
+      declared_stages |= range.stageFlags;
+      if (range.offset % 4 != 0 || range.size == 0 || range.size % 4 != 0) {
+         return std::unexpected(error::Error(std::format(
+             "Push constant offset {} and size {} must be non zero multiples of 4",
+             range.offset,
+             range.size)));
+      }
+      if (range.offset + range.size > max_size) {
+         return std::unexpected(error::Error(
+             std::format("Push constant range [{}, {}) exceeds maxPushConstantsSize {}",
+                         range.offset,
+                         range.offset + range.size,
+                         max_size)));
+      }
+   }
+
    PipelineLayout layout;
    layout._device = device;
+   layout._push_constant_ranges.assign(push_constant_ranges.begin(), push_constant_ranges.end());
 
-   // TODO: Layouts, push constant ranges
    VkPipelineLayoutCreateInfo create_info{};
    create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
    create_info.flags = flags;
-   create_info.pSetLayouts = dsl->vk_ptr();
-   create_info.setLayoutCount = 1;
-   create_info.pushConstantRangeCount = 0;
+   std::vector<VkDescriptorSetLayout> vk_set_layouts{};
+   vk_set_layouts.reserve(set_layouts.size());
+   for (const auto* set_layout : set_layouts) {
+      vk_set_layouts.push_back(set_layout->vk());
+   }
+   create_info.pSetLayouts = vk_set_layouts.data();
+   create_info.setLayoutCount = static_cast<uint32_t>(vk_set_layouts.size());
+   create_info.pushConstantRangeCount =
+       static_cast<uint32_t>(layout._push_constant_ranges.size());
+   create_info.pPushConstantRanges = layout._push_constant_ranges.data();
 
    auto result = vkCreatePipelineLayout(
        device->vk(), &create_info, device->get_allocators(), &layout._layout);
@@ -192,7 +414,9 @@ std::expected<PipelineLayout, error::Error> PipelineLayout::create(
    return layout;
 }
 PipelineLayout::PipelineLayout(PipelineLayout&& other) noexcept
-    : _device(other._device), _layout(other._layout)
+    : _device(other._device),
+      _layout(other._layout),
+      _push_constant_ranges(std::move(other._push_constant_ranges))
 {
    other._device = nullptr;
    other._layout = VK_NULL_HANDLE;
@@ -206,6 +430,7 @@ PipelineLayout& PipelineLayout::operator=(PipelineLayout&& other) noexcept
       }
       _device = other._device;
       _layout = other._layout;
+      _push_constant_ranges = std::move(other._push_constant_ranges);
 
       other._device = nullptr;
       other._layout = VK_NULL_HANDLE;
@@ -0,0 +1,728 @@
+#include "engine/render/vk/render_graph.h"
+
+#include <vulkan/vulkan_core.h>
+
+#include <algorithm>
+#include <format>
+#include <iterator>
+#include <limits>
+#include <ranges>
+
+#include "core/log.h"
+
+namespace meddl::render::vk {
+
+ResourceUsageInfo resource_usage_info(ResourceUsage usage)
+{
+   switch (usage) {
+      case ResourceUsage::ColorAttachment:
+         return {.stages = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+                 .access = VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT |
+                           VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+                 .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                 .image_usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+                 .write = true};
+      case ResourceUsage::DepthAttachment:
+         return {.stages = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT |
+                           VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+                 .access = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+                           VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                 .layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+                 .image_usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+                 .write = true};
+      case ResourceUsage::DepthRead:
+         return {.stages = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT |
+                           VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT |
+                           VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+                 .access = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+                           VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+                 .layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+                 .image_usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT |
+                                VK_IMAGE_USAGE_SAMPLED_BIT,
+                 .write = false};
+      case ResourceUsage::SampledFragment:
+         return {.stages = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+                 .access = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+                 .layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                 .image_usage = VK_IMAGE_USAGE_SAMPLED_BIT,
+                 .write = false};
+      case ResourceUsage::SampledCompute:
+         return {.stages = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                 .access = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+                 .layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                 .image_usage = VK_IMAGE_USAGE_SAMPLED_BIT,
+                 .write = false};
+      case ResourceUsage::StorageRead:
+         return {.stages = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                 .access = VK_ACCESS_2_SHADER_STORAGE_READ_BIT,
+                 .layout = VK_IMAGE_LAYOUT_GENERAL,
+                 .image_usage = VK_IMAGE_USAGE_STORAGE_BIT,
+                 .write = false};
+      case ResourceUsage::StorageWrite:
+         return {.stages = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                 .access =
+                     VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                 .layout = VK_IMAGE_LAYOUT_GENERAL,
+                 .image_usage = VK_IMAGE_USAGE_STORAGE_BIT,
+                 .write = true};
+      case ResourceUsage::TransferSrc:
+         return {.stages = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+                 .access = VK_ACCESS_2_TRANSFER_READ_BIT,
+                 .layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                 .image_usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+                 .write = false};
+      case ResourceUsage::TransferDst:
+         return {.stages = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+                 .access = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                 .layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                 .image_usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+                 .write = true};
+      case ResourceUsage::Present:
+         return {.stages = VK_PIPELINE_STAGE_2_NONE,
+                 .access = VK_ACCESS_2_NONE,
+                 .layout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+                 .image_usage = 0,
+                 .write = false};
+      case ResourceUsage::IndirectRead:
+         return {.stages = VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT,
+                 .access = VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT,
+                 .layout = VK_IMAGE_LAYOUT_UNDEFINED,
+                 .image_usage = 0,
+                 .write = false};
+      case ResourceUsage::VertexRead:
+         return {.stages = VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT,
+                 .access = VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT,
+                 .layout = VK_IMAGE_LAYOUT_UNDEFINED,
+                 .image_usage = 0,
+                 .write = false};
+      case ResourceUsage::IndexRead:
+         return {.stages = VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT,
+                 .access = VK_ACCESS_2_INDEX_READ_BIT,
+                 .layout = VK_IMAGE_LAYOUT_UNDEFINED,
+                 .image_usage = 0,
+                 .write = false};
+      case ResourceUsage::UniformRead:
+         return {.stages = VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT |
+                           VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT |
+                           VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                 .access = VK_ACCESS_2_UNIFORM_READ_BIT,
+                 .layout = VK_IMAGE_LAYOUT_UNDEFINED,
+                 .image_usage = 0,
+                 .write = false};
+   }
+   return {};
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::read(RGImage image, ResourceUsage usage)
+{
+   _graph->add_access(_pass, image.index, true, usage, false);
+   return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::write(RGImage image, ResourceUsage usage)
+{
+   _graph->add_access(_pass, image.index, true, usage, true);
+   return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::read(RGBuffer buffer, ResourceUsage usage)
+{
+   _graph->add_access(_pass, buffer.index, false, usage, false);
+   return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::write(RGBuffer buffer, ResourceUsage usage)
+{
+   _graph->add_access(_pass, buffer.index, false, usage, true);
+   return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::side_effects()
+{
+   _graph->_passes.at(_pass).side_effects = true;
+   return *this;
+}
+
+RenderGraph::~RenderGraph()
+{
+   destroy_transients();
+}
+
+RenderGraph::RenderGraph(RenderGraph&& other) noexcept
+    : _device(other._device),
+      _compiled(other._compiled),
+      _passes(std::move(other._passes)),
+      _images(std::move(other._images)),
+      _buffers(std::move(other._buffers)),
+      _final_barriers(std::move(other._final_barriers)),
+      _transient_memory(std::move(other._transient_memory)),
+      _stats(other._stats)
+{
+   other._device = nullptr;
+   other._compiled = false;
+   other._images.clear();
+   other._transient_memory.clear();
+}
+
+RenderGraph& RenderGraph::operator=(RenderGraph&& other) noexcept
+{
+   if (this != &other) {
+      destroy_transients();
+      _device = other._device;
+      _compiled = other._compiled;
+      _passes = std::move(other._passes);
+      _images = std::move(other._images);
+      _buffers = std::move(other._buffers);
+      _final_barriers = std::move(other._final_barriers);
+      _transient_memory = std::move(other._transient_memory);
+      _stats = other._stats;
+
+      other._device = nullptr;
+      other._compiled = false;
+      other._images.clear();
+      other._transient_memory.clear();
+   }
+   return *this;
+}
+
+RGImage RenderGraph::import_image(std::string name,
+                                  VkImage image,
+                                  VkImageView view,
+                                  VkImageAspectFlags aspect,
+                                  VkImageLayout initial_layout,
+                                  std::optional<ResourceUsage> final_usage)
+{
+   _compiled = false;
+   _images.push_back({.name = std::move(name),
+                      .image = image,
+                      .view = view,
+                      .aspect = aspect,
+                      .initial_layout = initial_layout,
+                      .final_usage = final_usage});
+   return RGImage{static_cast<uint32_t>(_images.size() - 1)};
+}
+
+void RenderGraph::update_import(RGImage image, VkImage handle, VkImageView view)
+{
+   auto& resource = _images.at(image.index);
+   if (resource.transient) {
+      meddl::log::warn("Render graph: {} is transient, can't update it", resource.name);
+      return;
+   }
+   resource.image = handle;
+   resource.view = view;
+}
+
+RGBuffer RenderGraph::import_buffer(std::string name, VkBuffer buffer)
+{
+   _compiled = false;
+   _buffers.push_back({.name = std::move(name), .buffer = buffer});
+   return RGBuffer{static_cast<uint32_t>(_buffers.size() - 1)};
+}
+
+RGImage RenderGraph::create_image(std::string name, const TransientImageDesc& desc)
+{
+   _compiled = false;
+   _images.push_back({.name = std::move(name),
+                      .aspect = desc.aspect,
+                      .initial_layout = VK_IMAGE_LAYOUT_UNDEFINED,
+                      .transient = true,
+                      .desc = desc});
+   return RGImage{static_cast<uint32_t>(_images.size() - 1)};
+}
+
+RenderGraph::PassBuilder RenderGraph::add_pass(std::string name, ExecuteFn execute)
+{
+   _compiled = false;
+   _passes.push_back({.name = std::move(name), .execute = std::move(execute)});
+   return PassBuilder(this, static_cast<uint32_t>(_passes.size() - 1));
+}
+
+void RenderGraph::add_access(
+    uint32_t pass, uint32_t resource, bool is_image, ResourceUsage usage, bool write)
+{
+   const auto info = resource_usage_info(usage);
+   auto& accesses = _passes.at(pass).accesses;
+   if (is_image) {
+      _images.at(resource).usage |= info.image_usage;
+   }
+
+   // One access per resource and pass, the union of everything the pass declared
+   auto it = std::ranges::find_if(accesses, [&](const Access& a) {
+      return a.resource == resource && a.is_image == is_image;
+   });
+   if (it != accesses.end()) {
+      if (is_image && it->layout != info.layout) {
+         // Resolved in schedule_barriers, a pass can only see one layout
+         it->layout = VK_IMAGE_LAYOUT_MAX_ENUM;
+      }
+      it->stages |= info.stages;
+      it->access |= info.access;
+      it->write = it->write || write || info.write;
+      it->read = it->read || !write;
+      return;
+   }
+   accesses.push_back({.resource = resource,
+                       .is_image = is_image,
+                       .stages = info.stages,
+                       .access = info.access,
+                       .layout = is_image ? info.layout : VK_IMAGE_LAYOUT_UNDEFINED,
+                       .write = write || info.write,
+                       .read = !write});
+}
+
+bool RenderGraph::is_culled(const std::string& pass) const
+{
+   auto it = std::ranges::find_if(_passes, [&](const Pass& p) { return p.name == pass; });
+   return it != _passes.end() && !it->alive;
+}
+
+void RenderGraph::cull_passes()
+{
+   // Imported resources are visible outside the graph, so writing them keeps a pass alive.
+   // Walking backwards, a pass is needed if it writes something a later needed pass reads.
+   // An image written without being read is overwritten, earlier writers of it are not needed
+   std::vector<bool> image_needed(_images.size());
+   for (size_t i = 0; i < _images.size(); i++) {
+      image_needed[i] = !_images[i].transient;
+   }
+   // Buffers are always imported
+   for (auto& pass : std::views::reverse(_passes)) {
+      pass.alive = pass.side_effects || std::ranges::any_of(pass.accesses, [&](const Access& a) {
+                      return a.write && (!a.is_image || image_needed[a.resource]);
+                   });
+      if (!pass.alive) {
+         continue;
+      }
+      for (const auto& access : pass.accesses) {
+         if (access.is_image) {
+            image_needed[access.resource] = access.read;
+         }
+      }
+   }
+}
+
+std::expected<void, error::Error> RenderGraph::schedule_barriers()
+{
+   struct SyncState {
+      VkPipelineStageFlags2 write_stages{0};
+      VkAccessFlags2 write_access{0};
+      VkPipelineStageFlags2 read_stages{0};
+      // Stages/access that already see the last write
+      VkPipelineStageFlags2 visible_stages{0};
+      VkAccessFlags2 visible_access{0};
+      VkImageLayout layout{VK_IMAGE_LAYOUT_UNDEFINED};
+      bool first_use{true};
+   };
+   std::vector<SyncState> image_states(_images.size());
+   for (size_t i = 0; i < _images.size(); i++) {
+      image_states[i].layout = _images[i].initial_layout;
+   }
+   std::vector<SyncState> buffer_states(_buffers.size());
+
+   const auto sync = [](SyncState& state, const Access& access) -> std::optional<Barrier> {
+      Barrier barrier{.resource = access.resource,
+                      .is_image = access.is_image,
+                      .src_stages = state.write_stages | state.read_stages,
+                      .src_access = state.write_access,
+                      .dst_stages = access.stages,
+                      .dst_access = access.access,
+                      .old_layout = state.layout,
+                      .new_layout = access.is_image ? access.layout : VK_IMAGE_LAYOUT_UNDEFINED};
+      const bool layout_change = access.is_image && state.layout != access.layout;
+
+      if (state.first_use) {
+         // Covers whatever touched the memory before this submission, previous frames and
+         // aliased transients included
+         barrier.src_stages = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+         barrier.src_access = VK_ACCESS_2_MEMORY_WRITE_BIT;
+      }
+      else if (!access.write && !layout_change) {
+         // Read after read/write, only needed if this stage doesn't see the last write yet
+         if ((access.stages & ~state.visible_stages) == 0 &&
+             (access.access & ~state.visible_access) == 0) {
+            state.read_stages |= access.stages;
+            return std::nullopt;
+         }
+         barrier.src_stages = state.write_stages;
+         if (barrier.src_stages == 0) {
+            state.read_stages |= access.stages;
+            state.visible_stages |= access.stages;
+            state.visible_access |= access.access;
+            return std::nullopt;
+         }
+         state.read_stages |= access.stages;
+         state.visible_stages |= access.stages;
+         state.visible_access |= access.access;
+         return barrier;
+      }
+
+      // Write or layout transition, waits on every earlier read and write
+      state.first_use = false;
+      state.layout = barrier.new_layout;
+      if (access.write) {
+         state.write_stages = access.stages;
+         state.write_access = access.access & (VK_ACCESS_2_SHADER_WRITE_BIT |
+                                                VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT |
+                                                VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT |
+                                                VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+                                                VK_ACCESS_2_TRANSFER_WRITE_BIT);
+         state.read_stages = 0;
+         state.visible_stages = 0;
+         state.visible_access = 0;
+      }
+      else {
+         // The transition itself is the last write, it is visible to the destination scope
+         state.write_stages = access.stages;
+         state.write_access = 0;
+         state.read_stages = access.stages;
+         state.visible_stages = access.stages;
+         state.visible_access = access.access;
+      }
+      return barrier;
+   };
+
+   _stats.barriers = 0;
+   _stats.barrier_batches = 0;
+   for (auto& pass : _passes) {
+      pass.barriers.clear();
+      if (!pass.alive) {
+         continue;
+      }
+      for (const auto& access : pass.accesses) {
+         if (access.is_image && access.layout == VK_IMAGE_LAYOUT_MAX_ENUM) {
+            return std::unexpected(error::Error(
+                std::format("Render graph: pass {} uses {} in more than one layout",
+                            pass.name,
+                            _images.at(access.resource).name)));
+         }
+         auto& state = access.is_image ? image_states.at(access.resource)
+                                       : buffer_states.at(access.resource);
+         if (auto barrier = sync(state, access)) {
+            pass.barriers.push_back(barrier.value());
+         }
+      }
+      _stats.barriers += static_cast<uint32_t>(pass.barriers.size());
+      _stats.barrier_batches += pass.barriers.empty() ? 0 : 1;
+   }
+
+   _final_barriers.clear();
+   for (size_t i = 0; i < _images.size(); i++) {
+      const auto& image = _images[i];
+      const auto& state = image_states[i];
+      if (!image.final_usage || state.first_use) {
+         continue;
+      }
+      const auto info = resource_usage_info(image.final_usage.value());
+      if (info.layout == state.layout) {
+         continue;
+      }
+      _final_barriers.push_back({.resource = static_cast<uint32_t>(i),
+                                 .is_image = true,
+                                 .src_stages = state.write_stages | state.read_stages,
+                                 .src_access = state.write_access,
+                                 .dst_stages = info.stages,
+                                 .dst_access = info.access,
+                                 .old_layout = state.layout,
+                                 .new_layout = info.layout});
+   }
+   _stats.barriers += static_cast<uint32_t>(_final_barriers.size());
+   return {};
+}
+
+std::expected<void, error::Error> RenderGraph::create_transients()
+{
+   // Lifetime of every transient in alive pass indices
+   struct Transient {
+      uint32_t image;
+      uint32_t first;
+      uint32_t last;
+      VkMemoryRequirements requirements;
+   };
+   std::vector<Transient> transients;
+   for (uint32_t i = 0; i < _images.size(); i++) {
+      if (!_images[i].transient) {
+         continue;
+      }
+      Transient transient{.image = i,
+                          .first = std::numeric_limits<uint32_t>::max(),
+                          .last = 0,
+                          .requirements = {}};
+      for (uint32_t p = 0; p < _passes.size(); p++) {
+         if (!_passes[p].alive) {
+            continue;
+         }
+         for (const auto& access : _passes[p].accesses) {
+            if (access.is_image && access.resource == i) {
+               transient.first = std::min(transient.first, p);
+               transient.last = std::max(transient.last, p);
+            }
+         }
+      }
+      if (transient.first == std::numeric_limits<uint32_t>::max()) {
+         continue;  // Only used by culled passes
+      }
+
+      auto& image = _images[i];
+      VkImageCreateInfo image_info{};
+      image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+      image_info.imageType = VK_IMAGE_TYPE_2D;
+      image_info.format = image.desc.format;
+      image_info.extent = {image.desc.extent.width, image.desc.extent.height, 1};
+      image_info.mipLevels = 1;
+      image_info.arrayLayers = 1;
+      image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+      image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+      image_info.usage = image.usage;
+      image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+      image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+      auto result =
+          vkCreateImage(_device->vk(), &image_info, _device->get_allocators(), &image.image);
+      if (result != VK_SUCCESS) {
+         return std::unexpected(error::Error(
+             std::format(
+                 "vkCreateImage failed for {}: {}", image.name, static_cast<int32_t>(result))));
+      }
+      vkGetImageMemoryRequirements(_device->vk(), image.image, &transient.requirements);
+      transients.push_back(transient);
+   }
+
+   // Greedy aliasing, largest first: share a block with every transient whose lifetime it
+   // doesn't overlap, all bound at offset 0
+   struct Block {
+      VkDeviceSize size;
+      uint32_t type_bits;
+      std::vector<std::pair<uint32_t, uint32_t>> lifetimes;
+      std::vector<uint32_t> images;
+   };
+   std::vector<Block> blocks;
+   std::ranges::sort(transients, std::greater{}, [](const Transient& t) {
+      return t.requirements.size;
+   });
+   _stats.transient_bytes = 0;
+   for (const auto& transient : transients) {
+      _stats.transient_bytes += transient.requirements.size;
+      auto block = std::ranges::find_if(blocks, [&](const Block& b) {
+         return (b.type_bits & transient.requirements.memoryTypeBits) != 0 &&
+                b.size >= transient.requirements.size &&
+                std::ranges::none_of(b.lifetimes, [&](const auto& lifetime) {
+                   return transient.first <= lifetime.second && lifetime.first <= transient.last;
+                });
+      });
+      if (block == blocks.end()) {
+         blocks.push_back({.size = transient.requirements.size,
+                           .type_bits = transient.requirements.memoryTypeBits,
+                           .lifetimes = {},
+                           .images = {}});
+         block = std::prev(blocks.end());
+      }
+      block->type_bits &= transient.requirements.memoryTypeBits;
+      block->lifetimes.emplace_back(transient.first, transient.last);
+      block->images.push_back(transient.image);
+   }
+
+   _stats.allocated_bytes = 0;
+   for (const auto& block : blocks) {
+      const auto type_index = _device->physical_device()->find_memory_type(
+          block.type_bits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+      if (!type_index) {
+         return std::unexpected(error::Error("Render graph: no memory type for transients"));
+      }
+
+      VkMemoryAllocateInfo alloc_info{};
+      alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+      alloc_info.allocationSize = block.size;
+      alloc_info.memoryTypeIndex = type_index.value();
+      VkDeviceMemory memory{VK_NULL_HANDLE};
+      auto result =
+          vkAllocateMemory(_device->vk(), &alloc_info, _device->get_allocators(), &memory);
+      if (result != VK_SUCCESS) {
+         return std::unexpected(error::Error(
+             std::format("vkAllocateMemory failed: {}", static_cast<int32_t>(result))));
+      }
+      _transient_memory.push_back(memory);
+      _stats.allocated_bytes += block.size;
+
+      for (auto index : block.images) {
+         auto& image = _images[index];
+         vkBindImageMemory(_device->vk(), image.image, memory, 0);
+
+         VkImageViewCreateInfo view_info{};
+         view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+         view_info.image = image.image;
+         view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+         view_info.format = image.desc.format;
+         view_info.subresourceRange = {.aspectMask = image.aspect,
+                                       .baseMipLevel = 0,
+                                       .levelCount = 1,
+                                       .baseArrayLayer = 0,
+                                       .layerCount = 1};
+         result = vkCreateImageView(
+             _device->vk(), &view_info, _device->get_allocators(), &image.view);
+         if (result != VK_SUCCESS) {
+            return std::unexpected(error::Error(std::format(
+                "vkCreateImageView failed for {}: {}", image.name, static_cast<int32_t>(result))));
+         }
+      }
+   }
+   return {};
+}
+
+void RenderGraph::destroy_transients()
+{
+   if (!_device) {
+      return;
+   }
+   for (auto& image : _images) {
+      if (!image.transient) {
+         continue;
+      }
+      if (image.view) {
+         vkDestroyImageView(_device->vk(), image.view, _device->get_allocators());
+      }
+      if (image.image) {
+         vkDestroyImage(_device->vk(), image.image, _device->get_allocators());
+      }
+      image.view = VK_NULL_HANDLE;
+      image.image = VK_NULL_HANDLE;
+   }
+   for (auto memory : _transient_memory) {
+      vkFreeMemory(_device->vk(), memory, _device->get_allocators());
+   }
+   _transient_memory.clear();
+}
+
+std::expected<void, error::Error> RenderGraph::compile(Device* device)
+{
+   destroy_transients();
+   _device = device;
+   _compiled = false;
+
+   cull_passes();
+   _stats.passes = static_cast<uint32_t>(_passes.size());
+   _stats.culled_passes = static_cast<uint32_t>(
+       std::ranges::count_if(_passes, [](const Pass& p) { return !p.alive; }));
+
+   if (auto res = schedule_barriers(); !res) {
+      return res;
+   }
+   if (auto res = create_transients(); !res) {
+      destroy_transients();
+      return res;
+   }
+   _compiled = true;
+   meddl::log::debug(
+       "Render graph compiled: {} passes ({} culled), {} barriers in {} batches, transients {} -> "
+       "{} bytes",
+       _stats.passes,
+       _stats.culled_passes,
+       _stats.barriers,
+       _stats.barrier_batches,
+       _stats.transient_bytes,
+       _stats.allocated_bytes);
+   return {};
+}
+
+namespace {
+void record_barriers(VkCommandBuffer cmd,
+                     std::span<const VkImageMemoryBarrier2> image_barriers,
+                     std::span<const VkBufferMemoryBarrier2> buffer_barriers)
+{
+   if (image_barriers.empty() && buffer_barriers.empty()) {
+      return;
+   }
+   VkDependencyInfo dependency{};
+   dependency.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+   dependency.imageMemoryBarrierCount = static_cast<uint32_t>(image_barriers.size());
+   dependency.pImageMemoryBarriers = image_barriers.data();
+   dependency.bufferMemoryBarrierCount = static_cast<uint32_t>(buffer_barriers.size());
+   dependency.pBufferMemoryBarriers = buffer_barriers.data();
+   vkCmdPipelineBarrier2(cmd, &dependency);
+}
+}  // namespace
+
+std::expected<void, error::Error> RenderGraph::execute(CommandBuffer* cmd, GpuProfiler* profiler)
+{
+   if (!_compiled) {
+      return std::unexpected(error::Error("Render graph is not compiled"));
+   }
+   if (cmd->state() != CommandBuffer::State::Recording) {
+      return std::unexpected(error::Error("Commandbuffer state is not recording"));
+   }
+
+   std::vector<VkImageMemoryBarrier2> image_barriers;
+   std::vector<VkBufferMemoryBarrier2> buffer_barriers;
+   const auto translate = [&](std::span<const Barrier> barriers) {
+      image_barriers.clear();
+      buffer_barriers.clear();
+      for (const auto& b : barriers) {
+         if (b.is_image) {
+            const auto& image = _images[b.resource];
+            VkImageMemoryBarrier2 barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+            barrier.srcStageMask = b.src_stages;
+            barrier.srcAccessMask = b.src_access;
+            barrier.dstStageMask = b.dst_stages;
+            barrier.dstAccessMask = b.dst_access;
+            barrier.oldLayout = b.old_layout;
+            barrier.newLayout = b.new_layout;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.image = image.image;
+            barrier.subresourceRange = {.aspectMask = image.aspect,
+                                        .baseMipLevel = 0,
+                                        .levelCount = VK_REMAINING_MIP_LEVELS,
+                                        .baseArrayLayer = 0,
+                                        .layerCount = VK_REMAINING_ARRAY_LAYERS};
+            image_barriers.push_back(barrier);
+         }
+         else {
+            VkBufferMemoryBarrier2 barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
+            barrier.srcStageMask = b.src_stages;
+            barrier.srcAccessMask = b.src_access;
+            barrier.dstStageMask = b.dst_stages;
+            barrier.dstAccessMask = b.dst_access;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.buffer = _buffers[b.resource].buffer;
+            barrier.offset = 0;
+            barrier.size = VK_WHOLE_SIZE;
+            buffer_barriers.push_back(barrier);
+         }
+      }
+   };
+
+   for (auto& pass : _passes) {
+      if (!pass.alive) {
+         continue;
+      }
+      if (profiler) {
+         profiler->begin_region(cmd, pass.name);
+      }
+      translate(pass.barriers);
+      record_barriers(cmd->vk(), image_barriers, buffer_barriers);
+      if (pass.execute) {
+         pass.execute(*cmd, *this);
+      }
+      if (profiler) {
+         profiler->end_region(cmd);
+      }
+   }
+   translate(_final_barriers);
+   record_barriers(cmd->vk(), image_barriers, buffer_barriers);
+   return {};
+}
+
+void RenderGraph::reset()
+{
+   destroy_transients();
+   _passes.clear();
+   _images.clear();
+   _buffers.clear();
+   _final_barriers.clear();
+   _compiled = false;
+   _stats = {};
+}
+
+}  // namespace meddl::render::vk
@@ -18,6 +18,16 @@ std::expected<Swapchain, error::Error> Swapchain::create(Device* device,
                                                          const RenderPass* renderpass,
                                                          const GraphicsConfiguration& config,
                                                          const glfw::FrameBufferSize& fbs)
+{
+   return create_impl(device, surface, renderpass, config, fbs, nullptr);
+}
+
+std::expected<Swapchain, error::Error> Swapchain::create_impl(Device* device,
+                                                              Surface* surface,
+                                                              const RenderPass* renderpass,
+                                                              const GraphicsConfiguration& config,
+                                                              const glfw::FrameBufferSize& fbs,
+                                                              Swapchain* old_swapchain)
 {
    Swapchain swapchain;
    swapchain._device = device;
@@ -28,9 +38,10 @@ std::expected<Swapchain, error::Error> Swapchain::create(Device* device,
    auto caps = physical->capabilities(surface);
 
    uint32_t min_image_count = std::max(config.swapchain_config.min_image_count, caps.minImageCount);
-   meddl::log::debug("config minimum image {}, capabilitiy minimum: {}",
-                     config.swapchain_config.min_image_count,
-                     caps.minImageCount);
+   MEDDL_LOG_DEBUG(MEDDL_LOG_SITE(),
+                   "config minimum image {}, capabilitiy minimum: {}",
+                   config.swapchain_config.min_image_count,
+                   caps.minImageCount);
 
    // 0 means unlimited, so keep above if that's the case
    if (caps.maxImageCount > 0) {
@@ -81,7 +92,8 @@ std::expected<Swapchain, error::Error> Swapchain::create(Device* device,
    create_info.compositeAlpha = config.swapchain_config.composite_alpha;
    create_info.presentMode = config.swapchain_config.preferred_present_mode;
    create_info.clipped = true;  // We always want clipping
-   create_info.oldSwapchain = VK_NULL_HANDLE;
+   // Lets the driver hand over resources, and old images presented so far still get presented
+   create_info.oldSwapchain = old_swapchain ? old_swapchain->vk() : VK_NULL_HANDLE;
    create_info.pNext = nullptr;
 
    auto result = vkCreateSwapchainKHR(swapchain._device->vk(),
@@ -100,60 +112,122 @@ std::expected<Swapchain, error::Error> Swapchain::create(Device* device,
    swapchain_images.resize(image_count);
    vkGetSwapchainImagesKHR(
        swapchain._device->vk(), swapchain._swapchain, &image_count, swapchain_images.data());
-   meddl::log::info("Swapchain image count: {}", image_count);
+   meddl::log::info(MEDDL_LOG_SITE(), "Swapchain image count: {}", image_count);
 
-   for (const auto& attachment : config.shared.attachments) {
-      if (attachment.is_depth_stencil) {
-         swapchain._depth_image = Image::create(
-             device, attachment, swapchain._extent2d.width, swapchain._extent2d.height);
+   for (uint32_t i = 0; i < config.shared.attachments.size(); i++) {
+      const auto& attachment = config.shared.attachments[i];
+      if (!attachment.is_swapchain_image()) {
+         continue;
+      }
+      if (attachment.format != create_info.imageFormat) {
+         meddl::log::warn(MEDDL_LOG_SITE(),
+                          "attachment format != image format, what does this even mean?");
       }
-      else {
-         if (attachment.format != create_info.imageFormat) {
-            meddl::log::warn("attachment format != image format, what does this even mean?");
-         }
-         for (auto& image : swapchain_images) {
-            // swapchain_image_config.format = config.attachment_config.format;
-            swapchain._images.push_back(Image::create_deferred(image, device, attachment));
-         }
+      for (auto& image : swapchain_images) {
+         swapchain._images.push_back(Image::create_deferred(image, device, attachment));
+      }
+      swapchain._color_attachment = i;
+      break;
+   }
+
+   // Depth, G-buffers etc., transient ones lazily allocated and the rest aliased where possible
+   // Same extent, e.g. out of date after a present mode or surface change: keep them
+   const bool same_extent = old_swapchain &&
+                            old_swapchain->_extent2d.width == swapchain._extent2d.width &&
+                            old_swapchain->_extent2d.height == swapchain._extent2d.height &&
+                            old_swapchain->_attachments.size() == config.shared.attachments.size();
+   if (same_extent) {
+      swapchain._attachments = std::move(old_swapchain->_attachments);
+   }
+   else {
+      auto attachments = AttachmentSet::create(device,
+                                               config.shared.attachments,
+                                               swapchain._extent2d.width,
+                                               swapchain._extent2d.height);
+      if (!attachments) {
+         return std::unexpected(attachments.error());
       }
+      swapchain._attachments = std::move(attachments.value());
    }
 
-   // Create framebuffers
-   swapchain._framebuffers.resize(swapchain._images.size());
+   if (auto framebuffers = swapchain.create_framebuffers(renderpass); !framebuffers) {
+      return std::unexpected(framebuffers.error());
+   }
+   return swapchain;
+}
+
+std::expected<Swapchain, error::Error> Swapchain::create_offscreen(
+    Device* device,
+    const RenderPass* renderpass,
+    const GraphicsConfiguration& config,
+    VkExtent2D extent,
+    uint32_t color_attachment)
+{
+   if (color_attachment >= config.shared.attachments.size() ||
+       config.shared.attachments[color_attachment].is_depth_stencil) {
+      return std::unexpected(
+          error::Error(std::format("Offscreen color attachment {} is invalid", color_attachment)));
+   }
+   Swapchain swapchain;
+   swapchain._device = device;
+   swapchain._config = config;
+   swapchain._extent2d = extent;
+   swapchain._offscreen = true;
+   swapchain._color_attachment = color_attachment;
+
+   // Every attachment, the color one included, is an owned image
+   auto attachments =
+       AttachmentSet::create(device, config.shared.attachments, extent.width, extent.height);
+   if (!attachments) {
+      return std::unexpected(attachments.error());
+   }
+   swapchain._attachments = std::move(attachments.value());
+   if (!swapchain._attachments.image(color_attachment)) {
+      return std::unexpected(error::Error("Offscreen color attachment has no image"));
+   }
+
+   if (auto framebuffers = swapchain.create_framebuffers(renderpass); !framebuffers) {
+      return std::unexpected(framebuffers.error());
+   }
+   return swapchain;
+}
+
+std::expected<void, error::Error> Swapchain::create_framebuffers(const RenderPass* renderpass)
+{
+   // Dynamic rendering, nothing to rebuild on recreation
+   if (!renderpass) {
+      return {};
+   }
+
+   _framebuffers.resize(image_count());
 
    VkFramebufferCreateInfo framebuffer_info{};
    framebuffer_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
    framebuffer_info.renderPass = renderpass->vk();
    framebuffer_info.attachmentCount =
-       config.shared.get_attachment_descriptions().size();  // matches renderpass
-   framebuffer_info.width = swapchain._extent2d.width;
-   framebuffer_info.height = swapchain._extent2d.height;
-   framebuffer_info.layers = config.framebuffer_config.layers;
-
-   bool has_depth = swapchain._depth_image.has_value();
-   meddl::log::debug("Has depth? {}", has_depth);
-   for (size_t i = 0; i < swapchain._images.size(); i++) {
-      std::array<VkImageView, 2> attachments{};
-
-      // Color attachment is always at index 0
-      attachments[0] = swapchain._images.at(i).view();
-
-      // Add depth attachment if we have one
-      if (has_depth) {
-         attachments[1] = swapchain._depth_image->view();
+       _config.shared.get_attachment_descriptions().size();  // matches renderpass
+   framebuffer_info.width = _extent2d.width;
+   framebuffer_info.height = _extent2d.height;
+   framebuffer_info.layers = _config.framebuffer_config.layers;
+
+   std::vector<VkImageView> views(_config.shared.attachments.size());
+   for (uint32_t i = 0; i < image_count(); i++) {
+      for (size_t a = 0; a < views.size(); a++) {
+         const auto* image = _attachments.image(a);
+         views[a] = image ? image->view() : _images.at(i).view();
       }
 
-      framebuffer_info.pAttachments = attachments.data();
-      result = vkCreateFramebuffer(swapchain._device->vk(),
-                                   &framebuffer_info,
-                                   config.framebuffer_config.custom_allocator,
-                                   &swapchain._framebuffers.at(i));
+      framebuffer_info.pAttachments = views.data();
+      auto result = vkCreateFramebuffer(_device->vk(),
+                                        &framebuffer_info,
+                                        _config.framebuffer_config.custom_allocator,
+                                        &_framebuffers.at(i));
       if (result != VK_SUCCESS) {
          return std::unexpected(error::Error(
              std::format("vkCreateFramebuffer failed: {}", static_cast<int32_t>(result))));
       }
    }
-   return swapchain;
+   return {};
 }
 
 Swapchain::Swapchain(Swapchain&& other) noexcept
@@ -162,7 +236,9 @@ Swapchain::Swapchain(Swapchain&& other) noexcept
       _surface(other._surface),
       _config(other._config),
       _extent2d(other._extent2d),
-      _depth_image(std::move(other._depth_image)),
+      _offscreen(other._offscreen),
+      _color_attachment(other._color_attachment),
+      _attachments(std::move(other._attachments)),
       _images(std::move(other._images)),
       _framebuffers(std::move(other._framebuffers))
 {
@@ -176,13 +252,16 @@ Swapchain::Swapchain(Swapchain&& other) noexcept
 Swapchain& Swapchain::operator=(Swapchain&& other) noexcept
 {
    if (this != &other) {
+      deinit();
       _device = other._device;
       _surface = other._surface;
       _swapchain = other._swapchain;
       _images = std::move(other._images);
-      _depth_image = std::move(other._depth_image);
+      _attachments = std::move(other._attachments);
       _framebuffers = std::move(other._framebuffers);
       _extent2d = other._extent2d;
+      _offscreen = other._offscreen;
+      _color_attachment = other._color_attachment;
       _config = other._config;
 
       other._device = nullptr;
@@ -202,6 +281,9 @@ void Swapchain::deinit()
    for (auto framebuffer : _framebuffers) {
       vkDestroyFramebuffer(_device->vk(), framebuffer, _device->get_allocators());
    }
+   _swapchain = VK_NULL_HANDLE;
+   _framebuffers.clear();
+   _attachments = AttachmentSet{};
 }
 
 Swapchain::~Swapchain()
@@ -215,9 +297,7 @@ std::expected<Swapchain, error::Error> Swapchain::recreate(Device* device,
                                                            const glfw::FrameBufferSize& fbs,
                                                            Swapchain& old_swapchain)
 {
-   device->wait_idle();
-   old_swapchain.deinit();
-   return Swapchain::create(device, surface, renderpass, old_swapchain.config(), fbs);
+   return create_impl(device, surface, renderpass, old_swapchain.config(), fbs, &old_swapchain);
 }
 
 // std::vector<VkImageView>& Swapchain::get_image_views()
@@ -4,6 +4,7 @@
 
 #include <cstring>
 
+#include "core/metrics.h"
 #include "engine/render/vk/buffer.h"
 #include "engine/render/vk/command.h"
 
@@ -60,6 +61,11 @@ std::expected<Texture, error::Error> Texture::create(Device* device, const Image
    std::memcpy(data, image_data.pixels.data(), static_cast<size_t>(image_size));
    vkUnmapMemory(device->vk(), staging_buffer.memory());
 
+   static auto& textures = metrics::counter("upload.textures");
+   static auto& bytes = metrics::counter("upload.texture_bytes");
+   textures.add();
+   bytes.add(image_size);
+
    uint32_t mip_levels = 1;
    if (image_data.generate_mipmaps) {
       mip_levels = static_cast<uint32_t>(
@@ -126,6 +132,8 @@ std::expected<Texture, error::Error> Texture::create(Device* device, const Image
    if (!sampler) {
       return std::unexpected(error::Error("Sampler creation failed in texture creation"));
    }
+   texture._image = std::move(image);
+   texture._sampler = std::move(sampler.value());
    return texture;
 }
 
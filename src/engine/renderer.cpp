@@ -7,6 +7,7 @@
 #include <algorithm>
 #include <array>
 #include <cstring>
+#include <limits>
 #include <memory>
 #include <optional>
 #include <ranges>
@@ -50,29 +51,152 @@ Renderer RendererBuilder::make_glfw_vulkan()
        std::make_shared<glfw::Window>(_config.window_width, _config.window_height, _config.title);
 
    // Create and return the renderer
-   return {window};
+   return {window, _config};
 }
 
-constexpr size_t MAX_FRAMES_IN_FLIGHT = 2;
-Renderer::Renderer(std::shared_ptr<glfw::Window> window) : _window(std::move(window))
+constexpr VkDeviceSize FRAME_ALLOCATOR_SIZE = 1024 * 1024;
+
+namespace {
+// Instance stream at binding 1, locations 4-8, see vk::create_instance_attribute_descriptions
+constexpr auto instanced_vert_source = R"(
+#version 450
+layout(set = 0, binding = 0) uniform TransformUBO {
+   mat4 model;
+   mat4 view;
+   mat4 projection;
+} ubo;
+
+layout(location = 0) in vec3 in_position;
+layout(location = 1) in vec3 in_color;
+layout(location = 2) in vec3 in_normal;
+layout(location = 3) in vec2 in_uv;
+layout(location = 4) in mat4 in_model;
+layout(location = 8) in uint in_material_id;
+
+layout(location = 0) out vec3 frag_color;
+layout(location = 1) out vec3 frag_normal;
+layout(location = 2) out vec2 frag_uv;
+layout(location = 3) flat out uint frag_material_id;
+
+void main()
+{
+   gl_Position = ubo.projection * ubo.view * in_model * vec4(in_position, 1.0);
+   frag_color = in_color;
+   frag_normal = mat3(in_model) * in_normal;
+   frag_uv = in_uv;
+   frag_material_id = in_material_id;
+}
+)";
+
+// MEDDL_BINDLESS reads materials and textures from the BindlessTable at set 1
+constexpr auto instanced_frag_source = R"(
+#version 450
+#ifdef MEDDL_BINDLESS
+#extension GL_EXT_nonuniform_qualifier : require
+struct Material {
+   vec4 diffuse_color;
+   float shininess;
+   float metallic;
+   float roughness;
+   float ao;
+   uint albedo_texture;
+   uint normal_texture;
+   uint metallic_roughness_texture;
+   uint sampler_index;
+};
+layout(set = 1, binding = 0) uniform texture2D images[];
+layout(set = 1, binding = 1) uniform sampler samplers[];
+layout(std430, set = 1, binding = 2) readonly buffer Materials {
+   Material materials[];
+};
+#endif
+
+layout(location = 0) in vec3 frag_color;
+layout(location = 1) in vec3 frag_normal;
+layout(location = 2) in vec2 frag_uv;
+layout(location = 3) flat in uint frag_material_id;
+
+layout(location = 0) out vec4 out_color;
+
+void main()
+{
+   vec3 albedo = frag_color;
+#ifdef MEDDL_BINDLESS
+   Material material = materials[min(frag_material_id, uint(materials.length()) - 1)];
+   albedo *= material.diffuse_color.rgb;
+   if (material.albedo_texture != 0xFFFFFFFFu) {
+      albedo *= texture(sampler2D(images[nonuniformEXT(material.albedo_texture)],
+                                  samplers[nonuniformEXT(material.sampler_index)]),
+                        frag_uv).rgb;
+   }
+#endif
+   vec3 normal = length(frag_normal) > 0.0 ? normalize(frag_normal) : vec3(0.0, 1.0, 0.0);
+   float light = max(dot(normal, normalize(vec3(0.4, 1.0, 0.3))), 0.0) * 0.8 + 0.2;
+   out_color = vec4(albedo * light, 1.0);
+}
+)";
+
+// Color formats read_frame can copy out, 0 otherwise
+uint32_t readback_texel_size(VkFormat format)
+{
+   switch (format) {
+      case VK_FORMAT_R8G8B8A8_UNORM:
+      case VK_FORMAT_R8G8B8A8_SRGB:
+      case VK_FORMAT_B8G8R8A8_UNORM:
+      case VK_FORMAT_B8G8R8A8_SRGB:
+      case VK_FORMAT_A2B10G10R10_UNORM_PACK32:
+         return 4;
+      case VK_FORMAT_R16G16B16A16_SFLOAT:
+         return 8;
+      case VK_FORMAT_R32G32B32A32_SFLOAT:
+         return 16;
+      default:
+         return 0;
+   }
+}
+
+double elapsed_ms(uint64_t start_ns, uint64_t end_ns)
+{
+   return static_cast<double>(end_ns - start_ns) / 1e6;
+}
+}  // namespace
+Renderer::Renderer(std::shared_ptr<glfw::Window> window, const render_config& config)
+    : Renderer(std::move(window), config, VkExtent2D{})
+{
+}
+
+Renderer Renderer::headless(uint32_t width, uint32_t height, const render_config& config)
+{
+   return Renderer(nullptr, config, VkExtent2D{.width = width, .height = height});
+}
+
+Renderer::Renderer(std::shared_ptr<glfw::Window> window,
+                   const render_config& config,
+                   VkExtent2D extent)
+    : _window(std::move(window))
 {
-   meddl::log::get_logger()->set_level(spdlog::level::debug);
    auto debug_config = vk::DebugConfiguration();
    auto instance_config = vk::InstanceConfiguration();
+   if (!_window) {
+      // No surface to create, so no platform extensions either
+      instance_config.extensions.clear();
+   }
    auto instance = vk::Instance::create(instance_config, debug_config);
    if (!instance) {
       throw std::runtime_error(std::format("{}", instance.error().message()));
    }
    _instance = std::move(instance.value());
-   auto surface =
-       render::vk::Surface::create(platform::glfw_window_handle{_window.get()->glfw()}, &_instance);
+   if (_window) {
+      auto surface = render::vk::Surface::create(
+          platform::glfw_window_handle{_window.get()->glfw()}, &_instance);
 
-   if (!surface) {
-      throw std::runtime_error("surface error, fix this error later");
+      if (!surface) {
+         throw std::runtime_error("surface error, fix this error later");
+      }
+      _surface = std::move(surface.value());
    }
-   _surface = std::move(surface.value());
 
-   vk::DevicePicker picker(&_instance, &_surface);
+   vk::DevicePicker picker(&_instance, _window ? &_surface : nullptr);
    auto picked = picker.pick_best(vk::DevicePickerStrategy::HighPerformance);
 
    auto device =
@@ -81,22 +205,65 @@ Renderer::Renderer(std::shared_ptr<glfw::Window> window) : _window(std::move(win
       throw std::runtime_error(std::format("Device error: {}", device.error().full_message()));
    }
    _device = std::move(device.value());
+   // Headless renders into a single image, so frames can't overlap
+   _frame_pacer = vk::FramePacer::create(&_device,
+                                         {.frames_in_flight = _window ? config.frames_in_flight : 1,
+                                          .max_queued_presents = 1,
+                                          .present_wait = config.present_wait});
+   if (config.render_thread) {
+      _render_thread = std::make_unique<RenderThread>();
+   }
 
    auto graphics_conf = vk::presets::forward_rendering();
+   std::optional<uint32_t> offscreen_color{};
+   if (_window) {
+      const auto present_modes = _device.physical_device()->present_modes(&_surface);
+      graphics_conf.swapchain_config.preferred_present_mode =
+          vk::choose_present_mode(config.present_policy, present_modes);
+      // Rendered on one family and presented on another, share the images instead of
+      // transferring
+      const auto graphics_family = _device.queue(vk::QueueFamilyType::Graphics).family_index();
+      const auto present_family = _device.queue(vk::QueueFamilyType::Present).family_index();
+      if (graphics_family != present_family) {
+         graphics_conf.swapchain_config.queue_family_indices = {graphics_family, present_family};
+      }
+      meddl::log::debug(
+          "Present mode: {}",
+          static_cast<int32_t>(graphics_conf.swapchain_config.preferred_present_mode));
+   }
+   else {
+      offscreen_color = vk::presets::apply_offscreen(graphics_conf);
+   }
    auto validator = vk::ConfigValidator(_device.physical_device(), &_surface);
 
-   validator.validate_surface_format(graphics_conf);
+   if (_window) {
+      validator.validate_surface_format(graphics_conf);
+   }
    validator.validate_renderpass(graphics_conf);
 
-   auto renderpass = vk::RenderPass::create(&_device, graphics_conf);
-   if (!renderpass) {
-      throw std::runtime_error(
-          std::format("Renderpass error: {}", renderpass.error().full_message()));
+   // Layout transitions come from a RenderGraph, which needs synchronization2 as well
+   const auto& features13 = _device.enabled_vulkan13_features();
+   _dynamic_rendering = features13.dynamicRendering && features13.synchronization2;
+   if (!_dynamic_rendering) {
+      auto renderpass = vk::RenderPass::create(&_device, graphics_conf);
+      if (!renderpass) {
+         throw std::runtime_error(
+             std::format("Renderpass error: {}", renderpass.error().full_message()));
+      }
+      _renderpass = std::move(renderpass.value());
    }
-   _renderpass = std::move(renderpass.value());
-
-   auto swapchain = vk::Swapchain::create(
-       &_device, &_surface, &_renderpass, graphics_conf, _window->get_framebuffer_size());
+   meddl::log::debug("Dynamic rendering: {}", _dynamic_rendering);
+
+   auto swapchain = _window ? vk::Swapchain::create(&_device,
+                                                    &_surface,
+                                                    renderpass(),
+                                                    graphics_conf,
+                                                    _window->get_framebuffer_size())
+                            : vk::Swapchain::create_offscreen(&_device,
+                                                              renderpass(),
+                                                              graphics_conf,
+                                                              extent,
+                                                              offscreen_color.value_or(0));
 
    if (!swapchain) {
       throw std::runtime_error(
@@ -119,33 +286,121 @@ Renderer::Renderer(std::shared_ptr<glfw::Window> window) : _window(std::move(win
                                                                vertex_layout::uv_offset);
 
    _descriptor_set_layout = std::make_unique<vk::DescriptorSetLayout>(
-       &_device, graphics_conf.descriptor_layouts.ubo_sampler);
+       &_device, graphics_conf.descriptor_layouts.ubo_dynamic_sampler);
 
-   auto pipeline_layout = vk::PipelineLayout::create(&_device, _descriptor_set_layout.get());
+   if (vk::BindlessTable::supported(&_device)) {
+      auto bindless = vk::BindlessTable::create(&_device);
+      if (bindless) {
+         _bindless = std::make_unique<vk::BindlessTable>(std::move(bindless.value()));
+      }
+      else {
+         meddl::log::warn("Bindless disabled: {}", bindless.error().full_message());
+      }
+   }
+   // Set 1 is the bindless table, bound once per frame in record_scene
+   std::vector<const vk::DescriptorSetLayout*> set_layouts = {_descriptor_set_layout.get()};
+   if (_bindless) {
+      set_layouts.push_back(_bindless->layout());
+   }
+   auto pipeline_layout = vk::PipelineLayout::create(&_device, set_layouts);
    if (!pipeline_layout) {
       throw std::runtime_error(
           std::format("Pipeline layout error: {}", pipeline_layout.error().full_message()));
    }
    _pipeline_layout = std::move(pipeline_layout.value());
 
-   auto graphics_pipeline = vk::GraphicsPipeline::create(
-       _vert_mod.get(), _frag_mod.get(), &_device, &_pipeline_layout, &_renderpass, bdesc, vattr);
+   const auto formats = vk::rendering_formats(graphics_conf.shared);
+   auto graphics_pipeline =
+       _dynamic_rendering ? vk::GraphicsPipeline::create(_vert_mod.get(),
+                                                         _frag_mod.get(),
+                                                         &_device,
+                                                         &_pipeline_layout,
+                                                         formats,
+                                                         std::span(&bdesc, 1),
+                                                         std::span(vattr))
+                          : vk::GraphicsPipeline::create(_vert_mod.get(),
+                                                         _frag_mod.get(),
+                                                         &_device,
+                                                         &_pipeline_layout,
+                                                         &_renderpass,
+                                                         bdesc,
+                                                         vattr);
    if (!graphics_pipeline) {
       throw std::runtime_error(
           std::format("Graphics pipeline error: {}", graphics_pipeline.error().full_message()));
    }
    _graphics_pipeline = std::move(graphics_pipeline.value());
-   // TODO: 0 is not always the correct index, save somewhere to fetch for the commandpool
 
-   auto graphics_queue = _device.physical_device()->get_queue_family(VK_QUEUE_GRAPHICS_BIT);
-   auto pool = vk::CommandPool::create(
-       &_device, graphics_queue.value(), VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
+   auto instanced_vert = engine::loader::compile_glsl(
+       instanced_vert_source, shaderc_glsl_vertex_shader, "instanced.vert");
+   std::string frag_source = instanced_frag_source;
+   if (_bindless) {
+      const std::string version = "#version 450\n";
+      frag_source.insert(frag_source.find(version) + version.size(), "#define MEDDL_BINDLESS 1\n");
+   }
+   auto instanced_frag = engine::loader::compile_glsl(
+       frag_source, shaderc_glsl_fragment_shader, "instanced.frag");
+   if (!instanced_vert || !instanced_frag) {
+      throw std::runtime_error(std::format(
+          "Instanced shader error: {}",
+          (instanced_vert ? instanced_frag.error() : instanced_vert.error()).message()));
+   }
+   _instanced_vert_mod = std::make_unique<vk::ShaderModule>(&_device, instanced_vert->spirv_code);
+   _instanced_frag_mod = std::make_unique<vk::ShaderModule>(&_device, instanced_frag->spirv_code);
+
+   const std::array<VkVertexInputBindingDescription, 2> instanced_bindings = {
+       bdesc,
+       vk::create_vertex_binding_description(
+           instance_layout::stride, 1, VK_VERTEX_INPUT_RATE_INSTANCE)};
+   const auto iattr = vk::create_instance_attribute_descriptions(
+       instance_layout::model_offset, instance_layout::material_id_offset);
+   std::vector<VkVertexInputAttributeDescription> instanced_attributes(vattr.begin(),
+                                                                       vattr.end());
+   instanced_attributes.insert(instanced_attributes.end(), iattr.begin(), iattr.end());
+
+   auto instanced_pipeline = _dynamic_rendering
+                                 ? vk::GraphicsPipeline::create(_instanced_vert_mod.get(),
+                                                                _instanced_frag_mod.get(),
+                                                                &_device,
+                                                                &_pipeline_layout,
+                                                                formats,
+                                                                instanced_bindings,
+                                                                instanced_attributes)
+                                 : vk::GraphicsPipeline::create(_instanced_vert_mod.get(),
+                                                                _instanced_frag_mod.get(),
+                                                                &_device,
+                                                                &_pipeline_layout,
+                                                                &_renderpass,
+                                                                instanced_bindings,
+                                                                instanced_attributes);
+   if (!instanced_pipeline) {
+      throw std::runtime_error(std::format("Instanced pipeline error: {}",
+                                           instanced_pipeline.error().full_message()));
+   }
+   _instanced_pipeline = std::move(instanced_pipeline.value());
+
+   auto pool = vk::CommandPool::create(&_device,
+                                       _device.queue(vk::QueueFamilyType::Graphics).family_index(),
+                                       VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
    if (!pool) {
       throw std::runtime_error(std::format("Command pool error: {}", pool.error().full_message()));
    }
    _command_pool = std::move(pool.value());
 
-   std::ranges::for_each(std::views::iota(0u, MAX_FRAMES_IN_FLIGHT), [this, graphics_conf](auto) {
+   // Also stages the bindless material uploads
+   auto frame_allocator = vk::FrameAllocator::create(&_device,
+                                                     FRAME_ALLOCATOR_SIZE,
+                                                     _frame_pacer.frames_in_flight(),
+                                                     VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT |
+                                                         VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                                         VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+   if (!frame_allocator) {
+      throw std::runtime_error(
+          std::format("Frame allocator error: {}", frame_allocator.error().full_message()));
+   }
+   _frame_allocator = std::move(frame_allocator.value());
+
+   std::ranges::for_each(std::views::iota(0u, _frame_pacer.frames_in_flight()), [this](auto) {
       auto cmd_buf = vk::CommandBuffer::create(&_device, &_command_pool);
       if (!cmd_buf) {
          throw std::runtime_error(
@@ -154,66 +409,466 @@ Renderer::Renderer(std::shared_ptr<glfw::Window> window) : _window(std::move(win
       _command_buffers.emplace_back(std::move(cmd_buf.value()));
       _image_available.emplace_back(&_device);
       _render_finished.emplace_back(&_device);
-      auto& buffer = _uniform_buffers.emplace_back(
-          &_device,
-          transform_layout::stride,
-          VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-          VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-      buffer.map();  // TODO: map memory here?
-
-      auto& pool =
-          _descriptor_pools.emplace_back(&_device, graphics_conf.descriptor_pools.standard);
-      _descriptor_sets.emplace_back(
-          &_device, &pool, _descriptor_set_layout.get());  // todo: refactor
+      auto descriptors = vk::DescriptorAllocator::create(&_device);
+      if (!descriptors) {
+         throw std::runtime_error(std::format("Descriptor allocator error: {}",
+                                              descriptors.error().full_message()));
+      }
+      _descriptor_allocators.emplace_back(std::move(descriptors.value()));
       _fences.emplace_back(&_device);
-
-      _descriptor_sets.back().update(0, buffer.vk(), 0, sizeof(TransformUBO));
+      _instance_buffers.emplace_back(nullptr);
    });
-   _instance.log_device_info(&_surface);
+   _metrics = {.frames = &metrics::counter("render.frames"),
+               .draw_calls = &metrics::counter("render.draw_calls"),
+               .triangles = &metrics::counter("render.triangles"),
+               .frame_ms = &metrics::histogram("render.frame_ms"),
+               .record_ms = &metrics::histogram("render.record_ms"),
+               .submit_ms = &metrics::histogram("render.submit_ms"),
+               .present_ms = &metrics::histogram("render.present_ms")};
+   if (config.metrics_log_interval.count() > 0) {
+      metrics::Registry::instance().start_log_sink(config.metrics_log_interval);
+      _metrics_log_sink = std::make_unique<MetricsLogSink>();
+   }
+   if (config.gpu_profiling) {
+      auto profiler = vk::GpuProfiler::create(
+          &_device, {.frames_in_flight = _frame_pacer.frames_in_flight()});
+      if (profiler) {
+         _gpu_profiler = std::make_unique<vk::GpuProfiler>(std::move(profiler.value()));
+      }
+      else {
+         meddl::log::warn("GPU profiling disabled: {}", profiler.error().full_message());
+      }
+   }
+   if (_window) {
+      _instance.log_device_info(&_surface);
+   }
    auto sampler = vk::Sampler::create(&_device, vk::Sampler::Cfg{});
    if (!sampler) {
       meddl::log::error("{}", sampler.error().full_message());
    }
 }
 
+void Renderer::wait_for_frame()
+{
+   MEDDL_TRACE_SCOPE("render", "wait_for_frame");
+   if (!_render_thread) {
+      wait_for_gpu();
+      _frame_waited = true;
+      return;
+   }
+   auto& render_thread = *_render_thread;
+   auto picked_up = render_thread.picked_up.load(std::memory_order_acquire);
+   while (picked_up < render_thread.published) {
+      render_thread.picked_up.wait(picked_up, std::memory_order_acquire);
+      picked_up = render_thread.picked_up.load(std::memory_order_acquire);
+   }
+}
+
 void Renderer::draw(bool recreate_swapchain)
 {
+   MEDDL_TRACE_SCOPE("render", "draw");
+   // Offscreen targets are never recreated
+   if (!_window) {
+      _pending.framebuffer_size = {_swapchain.extent().width, _swapchain.extent().height};
+   }
+   else {
+      if (recreate_swapchain || _window->is_resized()) {
+         _window->reset_resized();
+         _pending.swapchain_generation++;
+      }
+      _pending.framebuffer_size = _window->get_framebuffer_size();
+   }
+
+   if (!_render_thread) {
+      render_frame(_pending);
+   }
+   else {
+      auto& render_thread = *_render_thread;
+      if (render_thread.failed.load(std::memory_order_acquire)) {
+         std::rethrow_exception(render_thread.error);
+      }
+      if (!render_thread.thread.joinable()) {
+         render_thread.thread =
+             std::jthread([this](std::stop_token stop) { render_loop(std::move(stop)); });
+      }
+      _pending.sequence = ++render_thread.published;
+      // Copy assignment keeps the slot's capacity, no allocations once the sizes settle
+      render_thread.mailbox.write_buffer() = _pending;
+      render_thread.mailbox.publish();
+   }
+   _pending.instances.clear();
+   _pending.batches.clear();
+}
+
+FrameReadback Renderer::read_frame()
+{
+   MEDDL_TRACE_SCOPE("render", "read_frame");
+   if (!_swapchain.is_offscreen()) {
+      throw std::runtime_error("read_frame needs a headless renderer");
+   }
+   if (_render_thread) {
+      // Until the last draw() is picked up, the lock below until it is submitted
+      wait_for_frame();
+      if (_render_thread->failed.load(std::memory_order_acquire)) {
+         std::rethrow_exception(_render_thread->error);
+      }
+   }
+   const auto lock = lock_render_thread();
+   if (_frame_count == 0) {
+      throw std::runtime_error("read_frame before the first draw");
+   }
+   // One frame in flight, so this is the fence of the last draw()
    _fences.at(_current_frame).wait(&_device);
-   uint32_t image_index{};
-   const auto result = vkAcquireNextImageKHR(_device.vk(),
-                                             _swapchain.vk(),
-                                             std::numeric_limits<uint64_t>::max(),
-                                             _image_available.at(_current_frame).vk(),
-                                             VK_NULL_HANDLE,
-                                             &image_index);
-
-   if (result == VK_ERROR_OUT_OF_DATE_KHR || recreate_swapchain) {
-      auto swapchain = vk::Swapchain::recreate(
-          &_device, &_surface, &_renderpass, _window->get_framebuffer_size(), _swapchain);
-      if (!swapchain) {
-         meddl::log::error("{}", swapchain.error().full_message());
+
+   const auto& image = _swapchain.image(0);
+   const auto extent = _swapchain.extent();
+   const auto texel_size = readback_texel_size(image.config().format);
+   if (texel_size == 0) {
+      throw std::runtime_error(std::format("Can't read back format {}",
+                                           static_cast<int32_t>(image.config().format)));
+   }
+   const VkDeviceSize size =
+       static_cast<VkDeviceSize>(extent.width) * extent.height * texel_size;
+   vk::Buffer staging(&_device,
+                      size,
+                      VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+   auto cmd = vk::CommandBuffer::begin_one_time_submit(&_device, &_command_pool);
+   if (!cmd) {
+      throw std::runtime_error(std::format("Readback error: {}", cmd.error().full_message()));
+   }
+   // Left in TRANSFER_SRC by the frame, only its writes need to be made visible
+   VkImageMemoryBarrier image_barrier{};
+   image_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+   image_barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+   image_barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+   image_barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+   image_barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+   image_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+   image_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+   image_barrier.image = image.vk();
+   image_barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+   vkCmdPipelineBarrier(cmd->vk(),
+                        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                        VK_PIPELINE_STAGE_TRANSFER_BIT,
+                        0,
+                        0,
+                        nullptr,
+                        0,
+                        nullptr,
+                        1,
+                        &image_barrier);
+
+   VkBufferImageCopy region{};
+   region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+   region.imageExtent = {extent.width, extent.height, 1};
+   vkCmdCopyImageToBuffer(cmd->vk(),
+                          image.vk(),
+                          VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                          staging.vk(),
+                          1,
+                          &region);
+
+   VkBufferMemoryBarrier buffer_barrier{};
+   buffer_barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+   buffer_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+   buffer_barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+   buffer_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+   buffer_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+   buffer_barrier.buffer = staging.vk();
+   buffer_barrier.size = VK_WHOLE_SIZE;
+   vkCmdPipelineBarrier(cmd->vk(),
+                        VK_PIPELINE_STAGE_TRANSFER_BIT,
+                        VK_PIPELINE_STAGE_HOST_BIT,
+                        0,
+                        0,
+                        nullptr,
+                        1,
+                        &buffer_barrier,
+                        0,
+                        nullptr);
+   // Waits for the queue to go idle
+   if (auto res = cmd->end_and_submit(&_device, &_command_pool); !res) {
+      throw std::runtime_error(std::format("Readback error: {}", res.error().full_message()));
+   }
+
+   FrameReadback frame{.width = extent.width,
+                       .height = extent.height,
+                       .format = image.config().format,
+                       .pixels = std::vector<uint8_t>(size)};
+   staging.map();
+   std::memcpy(frame.pixels.data(), staging.mapped_data(), size);
+   staging.unmap();
+   return frame;
+}
+
+std::vector<vk::GpuProfiler::RegionStats> Renderer::gpu_timings()
+{
+   const auto lock = lock_render_thread();
+   return _gpu_profiler ? _gpu_profiler->stats() : std::vector<vk::GpuProfiler::RegionStats>{};
+}
+
+std::string Renderer::trace_json()
+{
+   // Past any thread id, one GPU track per nesting level
+   constexpr uint32_t GPU_FIRST_TRACK = 1 << 16;
+   auto snapshot = trace::snapshot();
+   const auto lock = lock_render_thread();
+   if (_gpu_profiler) {
+      _gpu_profiler->append_trace(snapshot, GPU_FIRST_TRACK);
+   }
+   return trace::to_chrome_json(snapshot);
+}
+
+void Renderer::render_loop(std::stop_token stop)
+{
+   MEDDL_TRACE_THREAD_NAME("Render");
+   auto& render_thread = *_render_thread;
+   while (true) {
+      render_thread.mailbox.wait();
+      if (stop.stop_requested()) {
          return;
       }
-      _swapchain = std::move(swapchain.value());
-      meddl::log::debug("Successful swapchain receation");
-      return;
+      render_thread.mailbox.update();
+      try {
+         // Locked before the pick up is announced, read_frame() then waits for the submit
+         const std::scoped_lock lock(render_thread.mutex);
+         const auto& frame = render_thread.mailbox.read_buffer();
+         // A newer draw() replaces unread ones in the mailbox, so count by sequence and not by one
+         render_thread.picked_up.store(frame.sequence, std::memory_order_release);
+         render_thread.picked_up.notify_all();
+         render_frame(frame);
+      }
+      catch (...) {
+         render_thread.error = std::current_exception();
+         render_thread.failed.store(true, std::memory_order_release);
+         // Release a game thread stuck in wait_for_frame, draw() rethrows
+         render_thread.picked_up.store(std::numeric_limits<uint64_t>::max(),
+                                       std::memory_order_release);
+         render_thread.picked_up.notify_all();
+         return;
+      }
+   }
+}
+
+std::unique_lock<std::mutex> Renderer::lock_render_thread()
+{
+   if (!_render_thread) {
+      return {};
+   }
+   return std::unique_lock(_render_thread->mutex);
+}
+
+void Renderer::wait_for_gpu()
+{
+   MEDDL_TRACE_SCOPE("render", "wait_for_gpu");
+   _frame_pacer.wait(_swapchain.vk());
+   _fences.at(_current_frame).wait(&_device);
+}
+
+void Renderer::render_frame(const FrameSnapshot& frame)
+{
+   MEDDL_TRACE_SCOPE("render", "render_frame");
+   const auto frame_start = trace::now_ns();
+   if (_last_frame_start_ns != 0) {
+      _metrics.frame_ms->record(elapsed_ms(_last_frame_start_ns, frame_start));
+   }
+   _last_frame_start_ns = frame_start;
+   if (!_frame_waited) {
+      wait_for_gpu();
    }
-   else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
-      throw std::runtime_error("Failed to acquire next image");
+   _frame_waited = false;
+   release_retired_swapchains();
+   if (frame.swapchain_generation != _swapchain_generation) {
+      _swapchain_generation = frame.swapchain_generation;
+      rebuild_swapchain(frame.framebuffer_size);
+   }
+
+   const bool offscreen = _swapchain.is_offscreen();
+   uint32_t image_index{0};
+   if (!offscreen) {
+      MEDDL_TRACE_SCOPE("render", "acquire");
+      const auto acquire = [&] {
+         return vkAcquireNextImageKHR(_device.vk(),
+                                      _swapchain.vk(),
+                                      std::numeric_limits<uint64_t>::max(),
+                                      _image_available.at(_current_frame).vk(),
+                                      VK_NULL_HANDLE,
+                                      &image_index);
+      };
+      auto result = acquire();
+      // The semaphore is untouched when out of date, so retry on the new swapchain this frame
+      if (result == VK_ERROR_OUT_OF_DATE_KHR && rebuild_swapchain(frame.framebuffer_size)) {
+         result = acquire();
+      }
+
+      if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+         // e.g. minimized, nothing to render to
+         return;
+      }
+      else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+         throw std::runtime_error("Failed to acquire next image");
+      }
    }
    _fences.at(_current_frame).reset(&_device);
 
-   update_uniform_buffer(_current_frame);
+   const auto record_start = trace::now_ns();
+   _frame = &frame;
+   _frame_allocator.begin_frame(static_cast<uint32_t>(_current_frame));
+   update_uniform_buffer();
+   upload_instances();
+
+   auto& descriptors = _descriptor_allocators.at(_current_frame);
+   descriptors.reset();
+   const std::array<vk::DescriptorBinding, 1> frame_bindings = {
+       vk::DescriptorBinding{.binding = 0,
+                             .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+                             .buffer = _frame_allocator.buffer(),
+                             .offset = 0,
+                             .range = sizeof(TransformUBO)}};
+   auto frame_set = descriptors.get(_descriptor_set_layout.get(), frame_bindings);
+   if (!frame_set) {
+      throw std::runtime_error(
+          std::format("Descriptor set error: {}", frame_set.error().full_message()));
+   }
 
    _command_buffers.at(_current_frame).reset();
    _command_buffers.at(_current_frame).begin();
+   if (_bindless) {
+      auto res = _bindless->upload(&_command_buffers.at(_current_frame), &_frame_allocator);
+      if (!res) {
+         meddl::log::error("{}", res.error().full_message());
+      }
+   }
+   if (_gpu_profiler) {
+      _gpu_profiler->begin_frame(&_command_buffers.at(_current_frame),
+                                 static_cast<uint32_t>(_current_frame));
+      _gpu_profiler->begin_region(&_command_buffers.at(_current_frame), "frame");
+   }
 
    constexpr std::array<float, 4> DEBUG_COLOR = {0.1f, 0.1f, 1.0f, 1.0f};
    _instance.debugger()->begin_region(
        &_command_buffers.at(_current_frame), "Frame Rendering", DEBUG_COLOR);
-   _command_buffers.at(_current_frame)
-       .begin_renderpass(&_renderpass, &_swapchain, _swapchain.get_framebuffers()[image_index]);
+   _frame_set = frame_set.value();
+   if (_dynamic_rendering) {
+      record_render_graph(image_index);
+   }
+   else {
+      // Same region name as the render graph pass
+      if (_gpu_profiler) {
+         _gpu_profiler->begin_region(&_command_buffers.at(_current_frame), "forward");
+      }
+      _command_buffers.at(_current_frame)
+          .begin_renderpass(&_renderpass, &_swapchain, _swapchain.get_framebuffers()[image_index]);
+      record_scene();
+      _command_buffers.at(_current_frame).end_renderpass();
+      if (_gpu_profiler) {
+         _gpu_profiler->end_region(&_command_buffers.at(_current_frame));
+      }
+   }
+   if (_gpu_profiler) {
+      _gpu_profiler->end_region(&_command_buffers.at(_current_frame));
+   }
+   _command_buffers.at(_current_frame).end();
+   _instance.debugger()->end_region(&_command_buffers.at(_current_frame));
+   _metrics.record_ms->record(elapsed_ms(record_start, trace::now_ns()));
+
+   VkSubmitInfo submit_info{};
+   submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+
+   std::array<VkSemaphore, 1> wait_semaphores = {
+       _image_available[_current_frame].vk()};
+   std::array<VkPipelineStageFlags, 1> wait_stages = {
+       VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
+   // Offscreen, nothing is acquired or presented
+   submit_info.waitSemaphoreCount = offscreen ? 0 : 1;
+   submit_info.pWaitSemaphores = wait_semaphores.data();
+   submit_info.pWaitDstStageMask = wait_stages.data();
+
+   VkCommandBuffer command_buffer = _command_buffers.at(_current_frame).vk();
+   submit_info.commandBufferCount = 1;
+   submit_info.pCommandBuffers = &command_buffer;
+
+   std::array<VkSemaphore, 1> signal_semaphores = {
+       _render_finished.at(_current_frame).vk()};
+   submit_info.signalSemaphoreCount = offscreen ? 0 : 1;
+   submit_info.pSignalSemaphores = signal_semaphores.data();
+
+   {
+      MEDDL_TRACE_SCOPE("render", "submit");
+      const auto submit_start = trace::now_ns();
+      if (vkQueueSubmit(_device.queue(vk::QueueFamilyType::Graphics).vk(),
+                        1,
+                        &submit_info,
+                        _fences.at(_current_frame).vk()) != VK_SUCCESS) {
+         throw std::runtime_error("Failed to submit draw command buffer");
+      }
+      _metrics.submit_ms->record(elapsed_ms(submit_start, trace::now_ns()));
+   }
+   // After vkQueueSubmit, offscreen read_frame copies the image out instead
+   if (!offscreen) {
+      MEDDL_TRACE_SCOPE("render", "present");
+      VkPresentInfoKHR present_info{};
+      present_info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+
+      present_info.waitSemaphoreCount = 1;
+      present_info.pWaitSemaphores = signal_semaphores.data();
+
+      std::array<VkSwapchainKHR, 1> swapchains = {_swapchain.vk()};
+      present_info.swapchainCount = 1;
+      present_info.pSwapchains = swapchains.data();
+      present_info.pImageIndices = &image_index;
+      _frame_pacer.on_present(present_info, _swapchain.vk());
+
+      const auto present_start = trace::now_ns();
+      const auto result2 =
+          vkQueuePresentKHR(_device.queue(vk::QueueFamilyType::Present).vk(), &present_info);
+      _metrics.present_ms->record(elapsed_ms(present_start, trace::now_ns()));
+      if (result2 == VK_ERROR_OUT_OF_DATE_KHR || result2 == VK_SUBOPTIMAL_KHR) {
+         rebuild_swapchain(frame.framebuffer_size);
+      }
+      else if (result2 != VK_SUCCESS) {
+         throw std::runtime_error("Failed to present swapchain image");
+      }
+   }
+
+   _frame = nullptr;
+
+   // need to be after present because sync?
+   _current_frame = (_current_frame + 1) % _frame_pacer.frames_in_flight();
+   _frame_count++;
+   _metrics.frames->add();
+}
+
+bool Renderer::rebuild_swapchain(const glfw::FrameBufferSize& framebuffer_size)
+{
+   auto swapchain = vk::Swapchain::recreate(
+       &_device, &_surface, renderpass(), framebuffer_size, _swapchain);
+   if (!swapchain) {
+      meddl::log::error("{}", swapchain.error().full_message());
+      return false;
+   }
+   // Frames in flight may still reference the old images, destroyed later
+   _retired_swapchains.push_back({.swapchain = std::move(_swapchain), .retired_at = _frame_count});
+   _swapchain = std::move(swapchain.value());
+   meddl::log::debug(
+       MEDDL_LOG_SITE(), "Swapchain recreated, {} retired", _retired_swapchains.size());
+   return true;
+}
+
+void Renderer::release_retired_swapchains()
+{
+   // Fences signal in submission order, so once this frame's fence is waited on every frame
+   // up to _frame_count - frames in flight is done, including those using a retired swapchain
+   std::erase_if(_retired_swapchains, [this](const RetiredSwapchain& retired) {
+      return _frame_count >= retired.retired_at + _frame_pacer.frames_in_flight();
+   });
+}
 
+void Renderer::record_scene()
+{
+   MEDDL_TRACE_SCOPE("render", "record_scene");
    VkViewport viewport = {
        .x = 0.0f,
        .y = 0.0f,
@@ -237,83 +892,112 @@ void Renderer::draw(bool recreate_swapchain)
                            _pipeline_layout.vk(),
                            0,
                            1,
-                           _descriptor_sets.at(_current_frame).vk_ptr(),
-                           0,
-                           nullptr);
-   if (_vertex_buffer) {
+                           &_frame_set,
+                           1,
+                           &_transform_offset);
+   if (_bindless) {
+      auto res = _bindless->bind(&_command_buffers.at(_current_frame), _pipeline_layout.vk(), 1);
+      if (!res) {
+         meddl::log::error("{}", res.error().full_message());
+      }
+   }
+   if (_vertex_buffer && !_frame->batches.empty()) {
+      record_instanced_draws();
+   }
+   else if (_vertex_buffer) {
       draw_vertices();
    }
    else {
       _command_buffers.at(_current_frame).draw();
    }
+}
 
-   _command_buffers.at(_current_frame).end_renderpass();
-   _command_buffers.at(_current_frame).end();
-   _instance.debugger()->end_region(&_command_buffers.at(_current_frame));
-
-   VkSubmitInfo submit_info{};
-   submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-
-   std::array<VkSemaphore, MAX_FRAMES_IN_FLIGHT> wait_semaphores = {
-       _image_available[_current_frame].vk()};
-   std::array<VkPipelineStageFlags, 1> wait_stages = {
-       VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-   submit_info.waitSemaphoreCount = 1;
-   submit_info.pWaitSemaphores = wait_semaphores.data();
-   submit_info.pWaitDstStageMask = wait_stages.data();
-
-   VkCommandBuffer command_buffer = _command_buffers.at(_current_frame).vk();
-   submit_info.commandBufferCount = 1;
-   submit_info.pCommandBuffers = &command_buffer;
-
-   std::array<VkSemaphore, MAX_FRAMES_IN_FLIGHT> signal_semaphores = {
-       _render_finished.at(_current_frame).vk()};
-   submit_info.signalSemaphoreCount = 1;
-   submit_info.pSignalSemaphores = signal_semaphores.data();
-
-   if (vkQueueSubmit(
-           _device.queues().at(0).vk(), 1, &submit_info, _fences.at(_current_frame).vk()) !=
-       VK_SUCCESS) {
-      throw std::runtime_error("Failed to submit draw command buffer");
+void Renderer::build_render_graph()
+{
+   _render_graph = std::make_unique<vk::RenderGraph>();
+   // Handles are swapped in every frame, see record_render_graph
+   _color_target = _render_graph->import_image("swapchain",
+                                               VK_NULL_HANDLE,
+                                               VK_NULL_HANDLE,
+                                               VK_IMAGE_ASPECT_COLOR_BIT,
+                                               VK_IMAGE_LAYOUT_UNDEFINED,
+                                               _swapchain.is_offscreen()
+                                                   ? vk::ResourceUsage::TransferSrc
+                                                   : vk::ResourceUsage::Present);
+   const auto* depth = _swapchain.depth_image();
+   if (depth) {
+      _depth_target = _render_graph->import_image("depth",
+                                                  depth->vk(),
+                                                  depth->view(),
+                                                  depth->config().get_aspect_mask(),
+                                                  VK_IMAGE_LAYOUT_UNDEFINED);
    }
-   // After vkQueueSubmit
-   VkPresentInfoKHR present_info{};
-   present_info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 
-   present_info.waitSemaphoreCount = 1;
-   present_info.pWaitSemaphores = signal_semaphores.data();
-
-   std::array<VkSwapchainKHR, 1> swapchains = {_swapchain.vk()};
-   present_info.swapchainCount = 1;
-   present_info.pSwapchains = swapchains.data();
-   present_info.pImageIndices = &image_index;
-
-   // Use the presentation queue from your device
-   const auto result2 = vkQueuePresentKHR(_device.queues().at(0).vk(), &present_info);
-   if (result2 == VK_ERROR_OUT_OF_DATE_KHR || result2 == VK_SUBOPTIMAL_KHR ||
-       _window->is_resized()) {
-      _window->reset_resized();
+   auto pass = _render_graph->add_pass(
+       "forward", [this](vk::CommandBuffer& cmd, const vk::RenderGraph& graph) {
+          const auto& attachments = _swapchain.config().shared.attachments;
+          const auto& color_config = attachments.at(_swapchain.color_attachment());
+          auto color = vk::rendering_attachment(graph.view(_color_target),
+                                                VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                                                color_config);
+          color.clearValue.color = {{0.2f, 0.2f, 0.2f, 1.0f}};
+
+          std::optional<VkRenderingAttachmentInfo> depth_info;
+          std::optional<VkRenderingAttachmentInfo> stencil_info;
+          if (_depth_target.valid()) {
+             auto depth_config = std::ranges::find_if(
+                 attachments, [](const auto& a) { return a.is_depth_stencil; });
+             depth_info = vk::rendering_attachment(graph.view(_depth_target),
+                                                   VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+                                                   *depth_config);
+             if (depth_config->get_aspect_mask() & VK_IMAGE_ASPECT_STENCIL_BIT) {
+                stencil_info = depth_info;
+                stencil_info->loadOp = depth_config->stencil_load_op;
+                stencil_info->storeOp = depth_config->stencil_store_op;
+             }
+          }
+
+          const VkRect2D area = {.offset = {0, 0}, .extent = _swapchain.extent()};
+          cmd.begin_rendering(area,
+                              std::span(&color, 1),
+                              depth_info ? &*depth_info : nullptr,
+                              stencil_info ? &*stencil_info : nullptr);
+          record_scene();
+          cmd.end_rendering();
+       });
+   pass.write(_color_target, vk::ResourceUsage::ColorAttachment);
+   if (_depth_target.valid()) {
+      pass.write(_depth_target, vk::ResourceUsage::DepthAttachment);
+   }
 
-      auto swapchain = vk::Swapchain::recreate(
-          &_device, &_surface, &_renderpass, _window->get_framebuffer_size(), _swapchain);
+   if (auto res = _render_graph->compile(&_device); !res) {
+      throw std::runtime_error(
+          std::format("Render graph error: {}", res.error().full_message()));
+   }
+}
 
-      if (swapchain) {
-         _swapchain = std::move(swapchain.value());
-      }
-      else {
-         meddl::log::error("{}", swapchain.error().full_message());
-      }
+void Renderer::record_render_graph(uint32_t image_index)
+{
+   if (!_render_graph) {
+      build_render_graph();
    }
-   else if (result2 != VK_SUCCESS) {
-      throw std::runtime_error("Failed to present swapchain image");
+   // Both change on swapchain recreation, the passes and barriers don't
+   const auto& target = _swapchain.image(image_index);
+   _render_graph->update_import(_color_target, target.vk(), target.view());
+   if (const auto* depth = _swapchain.depth_image(); depth && _depth_target.valid()) {
+      _render_graph->update_import(_depth_target, depth->vk(), depth->view());
+   }
+   if (auto res =
+           _render_graph->execute(&_command_buffers.at(_current_frame), _gpu_profiler.get());
+       !res) {
+      meddl::log::error("{}", res.error().full_message());
    }
-
-   // need to be after present because sync?
-   _current_frame = (_current_frame + 1) % MAX_FRAMES_IN_FLIGHT;
 }
 
 void Renderer::set_indices(const std::vector<uint32_t>& indices)
 {
+   MEDDL_TRACE_SCOPE("render", "set_indices");
+   const auto lock = lock_render_thread();
    const VkDeviceSize buffer_size = indices.size() * sizeof(uint32_t);
 
    vkDeviceWaitIdle(_device.vk());
@@ -339,6 +1023,8 @@ void Renderer::set_indices(const std::vector<uint32_t>& indices)
 }
 void Renderer::set_textures(const ModelData& data)
 {
+   MEDDL_TRACE_SCOPE("render", "set_textures");
+   const auto lock = lock_render_thread();
    meddl::log::debug("Setting this many textures: {}", data.textures.size());
    for (const auto& [name, texture_data] : data.textures) {
       auto texture = vk::Texture::create(&_device, texture_data);
@@ -346,19 +1032,82 @@ void Renderer::set_textures(const ModelData& data)
          meddl::log::warn("Texture {} failed: {}", name, texture.error().full_message());
          continue;
       }
+      if (_bindless) {
+         auto slot = _bindless->add_texture(texture.value());
+         if (slot) {
+            _texture_slots[name] = slot.value();
+         }
+         else {
+            meddl::log::warn("Texture {} not bindless: {}", name, slot.error().full_message());
+         }
+      }
       _textures.emplace_back(std::move(texture.value()));
       meddl::log::debug("Created texture: {}", name);
    }
+   if (_bindless) {
+      _bindless->flush();
+   }
+}
+
+void Renderer::set_materials(const ModelData& data)
+{
+   const auto lock = lock_render_thread();
+   if (!_bindless) {
+      return;
+   }
+   const auto slot_of =
+       [this](const std::optional<std::string>& name) -> const vk::BindlessTexture* {
+      if (!name) {
+         return nullptr;
+      }
+      auto it = _texture_slots.find(name.value());
+      return it != _texture_slots.end() ? &it->second : nullptr;
+   };
+
+   std::vector<BindlessMaterial> materials;
+   materials.reserve(data.materials.size());
+   for (const auto& material : data.materials) {
+      const auto ubo = material.to_material_ubo();
+      BindlessMaterial& gpu = materials.emplace_back();
+      gpu.diffuse_color = ubo.diffuse_color;
+      gpu.shininess = ubo.shininess;
+      gpu.metallic = ubo.metallic;
+      gpu.roughness = ubo.roughness;
+      gpu.ao = ubo.ao;
+      gpu.albedo_texture = bindless_material_layout::invalid_index;
+      gpu.normal_texture = bindless_material_layout::invalid_index;
+      gpu.metallic_roughness_texture = bindless_material_layout::invalid_index;
+      gpu.sampler_index = 0;
+
+      const auto* albedo = slot_of(material.albedo_texture ? material.albedo_texture
+                                                           : material.base_color_texture);
+      if (albedo) {
+         gpu.albedo_texture = albedo->image;
+         gpu.sampler_index = albedo->sampler;
+      }
+      if (const auto* normal = slot_of(material.normal_texture)) {
+         gpu.normal_texture = normal->image;
+      }
+      if (const auto* metallic_roughness = slot_of(material.metallic_roughness_texture)) {
+         gpu.metallic_roughness_texture = metallic_roughness->image;
+      }
+   }
+
+   // Copied in by the next frame, frames in flight keep reading the old table until then
+   if (auto res = _bindless->set_materials(materials); !res) {
+      meddl::log::error("{}", res.error().full_message());
+   }
 }
 
 void Renderer::set_view_matrix(const glm::mat4 view_matrix)
 {
-   _view_matrix = view_matrix;
-   _camera_updated = true;
+   _pending.view = view_matrix;
 }
 
 void Renderer::set_vertices(const std::vector<Vertex>& vertices)
 {
+   MEDDL_TRACE_SCOPE("render", "set_vertices");
+   const auto lock = lock_render_thread();
    const VkDeviceSize buffer_size = vertices.size() * sizeof(Vertex);
 
    vkDeviceWaitIdle(_device.vk());
@@ -400,11 +1149,93 @@ void Renderer::draw_vertices(uint32_t vertex_count)
                               0,
                               VK_INDEX_TYPE_UINT32);
          vkCmdDrawIndexed(_command_buffers.at(_current_frame).vk(), _index_count, 1, 0, 0, 0);
+         _metrics.triangles->add(_index_count / 3);
       }
       else {
          vkCmdDraw(_command_buffers.at(_current_frame).vk(), vertex_count, 1, 0, 0);
+         _metrics.triangles->add(vertex_count / 3);
       }
+      _metrics.draw_calls->add();
+   }
+}
+
+void Renderer::draw_instanced(std::span<const glm::mat4> transforms,
+                              std::span<const uint32_t> material_ids)
+{
+   if (transforms.empty()) {
+      return;
+   }
+   if (!material_ids.empty() && material_ids.size() != transforms.size()) {
+      meddl::log::warn(MEDDL_LOG_SITE(),
+                       "draw_instanced: {} material ids for {} transforms",
+                       material_ids.size(),
+                       transforms.size());
    }
+
+   auto& instances = _pending.instances;
+   const auto first = static_cast<uint32_t>(instances.size());
+   for (size_t i = 0; i < transforms.size(); i++) {
+      InstanceData instance{};
+      instance.model = transforms[i];
+      instance.material_id = i < material_ids.size() ? material_ids[i] : 0;
+      instances.push_back(instance);
+   }
+   _pending.batches.push_back(
+       {.first_instance = first, .instance_count = static_cast<uint32_t>(transforms.size())});
+}
+
+void Renderer::upload_instances()
+{
+   MEDDL_TRACE_SCOPE("render", "upload_instances");
+   const auto& instances = _frame->instances;
+   if (instances.empty()) {
+      return;
+   }
+
+   // The fence for this frame has been waited on, so its buffer is free to grow or overwrite
+   const VkDeviceSize required = instances.size() * instance_layout::stride;
+   auto& buffer = _instance_buffers.at(_current_frame);
+   if (!buffer || buffer->size() < required) {
+      const VkDeviceSize capacity = std::max(required, buffer ? buffer->size() * 2 : required);
+      buffer = std::make_unique<vk::Buffer>(
+          &_device,
+          capacity,
+          VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+          VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+      buffer->map();
+      meddl::log::debug("Instance buffer for frame {} grown to {} bytes", _current_frame, capacity);
+   }
+   buffer->update(instances.data(), required);
+}
+
+void Renderer::record_instanced_draws()
+{
+   auto& cmd = _command_buffers.at(_current_frame);
+   cmd.bind_pipeline(&_instanced_pipeline);
+
+   std::array<VkBuffer, 2> buffers = {_vertex_buffer->vk(),
+                                      _instance_buffers.at(_current_frame)->vk()};
+   std::array<VkDeviceSize, 2> offsets = {0, 0};
+   vkCmdBindVertexBuffers(cmd.vk(), 0, 2, buffers.data(), offsets.data());
+
+   const bool indexed = _index_buffer && _index_count > 0;
+   if (indexed) {
+      vkCmdBindIndexBuffer(cmd.vk(), _index_buffer->vk(), 0, VK_INDEX_TYPE_UINT32);
+   }
+   uint64_t triangles = 0;
+   for (const auto& batch : _frame->batches) {
+      if (indexed) {
+         vkCmdDrawIndexed(
+             cmd.vk(), _index_count, batch.instance_count, 0, 0, batch.first_instance);
+      }
+      else {
+         vkCmdDraw(cmd.vk(), _vertex_count, batch.instance_count, 0, batch.first_instance);
+      }
+      triangles += static_cast<uint64_t>(indexed ? _index_count : _vertex_count) / 3 *
+                   batch.instance_count;
+   }
+   _metrics.draw_calls->add(_frame->batches.size());
+   _metrics.triangles->add(triangles);
 }
 
 void debug_matrix(const glm::mat4& matrix, const std::string& name)
@@ -420,7 +1251,7 @@ void debug_matrix(const glm::mat4& matrix, const std::string& name)
    meddl::log::debug("]");
 }
 
-void Renderer::update_uniform_buffer(uint32_t current_image)
+void Renderer::update_uniform_buffer()
 {
    static auto start_time = std::chrono::high_resolution_clock::now();
 
@@ -441,8 +1272,8 @@ void Renderer::update_uniform_buffer(uint32_t current_image)
    ubo.projection = glm::perspective(glm::radians(FOV_DEGREES), aspect, NEAR_PLANE, FAR_PLANE);
    ubo.projection[1][1] *= -1;  // Flip for Vulkan coordinate system
 
-   if (_camera_updated) {
-      ubo.view = _view_matrix;
+   if (_frame->view) {
+      ubo.view = _frame->view.value();
    }
    else {
       constexpr float CAMERA_DISTANCE = 2.0f;
@@ -451,7 +1282,12 @@ void Renderer::update_uniform_buffer(uint32_t current_image)
                              glm::vec3(0.0f, 1.0f, 0.0f));
    }
 
-   std::memcpy(_uniform_buffers.at(current_image).mapped_data(), &ubo, sizeof(ubo));
+   auto offset = _frame_allocator.push(ubo);
+   if (!offset) {
+      meddl::log::error("{}", offset.error().full_message());
+      return;
+   }
+   _transform_offset = offset.value();
 }
 
 }  // namespace meddl::render
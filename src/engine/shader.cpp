@@ -5,6 +5,7 @@
 #include <shaderc/shaderc.hpp>
 
 #include "core/error.h"
+#include "core/trace.h"
 #include "engine/loader.h"
 
 namespace meddl::engine::loader {
@@ -12,6 +13,7 @@ namespace meddl::engine::loader {
 namespace {
 std::expected<std::string, ShaderError> read_file(const std::filesystem::path& path)
 {
+   MEDDL_TRACE_SCOPE("shader", "read_file");
    try {
       std::ifstream file(path, std::ios::binary);
       if (!file) {
@@ -57,6 +59,7 @@ std::expected<ShaderData, ShaderError> compile_glsl(const std::string& source,
                                                     const std::string& filename,
                                                     const std::string& entry_point)
 {
+   MEDDL_TRACE_SCOPE("shader", "compile_glsl");
    ShaderData result;
    result.entry_point = entry_point;
 
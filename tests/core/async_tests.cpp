@@ -157,4 +157,35 @@ TEST_CASE_METHOD(AsyncFixture, "Multiple tasks execute concurrently", "[async]")
       REQUIRE(max_concurrent >= 2);
    }
 }
+
+TEST_CASE_METHOD(AsyncFixture, "Scheduled work is counted until it runs", "[async]")
+{
+   // A single General thread, the first task keeps it busy
+   manager.reset(8);
+   auto scheduler = manager.scheduler(meddl::async::PoolType::General);
+   const auto& queued = meddl::metrics::gauge("pool.general.queued");
+   const auto before = queued.value();
+
+   std::atomic<bool> running{false};
+   std::atomic<bool> release{false};
+   std::atomic<bool> done{false};
+   stdexec::start_detached(stdexec::schedule(scheduler) | stdexec::then([&] {
+                              running = true;
+                              while (!release) {
+                                 std::this_thread::yield();
+                              }
+                           }));
+   while (!running) {
+      std::this_thread::yield();
+   }
+   stdexec::start_detached(
+       stdexec::starts_on(scheduler, stdexec::just() | stdexec::then([&] { done = true; })));
+   REQUIRE(queued.value() == before + 1.0);
+
+   release = true;
+   while (!done) {
+      std::this_thread::yield();
+   }
+   REQUIRE(queued.value() == before);
+}
 // NOLINTEND (cppcoreguidelines-avoid-do-while)
@@ -0,0 +1,94 @@
+#include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/async.h"
+#include "engine/events/event_bus.h"
+
+using meddl::async::PoolType;
+using namespace meddl::events;
+
+// because of catch2
+// NOLINTBEGIN (cppcoreguidelines-avoid-do-while)
+TEST_CASE("EventBus delivers posts from other threads on pump", "[events]")
+{
+   EventBus bus;
+   std::vector<std::string> loaded;
+   std::thread::id delivered_on;
+   bus.subscribe<AssetLoaded>([&](const AssetLoaded& event) {
+      loaded.push_back(event.path.string());
+      delivered_on = std::this_thread::get_id();
+   });
+
+   std::atomic<int> posted{0};
+   std::vector<std::jthread> workers;
+   for (int i = 0; i < 4; i++) {
+      workers.emplace_back([&bus, &posted, i] {
+         posted += bus.post(AssetLoaded{.path = std::to_string(i)}) ? 1 : 0;
+      });
+   }
+   workers.clear();
+   REQUIRE(posted == 4);
+   // Nobody subscribed
+   REQUIRE(bus.post(ShaderCompiled{.path = "shader.vert"}));
+
+   REQUIRE(loaded.empty());
+   REQUIRE(bus.pump() == 4);
+   REQUIRE(loaded.size() == 4);
+   REQUIRE(delivered_on == std::this_thread::get_id());
+   REQUIRE(bus.pump() == 0);
+   REQUIRE(bus.dropped() == 0);
+}
+
+TEST_CASE("EventBus delivers on a pool", "[events]")
+{
+   meddl::async::ThreadPoolManager::instance().reset();
+   constexpr int COUNT = 200;
+   std::atomic<int> compiled{0};
+   std::atomic<size_t> words{0};
+   {
+      EventBus bus(64);
+      bus.subscribe<ShaderCompiled>(PoolType::Compute, [&](const ShaderCompiled& event) {
+         compiled++;
+         words += event.spirv.size();
+      });
+      for (int i = 0; i < COUNT; i++) {
+         while (!bus.post(ShaderCompiled{.spirv = {1, 2, 3}})) {
+            std::this_thread::yield();
+         }
+      }
+      bus.wait_idle();
+      REQUIRE(compiled == COUNT);
+      REQUIRE(words == COUNT * 3);
+      REQUIRE(bus.pump() == 0);
+   }
+}
+
+TEST_CASE("EventBus delivers concurrent posts to a pool", "[events]")
+{
+   meddl::async::ThreadPoolManager::instance().reset();
+   constexpr int THREADS = 4;
+   constexpr int PER_THREAD = 500;
+   std::atomic<int> loaded{0};
+   {
+      EventBus bus(4096);
+      bus.subscribe<AssetLoaded>(PoolType::IO, [&loaded](const AssetLoaded&) { loaded++; });
+
+      std::atomic<int> posted{0};
+      std::vector<std::jthread> producers;
+      for (int t = 0; t < THREADS; t++) {
+         producers.emplace_back([&bus, &posted] {
+            for (int i = 0; i < PER_THREAD; i++) {
+               posted += bus.post(AssetLoaded{}) ? 1 : 0;
+            }
+         });
+      }
+      producers.clear();
+      bus.wait_idle();
+      REQUIRE(posted == THREADS * PER_THREAD);
+      REQUIRE(loaded == THREADS * PER_THREAD);
+   }
+}
+// NOLINTEND
@@ -0,0 +1,73 @@
+#include <catch2/catch_test_macros.hpp>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "core/inline_function.h"
+#include "engine/events/dispatcher.h"
+
+using meddl::InlineFunction;
+using namespace meddl::events;
+
+// because of catch2
+// NOLINTBEGIN (cppcoreguidelines-avoid-do-while)
+TEST_CASE("InlineFunction moves and destroys its callable", "[events]")
+{
+   auto counter = std::make_shared<int>(0);
+   {
+      InlineFunction<int(int)> add = [counter](int value) { return *counter += value; };
+      REQUIRE(counter.use_count() == 2);
+      REQUIRE(add(2) == 2);
+
+      InlineFunction<int(int)> moved = std::move(add);
+      REQUIRE_FALSE(add);
+      REQUIRE(moved(3) == 5);
+      REQUIRE(counter.use_count() == 2);
+
+      std::vector<InlineFunction<int(int)>> functions;
+      functions.push_back(std::move(moved));
+      functions.emplace_back([](int value) { return value * 2; });
+      REQUIRE(functions[0](1) == 6);
+      REQUIRE(functions[1](4) == 8);
+   }
+   REQUIRE(counter.use_count() == 1);
+}
+
+TEST_CASE("EventDispatcher routes typed events", "[events]")
+{
+   EventDispatcher dispatcher;
+   float last_x = 0.0f;
+   int any_key = 0;
+   int quit = 0;
+   dispatcher.subscribe<MouseMoved>([&](const MouseMoved& event) {
+      last_x = event.x;
+      return true;
+   });
+   dispatcher.subscribe<KeyPressed>([&](const KeyPressed&) {
+      any_key++;
+      return false;
+   });
+   dispatcher.subscribe(KeyPressed{.keycode = Key::Q}, [&](const KeyPressed&) {
+      quit++;
+      return true;
+   });
+
+   REQUIRE(dispatcher.dispatch(MouseMoved{.x = 4.0f, .y = 2.0f}));
+   REQUIRE(last_x == 4.0f);
+
+   REQUIRE_FALSE(dispatcher.dispatch(KeyPressed{.keycode = Key::W}));
+   REQUIRE(dispatcher.dispatch(KeyPressed{.keycode = Key::Q}));
+   REQUIRE(any_key == 2);
+   REQUIRE(quit == 1);
+
+   // Nobody listens
+   REQUIRE_FALSE(dispatcher.dispatch(WindowResize{.width = 1, .height = 1}));
+
+   REQUIRE(dispatcher.handler_count<KeyPressed>() == 2);
+   dispatcher.clear<KeyPressed>();
+   REQUIRE(dispatcher.handler_count<KeyPressed>() == 0);
+   REQUIRE(dispatcher.handler_count<MouseMoved>() == 1);
+   dispatcher.clear();
+   REQUIRE(dispatcher.handler_count<MouseMoved>() == 0);
+}
+// NOLINTEND
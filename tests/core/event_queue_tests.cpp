@@ -0,0 +1,90 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#include "engine/events/event_queue.h"
+
+using namespace meddl::events;
+
+// because of catch2
+// NOLINTBEGIN (cppcoreguidelines-avoid-do-while)
+TEST_CASE("EventQueue coalesces runs and keeps order", "[events]")
+{
+   EventQueue queue(16);
+   queue.push(MouseMoved{.x = 1.0f, .y = 1.0f});
+   queue.push(MouseMoved{.x = 2.0f, .y = 2.0f});
+   queue.push(MouseMoved{.x = 3.0f, .y = 3.0f});
+   queue.push(KeyPressed{.keycode = Key::W});
+   queue.push(MouseMoved{.x = 4.0f, .y = 4.0f});
+   queue.push(MouseScrolled{.x_offset = 0.0f, .y_offset = 1.0f});
+   queue.push(MouseScrolled{.x_offset = 0.0f, .y_offset = 2.0f});
+   queue.push(WindowResize{.width = 100, .height = 100});
+   queue.push(WindowResize{.width = 200, .height = 150});
+   REQUIRE(queue.size() == 9);
+
+   std::vector<QueuedEvent> seen;
+   REQUIRE(queue.drain([&](const auto& event) { seen.emplace_back(event); }) == 5);
+   REQUIRE(queue.size() == 0);
+   REQUIRE(seen.size() == 5);
+   REQUIRE(std::get<MouseMoved>(seen[0]).x == 3.0f);
+   REQUIRE(std::get<KeyPressed>(seen[1]).keycode == Key::W);
+   REQUIRE(std::get<MouseMoved>(seen[2]).x == 4.0f);
+   REQUIRE(std::get<MouseScrolled>(seen[3]).y_offset == 3.0f);
+   REQUIRE(std::get<WindowResize>(seen[4]).width == 200);
+
+   REQUIRE(queue.drain([](const auto&) {}) == 0);
+}
+
+TEST_CASE("EventQueue drops and counts when full", "[events]")
+{
+   EventQueue queue(3);
+   REQUIRE(queue.capacity() == 4);
+   for (int i = 0; i < 6; i++) {
+      queue.push(KeyPressed{.keycode = Key::A});
+   }
+   REQUIRE(queue.size() == 4);
+   REQUIRE(queue.dropped() == 2);
+
+   EventDispatcher dispatcher;
+   int pressed = 0;
+   dispatcher.subscribe<KeyPressed>([&](const KeyPressed&) {
+      pressed++;
+      return true;
+   });
+   REQUIRE(queue.drain(dispatcher) == 4);
+   REQUIRE(pressed == 4);
+   REQUIRE(queue.push(KeyPressed{.keycode = Key::A}));
+}
+
+TEST_CASE("EventQueue hands events from one thread to another", "[events]")
+{
+   constexpr int COUNT = 100000;
+   EventQueue queue(64);
+   size_t retries = 0;
+   std::jthread producer([&queue, &retries] {
+      for (int i = 0; i < COUNT; i++) {
+         const auto key = i % 2 == 0 ? Key::A : Key::B;
+         while (!queue.push(KeyPressed{.keycode = key})) {
+            retries++;
+            std::this_thread::yield();
+         }
+      }
+   });
+
+   int received = 0;
+   bool in_order = true;
+   while (received < COUNT) {
+      queue.drain([&](const auto& event) {
+         if constexpr (std::is_same_v<std::decay_t<decltype(event)>, KeyPressed>) {
+            in_order &= event.keycode == (received % 2 == 0 ? Key::A : Key::B);
+            received++;
+         }
+      });
+   }
+   REQUIRE(received == COUNT);
+   REQUIRE(in_order);
+   producer.join();
+   REQUIRE(queue.dropped() == retries);
+}
+// NOLINTEND
@@ -0,0 +1,187 @@
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/log.h"
+#include "spdlog/sinks/ostream_sink.h"
+
+using meddl::log::detail::RecordHeader;
+using meddl::log::detail::ThreadBuffer;
+
+namespace {
+//! Routes the backend into a string for the lifetime of the capture
+class Capture {
+  public:
+   Capture() : _previous(meddl::log::get_logger())
+   {
+      auto logger = std::make_shared<spdlog::logger>(
+          "test", std::make_shared<spdlog::sinks::ostream_sink_mt>(_stream));
+      logger->set_pattern("%v");
+      logger->set_level(spdlog::level::trace);
+      meddl::log::set_logger(logger);
+      meddl::log::init(spdlog::level::trace);
+   }
+   ~Capture()
+   {
+      meddl::log::set_logger(_previous);
+      meddl::log::init(spdlog::level::info);
+   }
+   Capture(const Capture&) = delete;
+   Capture& operator=(const Capture&) = delete;
+
+   std::string text()
+   {
+      meddl::log::flush();
+      return _stream.str();
+   }
+
+  private:
+   std::ostringstream _stream;
+   std::shared_ptr<spdlog::logger> _previous;
+};
+}  // namespace
+
+// because of catch2
+// NOLINTBEGIN (cppcoreguidelines-avoid-do-while)
+TEST_CASE("Log arguments are copied and formatted on the backend", "[log]")
+{
+   Capture capture;
+   const char* literal = "literal";
+   meddl::log::info("{} {} {:.3f} {} {}", 42, true, 1.5, literal, std::string_view("view"));
+   {
+      std::string temporary = "gone before the backend runs";
+      meddl::log::warn("{}", temporary);
+      std::memset(temporary.data(), 'x', temporary.size());
+   }
+   meddl::log::init(spdlog::level::warn);
+   meddl::log::info("filtered at runtime");
+   meddl::log::error("{{escaped}}");
+
+   REQUIRE(capture.text() ==
+           "42 true 1.500 literal view\ngone before the backend runs\n{escaped}\n");
+}
+
+TEST_CASE("Every thread's messages arrive", "[log]")
+{
+   Capture capture;
+   const auto dropped_before = meddl::log::dropped();
+   std::vector<std::jthread> threads;
+   for (int t = 0; t < 4; t++) {
+      threads.emplace_back([t] {
+         for (int i = 0; i < 1000; i++) {
+            meddl::log::info("thread {} message {}", t, i);
+         }
+      });
+   }
+   threads.clear();
+
+   const auto text = capture.text();
+   size_t lines = 0;
+   for (char c : text) {
+      lines += c == '\n' ? 1 : 0;
+   }
+   REQUIRE(meddl::log::dropped() == dropped_before);
+   REQUIRE(lines == 4000);
+   REQUIRE(text.find("thread 3 message 999\n") != std::string::npos);
+}
+
+TEST_CASE("Thread buffers drop instead of blocking when full", "[log]")
+{
+   ThreadBuffer buffer(256);
+   REQUIRE(buffer.capacity() == 256);
+
+   const auto push = [&buffer](uint32_t size, int64_t tag) {
+      auto* out = buffer.reserve(size);
+      if (!out) {
+         return false;
+      }
+      const RecordHeader header{.size = size, .time_ns = tag};
+      std::memcpy(out, &header, sizeof(header));
+      buffer.commit();
+      return true;
+   };
+   const auto pop = [&buffer] {
+      const auto* record = buffer.peek();
+      const auto tag = record ? record->time_ns : -1;
+      if (record) {
+         buffer.pop();
+      }
+      return tag;
+   };
+
+   REQUIRE(push(96, 1));
+   REQUIRE(push(96, 2));
+   REQUIRE_FALSE(push(96, 3));
+   REQUIRE(buffer.dropped() == 1);
+
+   // The next record does not fit before the end and starts over at the front
+   REQUIRE(pop() == 1);
+   REQUIRE(push(80, 4));
+   REQUIRE(pop() == 2);
+   REQUIRE(pop() == 4);
+   REQUIRE(pop() == -1);
+
+   for (int64_t i = 0; i < 100; i++) {
+      REQUIRE(push(48 + (i % 3) * 40, i));
+      REQUIRE(pop() == i);
+   }
+   REQUIRE(buffer.dropped() == 1);
+}
+
+TEST_CASE("Log sites rate limit and summarize repeats", "[log]")
+{
+   constexpr int64_t SECOND = 1'000'000'000;
+   meddl::log::LogSite site(1.0, 2, std::chrono::seconds(10));
+
+   REQUIRE(site.admit(1, 0).message);
+   REQUIRE(site.admit(2, 0).message);
+   REQUIRE_FALSE(site.admit(3, 0).message);
+   const auto refilled = site.admit(4, SECOND);
+   REQUIRE(refilled.message);
+   REQUIRE(refilled.suppressed == 1);
+
+   REQUIRE_FALSE(site.admit(4, SECOND + 1).message);
+   REQUIRE_FALSE(site.admit(4, SECOND + 2).message);
+   const auto summary = site.admit(4, 12 * SECOND);
+   REQUIRE_FALSE(summary.message);
+   REQUIRE(summary.repeated == 3);
+   const auto changed = site.admit(5, 13 * SECOND, meddl::log::Level::warn);
+   REQUIRE(changed.message);
+   REQUIRE(changed.repeated == 0);
+
+   // The repeats stop, their summary is due once the interval passed
+   REQUIRE_FALSE(site.admit(5, 14 * SECOND).message);
+   REQUIRE(site.expire(15 * SECOND).repeated == 0);
+   const auto expired = site.expire(23 * SECOND);
+   REQUIRE_FALSE(expired.message);
+   REQUIRE(expired.repeated == 1);
+   REQUIRE(expired.level == meddl::log::Level::warn);
+   REQUIRE(site.expire(40 * SECOND).repeated == 0);
+}
+
+TEST_CASE("Repeated messages from one call site are collapsed", "[log]")
+{
+   Capture capture;
+   for (int i = 0; i < 50; i++) {
+      meddl::log::info(MEDDL_LOG_SITE(), "resize {}", i < 49 ? 7 : 8);
+   }
+   REQUIRE(capture.text() == "resize 7\nLast message repeated 48 times\nresize 8\n");
+}
+
+TEST_CASE("Repeats are summarized after they stop", "[log]")
+{
+   Capture capture;
+   for (int i = 0; i < 5; i++) {
+      meddl::log::info(MEDDL_LOG_SITE(1.0, 5, std::chrono::milliseconds(100)), "storm");
+   }
+   // Reported by the backend thread, nothing logs from this site again
+   std::this_thread::sleep_for(std::chrono::milliseconds(500));
+   REQUIRE(capture.text() == "storm\nLast message repeated 4 times\n");
+}
+// NOLINTEND
@@ -0,0 +1,85 @@
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/metrics.h"
+
+using meddl::metrics::CounterValue;
+using meddl::metrics::HistogramValue;
+
+// because of catch2
+// NOLINTBEGIN (cppcoreguidelines-avoid-do-while)
+TEST_CASE("Counters sum every thread", "[metrics]")
+{
+   auto& counter = meddl::metrics::counter("test.counter");
+   REQUIRE(&counter == &meddl::metrics::counter("test.counter"));
+   const auto before = counter.value();
+
+   std::vector<std::thread> threads;
+   for (int t = 0; t < 8; t++) {
+      threads.emplace_back([&counter] {
+         for (int i = 0; i < 10000; i++) {
+            counter.add();
+         }
+      });
+   }
+   for (auto& thread : threads) {
+      thread.join();
+   }
+   REQUIRE(counter.value() - before == 80000);
+}
+
+TEST_CASE("Gauges keep the current level", "[metrics]")
+{
+   auto& gauge = meddl::metrics::gauge("test.gauge");
+   gauge.set(4.0);
+   gauge.add(-1.5);
+   REQUIRE(gauge.value() == 2.5);
+}
+
+TEST_CASE("Histograms bucket and estimate percentiles", "[metrics]")
+{
+   meddl::metrics::Histogram histogram({1.0, 10.0, 100.0});
+   for (int i = 0; i < 90; i++) {
+      histogram.record(0.5);
+   }
+   for (int i = 0; i < 9; i++) {
+      histogram.record(5.0);
+   }
+   histogram.record(1000.0);
+
+   const HistogramValue value{.name = "h", .bounds = histogram.bounds(), .data = histogram.data()};
+   REQUIRE(value.data.count == 100);
+   REQUIRE(value.data.buckets == std::vector<uint64_t>{90, 9, 0, 1});
+   REQUIRE(value.percentile(0.50) == 1.0);
+   REQUIRE(value.percentile(0.95) == 10.0);
+   REQUIRE(value.percentile(1.0) == 100.0);
+}
+
+TEST_CASE("Snapshots report the change since an earlier one", "[metrics]")
+{
+   auto& counter = meddl::metrics::counter("test.delta");
+   auto& histogram = meddl::metrics::histogram("test.delta_ms");
+   counter.add(5);
+   histogram.record(3.0);
+   const auto earlier = meddl::metrics::Registry::instance().snapshot();
+
+   counter.add(2);
+   histogram.record(7.0);
+   histogram.record(7.0);
+   const auto delta = meddl::metrics::Registry::instance().snapshot().since(earlier);
+
+   const auto counter_value = std::ranges::find(delta.counters, "test.delta", &CounterValue::name);
+   REQUIRE(counter_value != delta.counters.end());
+   REQUIRE(counter_value->value == 2);
+   const auto histogram_value =
+       std::ranges::find(delta.histograms, "test.delta_ms", &HistogramValue::name);
+   REQUIRE(histogram_value != delta.histograms.end());
+   REQUIRE(histogram_value->data.count == 2);
+   REQUIRE(histogram_value->mean() == 7.0);
+   REQUIRE(delta.to_string().find("test.delta 2") != std::string::npos);
+}
+// NOLINTEND
@@ -0,0 +1,65 @@
+#include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "core/mpmc_queue.h"
+
+// because of catch2
+// NOLINTBEGIN (cppcoreguidelines-avoid-do-while)
+TEST_CASE("MPMC queue keeps FIFO order and its bound", "[async]")
+{
+   meddl::async::MpmcQueue<int> queue(3);
+   REQUIRE(queue.capacity() == 4);
+   REQUIRE_FALSE(queue.try_pop());
+   for (int i = 0; i < 4; i++) {
+      REQUIRE(queue.try_push(i));
+   }
+   REQUIRE_FALSE(queue.try_push(4));
+   REQUIRE(queue.size_approx() == 4);
+   for (int i = 0; i < 4; i++) {
+      REQUIRE(queue.try_pop() == i);
+   }
+   REQUIRE_FALSE(queue.try_pop());
+}
+
+TEST_CASE("MPMC queue hands every value over exactly once", "[async]")
+{
+   constexpr int PRODUCERS = 4;
+   constexpr int CONSUMERS = 4;
+   constexpr int PER_PRODUCER = 20000;
+   meddl::async::MpmcQueue<uint64_t> queue(128);
+   std::atomic<uint64_t> sum{0};
+   std::atomic<int> popped{0};
+
+   std::vector<std::jthread> threads;
+   for (int p = 0; p < PRODUCERS; p++) {
+      threads.emplace_back([&queue] {
+         for (uint64_t i = 1; i <= PER_PRODUCER; i++) {
+            while (!queue.try_push(i)) {
+               std::this_thread::yield();
+            }
+         }
+      });
+   }
+   for (int c = 0; c < CONSUMERS; c++) {
+      threads.emplace_back([&] {
+         while (popped.load() < PRODUCERS * PER_PRODUCER) {
+            if (auto value = queue.try_pop()) {
+               sum += *value;
+               popped++;
+            }
+            else {
+               std::this_thread::yield();
+            }
+         }
+      });
+   }
+   threads.clear();
+
+   constexpr uint64_t EXPECTED = PRODUCERS * (uint64_t{PER_PRODUCER} * (PER_PRODUCER + 1) / 2);
+   REQUIRE(popped == PRODUCERS * PER_PRODUCER);
+   REQUIRE(sum == EXPECTED);
+}
+// NOLINTEND
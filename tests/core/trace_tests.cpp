@@ -0,0 +1,104 @@
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "core/trace.h"
+
+using meddl::trace::Event;
+using meddl::trace::Track;
+
+namespace {
+size_t count(const meddl::trace::Snapshot& snapshot, std::string_view name)
+{
+   return std::ranges::count(snapshot.events, name, &Event::name);
+}
+}  // namespace
+
+// because of catch2
+// NOLINTBEGIN (cppcoreguidelines-avoid-do-while)
+TEST_CASE("Trace scopes are recorded per thread", "[trace]")
+{
+   meddl::trace::clear();
+   meddl::trace::record("main_event", "test", 100, 200);
+   std::thread worker([] {
+      meddl::trace::set_thread_name("Worker");
+      for (int i = 0; i < 10; i++) {
+         meddl::trace::record("worker_event", "test", 300, 400);
+      }
+   });
+   worker.join();
+
+   const auto snapshot = meddl::trace::snapshot();
+   REQUIRE(count(snapshot, "main_event") == 1);
+   REQUIRE(count(snapshot, "worker_event") == 10);
+
+   const auto worker_event = std::ranges::find(snapshot.events, "worker_event", &Event::name);
+   const auto main_event = std::ranges::find(snapshot.events, "main_event", &Event::name);
+   REQUIRE(worker_event->track != main_event->track);
+   const auto track = std::ranges::find(snapshot.tracks, worker_event->track, &Track::id);
+   REQUIRE(track != snapshot.tracks.end());
+   REQUIRE(track->name == "Worker");
+
+   meddl::trace::clear();
+   REQUIRE(meddl::trace::snapshot().events.empty());
+}
+
+TEST_CASE("Trace rings keep the newest events", "[trace]")
+{
+   meddl::trace::clear();
+   std::thread worker([] {
+      meddl::trace::record("oldest", "test", 0, 1);
+      for (uint32_t i = 0; i < meddl::trace::RING_CAPACITY; i++) {
+         meddl::trace::record("newer", "test", i, i + 1);
+      }
+   });
+   worker.join();
+
+   const auto snapshot = meddl::trace::snapshot();
+   REQUIRE(count(snapshot, "oldest") == 0);
+   REQUIRE(count(snapshot, "newer") == meddl::trace::RING_CAPACITY);
+}
+
+TEST_CASE("Trace snapshots never tear events a writer is recording", "[trace]")
+{
+   meddl::trace::clear();
+   std::atomic<bool> done{false};
+   std::thread worker([&done] {
+      for (uint64_t i = 0; i < 4 * uint64_t{meddl::trace::RING_CAPACITY}; i++) {
+         meddl::trace::record(i % 2 == 0 ? "even" : "odd", "test", i, i + 1);
+      }
+      done = true;
+   });
+
+   bool consistent = true;
+   while (!done) {
+      for (const auto& event : meddl::trace::snapshot().events) {
+         const auto even = std::string_view(event.name) == "even";
+         consistent &= event.end_ns == event.start_ns + 1 && even == (event.start_ns % 2 == 0);
+      }
+   }
+   worker.join();
+   REQUIRE(consistent);
+   meddl::trace::clear();
+}
+
+TEST_CASE("Trace export is Chrome trace JSON", "[trace]")
+{
+   meddl::trace::Snapshot snapshot;
+   snapshot.tracks.push_back({.id = 3, .name = "Render"});
+   snapshot.events.push_back(
+       {.name = "say \"hi\"", .category = "render", .start_ns = 1000, .end_ns = 3500, .track = 3});
+
+   const auto json = meddl::trace::to_chrome_json(snapshot);
+   REQUIRE(json.starts_with(R"({"displayTimeUnit":"ms","traceEvents":[)"));
+   REQUIRE(json.find(R"("name":"thread_name","ph":"M","pid":1,"tid":3,"args":{"name":"Render"})") !=
+           std::string::npos);
+   REQUIRE(json.find(R"("name":"say \"hi\"","cat":"render","ph":"X","pid":1,"tid":3)") !=
+           std::string::npos);
+   REQUIRE(json.find(R"("ts":0.000,"dur":2.500)") != std::string::npos);
+}
+// NOLINTEND (cppcoreguidelines-avoid-do-while)
@@ -0,0 +1,77 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "core/triple_buffer.h"
+
+// because of catch2
+// NOLINTBEGIN (cppcoreguidelines-avoid-do-while)
+TEST_CASE("Triple buffer hands over the newest value", "[async]")
+{
+   meddl::async::TripleBuffer<int> mailbox;
+
+   SECTION("Nothing to read before the first publish")
+   {
+      REQUIRE_FALSE(mailbox.update());
+   }
+
+   SECTION("Unread values are overwritten")
+   {
+      mailbox.write_buffer() = 1;
+      mailbox.publish();
+      mailbox.write_buffer() = 2;
+      mailbox.publish();
+      REQUIRE(mailbox.update());
+      REQUIRE(mailbox.read_buffer() == 2);
+      REQUIRE_FALSE(mailbox.update());
+      REQUIRE(mailbox.read_buffer() == 2);
+   }
+
+   SECTION("Writer and reader never share a slot")
+   {
+      for (int i = 0; i < 10; i++) {
+         mailbox.write_buffer() = i;
+         mailbox.publish();
+         REQUIRE(mailbox.update());
+         REQUIRE(&mailbox.read_buffer() != &mailbox.write_buffer());
+         REQUIRE(mailbox.read_buffer() == i);
+      }
+   }
+}
+
+TEST_CASE("Triple buffer across threads", "[async]")
+{
+   struct Snapshot {
+      uint64_t frame{0};
+      std::vector<uint64_t> values{};
+   };
+   meddl::async::TripleBuffer<Snapshot> mailbox;
+   constexpr uint64_t FRAMES = 10000;
+   bool consistent = true;
+
+   std::thread reader([&] {
+      uint64_t last = 0;
+      while (last < FRAMES) {
+         mailbox.wait();
+         mailbox.update();
+         const auto& snapshot = mailbox.read_buffer();
+         // Frames only move forward and a snapshot is never seen half written
+         consistent &= snapshot.frame > last;
+         for (auto value : snapshot.values) {
+            consistent &= value == snapshot.frame;
+         }
+         last = snapshot.frame;
+      }
+   });
+
+   for (uint64_t frame = 1; frame <= FRAMES; frame++) {
+      auto& snapshot = mailbox.write_buffer();
+      snapshot.frame = frame;
+      snapshot.values.assign(16, frame);
+      mailbox.publish();
+   }
+   reader.join();
+   REQUIRE(consistent);
+}
+// NOLINTEND (cppcoreguidelines-avoid-do-while)
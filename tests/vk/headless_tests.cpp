@@ -0,0 +1,543 @@
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <string>
+
+#include "engine/render/vk/async_compute.h"
+#include "engine/render/vk/render_graph.h"
+#include "engine/renderer.h"
+#include "glm/gtc/matrix_transform.hpp"
+
+using meddl::DrawObject;
+using meddl::render::FrameReadback;
+using meddl::render::Renderer;
+using meddl::render::vk::AsyncCompute;
+using meddl::render::vk::AttachmentSet;
+using meddl::render::vk::Buffer;
+using meddl::render::vk::BufferHandoff;
+using meddl::render::vk::CommandBuffer;
+using meddl::render::vk::CommandPool;
+using meddl::render::vk::DepthPyramid;
+using meddl::render::vk::DescriptorSetLayout;
+using meddl::render::vk::Device;
+using meddl::render::vk::Fence;
+using meddl::render::vk::GpuCulling;
+using meddl::render::vk::GpuProfiler;
+using meddl::render::vk::GraphicsConfiguration;
+using meddl::render::vk::Image;
+using meddl::render::vk::PipelineLayout;
+using meddl::render::vk::QueueFamilyType;
+using meddl::render::vk::RenderGraph;
+using meddl::render::vk::ResourceUsage;
+using meddl::render::vk::TransientImageDesc;
+
+namespace {
+constexpr uint32_t WIDTH = 64;
+constexpr uint32_t HEIGHT = 48;
+// Renderer clear color 0.2 in an 8 bit UNORM target
+constexpr uint8_t CLEAR = 51;
+
+const uint8_t* pixel(const FrameReadback& frame, uint32_t x, uint32_t y)
+{
+   return &frame.pixels.at((static_cast<size_t>(y) * frame.width + x) * frame.bytes_per_pixel());
+}
+
+bool is_clear(const uint8_t* texel)
+{
+   return texel[0] == CLEAR && texel[1] == CLEAR && texel[2] == CLEAR && texel[3] == 255;
+}
+
+//! Records with record on the graphics queue, submits and waits for the GPU to finish
+//! With wait, the submit waits on that semaphore at wait_stage first
+template <typename F>
+void submit_and_wait(Device* device,
+                     F&& record,
+                     VkSemaphore wait = VK_NULL_HANDLE,
+                     VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT)
+{
+   const auto& queue = device->queue(QueueFamilyType::Graphics);
+   auto pool = CommandPool::create(device, queue.family_index());
+   REQUIRE(pool.has_value());
+   auto cmd = CommandBuffer::create(device, &pool.value());
+   REQUIRE(cmd.has_value());
+   REQUIRE(cmd->begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT).has_value());
+   record(cmd.value());
+   REQUIRE(cmd->end().has_value());
+
+   VkCommandBuffer handle = cmd->vk();
+   VkSubmitInfo submit{};
+   submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+   submit.commandBufferCount = 1;
+   submit.pCommandBuffers = &handle;
+   if (wait != VK_NULL_HANDLE) {
+      submit.waitSemaphoreCount = 1;
+      submit.pWaitSemaphores = &wait;
+      submit.pWaitDstStageMask = &wait_stage;
+   }
+   Fence fence(device);
+   fence.reset(device);
+   REQUIRE(vkQueueSubmit(queue.vk(), 1, &submit, fence.vk()) == VK_SUCCESS);
+   fence.wait(device);
+}
+
+void memory_barrier(const CommandBuffer& cmd,
+                    VkPipelineStageFlags src_stage,
+                    VkAccessFlags src_access,
+                    VkPipelineStageFlags dst_stage,
+                    VkAccessFlags dst_access)
+{
+   VkMemoryBarrier barrier{};
+   barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+   barrier.srcAccessMask = src_access;
+   barrier.dstAccessMask = dst_access;
+   vkCmdPipelineBarrier(cmd.vk(), src_stage, dst_stage, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+//! Host visible copy of src, written by compute shaders before the copy
+void copy_for_readback(const CommandBuffer& cmd, VkBuffer src, const Buffer& dst)
+{
+   memory_barrier(cmd,
+                  VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                  VK_ACCESS_SHADER_WRITE_BIT,
+                  VK_PIPELINE_STAGE_TRANSFER_BIT,
+                  VK_ACCESS_TRANSFER_READ_BIT);
+   const VkBufferCopy region{.srcOffset = 0, .dstOffset = 0, .size = dst.size()};
+   vkCmdCopyBuffer(cmd.vk(), src, dst.vk(), 1, &region);
+   memory_barrier(cmd,
+                  VK_PIPELINE_STAGE_TRANSFER_BIT,
+                  VK_ACCESS_TRANSFER_WRITE_BIT,
+                  VK_PIPELINE_STAGE_HOST_BIT,
+                  VK_ACCESS_HOST_READ_BIT);
+}
+
+Buffer readback_buffer(Device* device, VkDeviceSize size)
+{
+   Buffer buffer(device,
+                 size,
+                 VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+   buffer.map();
+   return buffer;
+}
+}  // namespace
+
+// The test shaders draw a triangle over the center of the target
+// NOLINTBEGIN (cppcoreguidelines-avoid-do-while)
+TEST_CASE("Headless renderer reads back frames", "[headless]")
+{
+   auto renderer = Renderer::headless(WIDTH, HEIGHT);
+   REQUIRE(renderer.is_headless());
+   REQUIRE_THROWS_AS(renderer.read_frame(), std::runtime_error);
+
+   renderer.draw();
+   const auto frame = renderer.read_frame();
+   REQUIRE(frame.width == WIDTH);
+   REQUIRE(frame.height == HEIGHT);
+   REQUIRE(frame.bytes_per_pixel() == 4);
+   REQUIRE(frame.pixels.size() == static_cast<size_t>(WIDTH) * HEIGHT * 4);
+
+   REQUIRE(is_clear(pixel(frame, 0, 0)));
+   REQUIRE(is_clear(pixel(frame, WIDTH - 1, HEIGHT - 1)));
+   REQUIRE_FALSE(is_clear(pixel(frame, WIDTH / 2, HEIGHT / 2)));
+}
+
+TEST_CASE("Headless renderer with a render thread", "[headless]")
+{
+   meddl::render::render_config config;
+   config.render_thread = true;
+   auto renderer = Renderer::headless(WIDTH, HEIGHT, config);
+
+   // Every read waits for the draw before it, not just any finished frame
+   for (int i = 0; i < 3; i++) {
+      renderer.draw();
+      const auto frame = renderer.read_frame();
+      REQUIRE(is_clear(pixel(frame, 0, 0)));
+      REQUIRE_FALSE(is_clear(pixel(frame, WIDTH / 2, HEIGHT / 2)));
+   }
+}
+
+TEST_CASE("Render thread skips draws replaced in the mailbox", "[headless]")
+{
+   meddl::render::render_config config;
+   config.render_thread = true;
+   auto renderer = Renderer::headless(WIDTH, HEIGHT, config);
+
+   // Faster than the render thread, some frames are never picked up
+   for (int i = 0; i < 16; i++) {
+      renderer.draw();
+   }
+   const auto frame = renderer.read_frame();
+   REQUIRE(is_clear(pixel(frame, 0, 0)));
+   REQUIRE_FALSE(is_clear(pixel(frame, WIDTH / 2, HEIGHT / 2)));
+}
+
+TEST_CASE("GPU culling compacts the visible objects", "[headless][culling]")
+{
+   auto renderer = Renderer::headless(WIDTH, HEIGHT);
+   auto* device = renderer.device();
+   auto culling = GpuCulling::create(device, 8);
+   REQUIRE(culling.has_value());
+
+   // Looking down -z: two objects ahead, one behind the camera and one far to the side
+   const std::array<DrawObject, 4> objects = {
+       DrawObject{.bounding_sphere = {0.0f, 0.0f, -5.0f, 1.0f},
+                  .index_count = 3,
+                  .first_index = 0,
+                  .vertex_offset = 0,
+                  .instance_index = 10},
+       DrawObject{.bounding_sphere = {0.0f, 0.0f, 5.0f, 1.0f},
+                  .index_count = 6,
+                  .first_index = 3,
+                  .vertex_offset = 4,
+                  .instance_index = 11},
+       DrawObject{.bounding_sphere = {100.0f, 0.0f, -5.0f, 1.0f},
+                  .index_count = 9,
+                  .first_index = 6,
+                  .vertex_offset = 0,
+                  .instance_index = 12},
+       DrawObject{.bounding_sphere = {1.0f, 0.0f, -10.0f, 1.0f},
+                  .index_count = 12,
+                  .first_index = 9,
+                  .vertex_offset = 8,
+                  .instance_index = 13}};
+   culling->set_objects(objects);
+   const auto projection = glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, 100.0f);
+   const auto view = glm::lookAt(
+       glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+   culling->update_frustum(projection * view);
+
+   auto count = readback_buffer(device, sizeof(uint32_t));
+   auto commands = readback_buffer(device, sizeof(VkDrawIndexedIndirectCommand) * objects.size());
+   submit_and_wait(device, [&](CommandBuffer& cmd) {
+      REQUIRE(culling->record(&cmd).has_value());
+      copy_for_readback(cmd, culling->draw_count(), count);
+      copy_for_readback(cmd, culling->draw_commands(), commands);
+   });
+
+   uint32_t draw_count = 0;
+   std::memcpy(&draw_count, count.mapped_data(), sizeof(draw_count));
+   REQUIRE(draw_count == 2);
+   std::array<VkDrawIndexedIndirectCommand, 2> drawn{};
+   std::memcpy(drawn.data(), commands.mapped_data(), sizeof(drawn));
+   // Survivors are appended in whatever order their invocations ran
+   std::ranges::sort(drawn, {}, &VkDrawIndexedIndirectCommand::firstInstance);
+   REQUIRE(drawn[0].indexCount == 3);
+   REQUIRE(drawn[0].instanceCount == 1);
+   REQUIRE(drawn[0].firstIndex == 0);
+   REQUIRE(drawn[0].vertexOffset == 0);
+   REQUIRE(drawn[0].firstInstance == 10);
+   REQUIRE(drawn[1].indexCount == 12);
+   REQUIRE(drawn[1].instanceCount == 1);
+   REQUIRE(drawn[1].firstIndex == 9);
+   REQUIRE(drawn[1].vertexOffset == 8);
+   REQUIRE(drawn[1].firstInstance == 13);
+}
+
+TEST_CASE("Async compute hands culling results to the graphics queue", "[headless][culling]")
+{
+   auto renderer = Renderer::headless(WIDTH, HEIGHT);
+   auto* device = renderer.device();
+   auto compute = AsyncCompute::create(device, 2);
+   REQUIRE(compute.has_value());
+   auto culling = GpuCulling::create(device, 8);
+   REQUIRE(culling.has_value());
+
+   // One object ahead of the camera, one behind it
+   const std::array<DrawObject, 2> objects = {
+       DrawObject{.bounding_sphere = {0.0f, 0.0f, -5.0f, 1.0f},
+                  .index_count = 3,
+                  .first_index = 0,
+                  .vertex_offset = 0,
+                  .instance_index = 7},
+       DrawObject{.bounding_sphere = {0.0f, 0.0f, 5.0f, 1.0f},
+                  .index_count = 6,
+                  .first_index = 3,
+                  .vertex_offset = 4,
+                  .instance_index = 8}};
+   culling->set_objects(objects);
+   const auto projection = glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, 100.0f);
+   const auto view = glm::lookAt(
+       glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+   culling->update_frustum(projection * view);
+
+   // Graphics only copies them here, a frame would draw from them instead
+   const std::array<BufferHandoff, 2> handoffs = {
+       BufferHandoff{.buffer = culling->draw_commands(),
+                     .dst_stage = VK_PIPELINE_STAGE_TRANSFER_BIT,
+                     .dst_access = VK_ACCESS_TRANSFER_READ_BIT},
+       BufferHandoff{.buffer = culling->draw_count(),
+                     .dst_stage = VK_PIPELINE_STAGE_TRANSFER_BIT,
+                     .dst_access = VK_ACCESS_TRANSFER_READ_BIT}};
+   auto cmd = compute->begin(0);
+   REQUIRE(cmd.has_value());
+   REQUIRE(culling->record(cmd.value()).has_value());
+   REQUIRE(compute->submit(handoffs).has_value());
+
+   auto count = readback_buffer(device, sizeof(uint32_t));
+   auto commands = readback_buffer(device, sizeof(VkDrawIndexedIndirectCommand));
+   submit_and_wait(
+       device,
+       [&](CommandBuffer& graphics) {
+          REQUIRE(compute->acquire(&graphics, handoffs).has_value());
+          copy_for_readback(graphics, culling->draw_count(), count);
+          copy_for_readback(graphics, culling->draw_commands(), commands);
+       },
+       compute->semaphore(0),
+       AsyncCompute::wait_stage(handoffs));
+   // The compute fence, destroyed with compute
+   REQUIRE(vkDeviceWaitIdle(device->vk()) == VK_SUCCESS);
+
+   uint32_t draw_count = 0;
+   std::memcpy(&draw_count, count.mapped_data(), sizeof(draw_count));
+   REQUIRE(draw_count == 1);
+   VkDrawIndexedIndirectCommand drawn{};
+   std::memcpy(&drawn, commands.mapped_data(), sizeof(drawn));
+   REQUIRE(drawn.indexCount == 3);
+   REQUIRE(drawn.firstInstance == 7);
+}
+
+TEST_CASE("Depth pyramid reduces a depth stencil attachment", "[headless][culling]")
+{
+   auto renderer = Renderer::headless(WIDTH, HEIGHT);
+   auto* device = renderer.device();
+   // Combined formats have a depth/stencil attachment view, the pyramid must read depth only
+   GraphicsConfiguration::AttachmentConfig depth_config{
+       .format = VK_FORMAT_D32_SFLOAT_S8_UINT,
+       .is_depth_stencil = true,
+       .additional_usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT};
+   auto depth = Image::create(device, depth_config, WIDTH, HEIGHT);
+   auto pyramid = DepthPyramid::create(device, {WIDTH, HEIGHT});
+   REQUIRE(pyramid.has_value());
+   REQUIRE(pyramid->extent().width == 32);
+   REQUIRE(pyramid->extent().height == 32);
+   REQUIRE(pyramid->levels() == 6);
+
+   constexpr float DEPTH = 0.25f;
+   auto top = readback_buffer(device, sizeof(float));
+   submit_and_wait(device, [&](CommandBuffer& cmd) {
+      const VkImageSubresourceRange range = {
+          .aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT,
+          .baseMipLevel = 0,
+          .levelCount = 1,
+          .baseArrayLayer = 0,
+          .layerCount = 1};
+      VkImageMemoryBarrier to_clear{};
+      to_clear.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+      to_clear.srcAccessMask = 0;
+      to_clear.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+      to_clear.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+      to_clear.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+      to_clear.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      to_clear.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      to_clear.image = depth.vk();
+      to_clear.subresourceRange = range;
+      vkCmdPipelineBarrier(cmd.vk(),
+                           VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                           VK_PIPELINE_STAGE_TRANSFER_BIT,
+                           0,
+                           0,
+                           nullptr,
+                           0,
+                           nullptr,
+                           1,
+                           &to_clear);
+      const VkClearDepthStencilValue clear = {.depth = DEPTH, .stencil = 0};
+      vkCmdClearDepthStencilImage(
+          cmd.vk(), depth.vk(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clear, 1, &range);
+
+      // As if the depth pass had just written it
+      VkImageMemoryBarrier to_attachment = to_clear;
+      to_attachment.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+      to_attachment.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+                                    VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+      to_attachment.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+      to_attachment.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+      vkCmdPipelineBarrier(cmd.vk(),
+                           VK_PIPELINE_STAGE_TRANSFER_BIT,
+                           VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+                               VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                           0,
+                           0,
+                           nullptr,
+                           0,
+                           nullptr,
+                           1,
+                           &to_attachment);
+
+      REQUIRE(pyramid->build(&cmd, depth).has_value());
+
+      memory_barrier(cmd,
+                     VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                     VK_ACCESS_SHADER_WRITE_BIT,
+                     VK_PIPELINE_STAGE_TRANSFER_BIT,
+                     VK_ACCESS_TRANSFER_READ_BIT);
+      const VkBufferImageCopy region = {
+          .bufferOffset = 0,
+          .bufferRowLength = 0,
+          .bufferImageHeight = 0,
+          .imageSubresource = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                               .mipLevel = pyramid->levels() - 1,
+                               .baseArrayLayer = 0,
+                               .layerCount = 1},
+          .imageOffset = {0, 0, 0},
+          .imageExtent = {1, 1, 1}};
+      vkCmdCopyImageToBuffer(
+          cmd.vk(), pyramid->image(), VK_IMAGE_LAYOUT_GENERAL, top.vk(), 1, &region);
+      memory_barrier(cmd,
+                     VK_PIPELINE_STAGE_TRANSFER_BIT,
+                     VK_ACCESS_TRANSFER_WRITE_BIT,
+                     VK_PIPELINE_STAGE_HOST_BIT,
+                     VK_ACCESS_HOST_READ_BIT);
+   });
+
+   float farthest = 0.0f;
+   std::memcpy(&farthest, top.mapped_data(), sizeof(farthest));
+   REQUIRE(farthest == DEPTH);
+}
+
+TEST_CASE("Attachment set packs attachments with disjoint lifetimes", "[headless][attachments]")
+{
+   auto renderer = Renderer::headless(WIDTH, HEIGHT);
+   // Not presented, so none of them is backed by the swapchain
+   const auto attachment = [](uint32_t first_pass, uint32_t last_pass) {
+      return GraphicsConfiguration::AttachmentConfig{
+          .format = VK_FORMAT_R8G8B8A8_UNORM,
+          .final_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+          .first_pass = first_pass,
+          .last_pass = last_pass};
+   };
+   GraphicsConfiguration::Shared shared;
+   shared.attachments = {attachment(0, 0), attachment(1, 1), attachment(0, 1)};
+
+   auto set = AttachmentSet::create(renderer.device(), shared.attachments, WIDTH, HEIGHT);
+   REQUIRE(set.has_value());
+   const auto& stats = set->stats();
+   // The first two share one allocation, the third is live during both
+   REQUIRE(stats.allocations == 2);
+   REQUIRE(stats.lazy_attachments == 0);
+   REQUIRE(stats.allocated_bytes * 3 == stats.requested_bytes * 2);
+   REQUIRE(set->image(0)->memory() == set->image(1)->memory());
+   REQUIRE(set->image(0)->memory() != set->image(2)->memory());
+
+   const auto descriptions = shared.get_attachment_descriptions();
+   REQUIRE(descriptions[0].flags == VK_ATTACHMENT_DESCRIPTION_MAY_ALIAS_BIT);
+   REQUIRE(descriptions[1].flags == VK_ATTACHMENT_DESCRIPTION_MAY_ALIAS_BIT);
+   REQUIRE(descriptions[2].flags == 0);
+}
+
+TEST_CASE("Render graph culls passes whose output is never read", "[headless][render_graph]")
+{
+   auto renderer = Renderer::headless(WIDTH, HEIGHT);
+   const TransientImageDesc desc{.extent = {WIDTH, HEIGHT}};
+   RenderGraph graph;
+   const auto target = graph.import_image("target",
+                                          VK_NULL_HANDLE,
+                                          VK_NULL_HANDLE,
+                                          VK_IMAGE_ASPECT_COLOR_BIT,
+                                          VK_IMAGE_LAYOUT_UNDEFINED);
+   const auto unused = graph.create_image("unused", desc);
+   const auto shadow = graph.create_image("shadow", desc);
+   const auto noop = [](CommandBuffer&, const RenderGraph&) {};
+
+   graph.add_pass("unused", noop).write(unused, ResourceUsage::ColorAttachment);
+   graph.add_pass("shadow", noop).write(shadow, ResourceUsage::ColorAttachment);
+   // Fully overwritten by forward, which doesn't read the target
+   graph.add_pass("clear", noop).write(target, ResourceUsage::TransferDst);
+   graph.add_pass("forward", noop)
+       .read(shadow, ResourceUsage::SampledFragment)
+       .write(target, ResourceUsage::ColorAttachment);
+   REQUIRE(graph.compile(renderer.device()).has_value());
+
+   REQUIRE(graph.is_culled("unused"));
+   REQUIRE(graph.is_culled("clear"));
+   REQUIRE_FALSE(graph.is_culled("shadow"));
+   REQUIRE_FALSE(graph.is_culled("forward"));
+   REQUIRE(graph.stats().culled_passes == 2);
+   // Only used by culled passes, never created
+   REQUIRE(graph.image(unused) == VK_NULL_HANDLE);
+   REQUIRE(graph.image(shadow) != VK_NULL_HANDLE);
+}
+
+TEST_CASE("Render graph synchronizes a write and its reads once", "[headless][render_graph]")
+{
+   auto renderer = Renderer::headless(WIDTH, HEIGHT);
+   const TransientImageDesc desc{.extent = {WIDTH, HEIGHT}};
+   RenderGraph graph;
+   const auto first = graph.create_image("first", desc);
+   const auto second = graph.create_image("second", desc);
+   const auto noop = [](CommandBuffer&, const RenderGraph&) {};
+
+   graph.add_pass("write first", noop).write(first, ResourceUsage::StorageWrite);
+   graph.add_pass("read first", noop).read(first, ResourceUsage::StorageRead).side_effects();
+   // Already sees the write
+   graph.add_pass("read first again", noop).read(first, ResourceUsage::StorageRead).side_effects();
+   graph.add_pass("write second", noop).write(second, ResourceUsage::StorageWrite);
+   graph.add_pass("read second", noop).read(second, ResourceUsage::StorageRead).side_effects();
+   REQUIRE(graph.compile(renderer.device()).has_value());
+
+   // Per image, the transition from UNDEFINED and one barrier between the write and the reads
+   const auto& stats = graph.stats();
+   REQUIRE(stats.culled_passes == 0);
+   REQUIRE(stats.barriers == 4);
+   REQUIRE(stats.barrier_batches == 4);
+   // Disjoint lifetimes, both images share one allocation
+   REQUIRE(stats.allocated_bytes * 2 == stats.transient_bytes);
+
+   submit_and_wait(renderer.device(), [&](CommandBuffer& cmd) {
+      REQUIRE(graph.execute(&cmd).has_value());
+   });
+}
+
+TEST_CASE("Push constants follow the stages of the ranges they touch", "[headless][pipeline]")
+{
+   auto renderer = Renderer::headless(WIDTH, HEIGHT);
+   auto* device = renderer.device();
+   const std::array<VkPushConstantRange, 2> ranges = {
+       VkPushConstantRange{.stageFlags = VK_SHADER_STAGE_VERTEX_BIT, .offset = 0, .size = 16},
+       VkPushConstantRange{.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT, .offset = 0, .size = 32}};
+   const std::span<const DescriptorSetLayout* const> no_sets{};
+   auto layout = PipelineLayout::create(device, no_sets, ranges);
+   REQUIRE(layout.has_value());
+
+   const std::array<VkPushConstantRange, 2> repeated = {
+       ranges[0],
+       VkPushConstantRange{.stageFlags = VK_SHADER_STAGE_VERTEX_BIT, .offset = 16, .size = 16}};
+   REQUIRE_FALSE(PipelineLayout::create(device, no_sets, repeated).has_value());
+
+   const std::array<uint32_t, 8> data{};
+   constexpr auto BOTH = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+   submit_and_wait(device, [&](CommandBuffer& cmd) {
+      // Both ranges overlap the first 16 bytes, each covers them
+      REQUIRE(cmd.push_constants(*layout, BOTH, 0, 16, data.data()).has_value());
+      REQUIRE_FALSE(cmd.push_constants(*layout, VK_SHADER_STAGE_VERTEX_BIT, 0, 16, data.data())
+                        .has_value());
+      // Only the fragment range reaches past 16 bytes
+      REQUIRE(cmd.push_constants(*layout, VK_SHADER_STAGE_FRAGMENT_BIT, 16, 16, data.data())
+                  .has_value());
+      REQUIRE_FALSE(cmd.push_constants(*layout, BOTH, 0, 32, data.data()).has_value());
+   });
+}
+
+TEST_CASE("GPU profiler times the frame", "[headless][profiler]")
+{
+   meddl::render::render_config config;
+   config.gpu_profiling = true;
+   auto renderer = Renderer::headless(WIDTH, HEIGHT, config);
+
+   // Results are collected when the frame slot comes around again
+   for (int i = 0; i < 4; i++) {
+      renderer.draw();
+   }
+   const auto timings = renderer.gpu_timings();
+   const auto frame = std::ranges::find(timings, "frame", &GpuProfiler::RegionStats::name);
+   REQUIRE(frame != timings.end());
+   REQUIRE(frame->samples > 0);
+   REQUIRE(frame->depth == 0);
+   REQUIRE(frame->p50_ms <= frame->max_ms);
+   REQUIRE(renderer.trace_json().find(R"("name":"frame")") != std::string::npos);
+}
+// NOLINTEND (cppcoreguidelines-avoid-do-while)